@@ -10,8 +10,18 @@
 #include <VisFordFulkerson.hpp>
 #include <VisMinimumCostConstantFlowNC.hpp>
 #include <VisMinimumCostConstantFlowSP.hpp>
+#include <VisImporter.hpp>
+#include <VisExporter.hpp>
+#include <VisResultWriter.hpp>
 
 #include <QtDebug>
+#include <QThread>
+#include <QCoreApplication>
+#include <QFileInfo>
+#include <QDir>
+#include <QVector>
+
+#include <cstring>
 
 #define SCM_DEFUNC(NAME, ARGS, PROC) scm_c_define_gsubr(NAME, ARGS, 0, 0, ((scm_t_subr) PROC ))
 
@@ -35,6 +45,24 @@ int scmToInt(SCM i)
     return scm_to_int(i);
 }
 
+SCM scmFromInts(const QVector<qint32>& values)
+{
+    SCM vector = scm_make_s32vector(scm_from_size_t(values.size()), scm_from_int32(0));
+    scm_t_array_handle handle;
+    size_t  length;
+    ssize_t increment;
+    scm_t_int32* elements = scm_s32vector_writable_elements(vector, &handle, &length, &increment);
+    memcpy(elements, values.constData(), length*sizeof(scm_t_int32));
+    scm_array_handle_release(&handle);
+    return vector;
+}
+
+// Literal de cadena de Scheme
+QString scmQuote(QString text)
+{
+    return QString("\"") + text.replace("\\", "\\\\").replace("\"", "\\\"") + QString("\"");
+}
+
 double scmToDouble(SCM d)
 {
     return scm_to_double(d);
@@ -42,147 +70,258 @@ double scmToDouble(SCM d)
 
 SCM scmPaintNode(SCM id, SCM x, SCM y)
 {
-    env->visPaintNode(scmToInt(id), scmToDouble(x), scmToDouble(y));
+    VisChange change(VisChange::PAINT_NODE, scmToInt(id));
+    change.x = scmToDouble(x);
+    change.y = scmToDouble(y);
+    if(env->batchChange(change))
+        return SCM_UNSPECIFIED;
+
+    env->visPaintNode(change.aid, change.x, change.y);
     env->visIncrementId();
     return SCM_UNSPECIFIED;
 }
 
 SCM scmUnpaintNode(SCM id)
 {
-    env->visUnpaintNode(scmToInt(id));
+    VisChange change(VisChange::UNPAINT_NODE, scmToInt(id));
+    if(env->collectUnpaint(change) or env->batchChange(change))
+        return SCM_UNSPECIFIED;
+    env->visUnpaintNode(change.aid);
     return SCM_UNSPECIFIED;
 }
 
 SCM scmPaintEdge(SCM aid, SCM bid)
 {
-    env->visPaintEdge(scmToInt(aid), scmToInt(bid), env->with_curves);
+    VisChange change(VisChange::PAINT_EDGE, scmToInt(aid), scmToInt(bid));
+    change.with_curves = env->with_curves;
+    if(env->batchChange(change))
+        return SCM_UNSPECIFIED;
+
+    env->visPaintEdge(change.aid, change.bid, change.with_curves);
     return SCM_UNSPECIFIED;
 }
 
 SCM scmUnpaintEdge(SCM aid, SCM bid)
 {
-    env->visUnpaintEdge(scmToInt(aid), scmToInt(bid));
+    VisChange change(VisChange::UNPAINT_EDGE, scmToInt(aid), scmToInt(bid));
+    if(env->collectUnpaint(change) or env->batchChange(change))
+        return SCM_UNSPECIFIED;
+    env->visUnpaintEdge(change.aid, change.bid);
     return SCM_UNSPECIFIED;
 }
 
 SCM scmPaintArrow(SCM aid, SCM bid)
 {
-    env->visPaintArrow(scmToInt(aid), scmToInt(bid), env->with_curves);
+    VisChange change(VisChange::PAINT_ARROW, scmToInt(aid), scmToInt(bid));
+    change.with_curves = env->with_curves;
+    if(env->batchChange(change))
+        return SCM_UNSPECIFIED;
+
+    env->visPaintArrow(change.aid, change.bid, change.with_curves);
     return SCM_UNSPECIFIED;
 }
 
 SCM scmUnpaintArrow(SCM aid, SCM bid)
 {
-    env->visUnpaintArrow(scmToInt(aid), scmToInt(bid));
+    VisChange change(VisChange::UNPAINT_ARROW, scmToInt(aid), scmToInt(bid));
+    if(env->collectUnpaint(change) or env->batchChange(change))
+        return SCM_UNSPECIFIED;
+    env->visUnpaintArrow(change.aid, change.bid);
     return SCM_UNSPECIFIED;
 }
 
 SCM scmLabelNode(SCM id, SCM label)
 {
+    VisChange change(VisChange::LABEL_NODE, scmToInt(id));
+    change.text = scmToString(label);
+    if(env->batchChange(change))
+        return SCM_UNSPECIFIED;
+
     env->visLabelNode(scmToInt(id), scmToString(label));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmLabelEdge(SCM aid, SCM bid, SCM label)
 {
+    VisChange change(VisChange::LABEL_EDGE, scmToInt(aid), scmToInt(bid));
+    change.text = scmToString(label);
+    if(env->batchChange(change))
+        return SCM_UNSPECIFIED;
+
     env->visLabelEdge(scmToInt(aid), scmToInt(bid), scmToString(label));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmLabelArrow(SCM aid, SCM bid, SCM label)
 {
+    VisChange change(VisChange::LABEL_ARROW, scmToInt(aid), scmToInt(bid));
+    change.text = scmToString(label);
+    if(env->batchChange(change))
+        return SCM_UNSPECIFIED;
+
     env->visLabelArrow(scmToInt(aid), scmToInt(bid), scmToString(label));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmColorNode(SCM id, SCM r, SCM g, SCM b, SCM a)
 {
+    VisChange change(VisChange::COLOR_NODE, scmToInt(id));
+    change.color = QColor(scmToInt(r), scmToInt(g), scmToInt(b), scmToInt(a));
+    if(env->batchChange(change))
+        return SCM_UNSPECIFIED;
+
     env->visColorNode(scmToInt(id), scmToInt(r), scmToInt(g), scmToInt(b), scmToInt(a));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmUncolorNode(SCM id)
 {
+    if(env->batchChange(VisChange(VisChange::UNCOLOR_NODE, scmToInt(id))))
+        return SCM_UNSPECIFIED;
     env->visUncolorNode(scmToInt(id));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmColorEdge(SCM aid, SCM bid, SCM r, SCM g, SCM b, SCM a)
 {
+    VisChange change(VisChange::COLOR_EDGE, scmToInt(aid), scmToInt(bid));
+    change.color = QColor(scmToInt(r), scmToInt(g), scmToInt(b), scmToInt(a));
+    if(env->batchChange(change))
+        return SCM_UNSPECIFIED;
+
     env->visColorEdge(scmToInt(aid), scmToInt(bid), scmToInt(r), scmToInt(g), scmToInt(b), scmToInt(a));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmUncolorEdge(SCM aid, SCM bid)
 {
+    if(env->batchChange(VisChange(VisChange::UNCOLOR_EDGE, scmToInt(aid), scmToInt(bid))))
+        return SCM_UNSPECIFIED;
     env->visUncolorEdge(scmToInt(aid), scmToInt(bid));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmColorArrow(SCM aid, SCM bid, SCM r, SCM g, SCM b, SCM a)
 {
+    VisChange change(VisChange::COLOR_ARROW, scmToInt(aid), scmToInt(bid));
+    change.color = QColor(scmToInt(r), scmToInt(g), scmToInt(b), scmToInt(a));
+    if(env->batchChange(change))
+        return SCM_UNSPECIFIED;
+
     env->visColorArrow(scmToInt(aid), scmToInt(bid), scmToInt(r), scmToInt(g), scmToInt(b), scmToInt(a));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmUncolorArrow(SCM aid, SCM bid)
 {
+    if(env->batchChange(VisChange(VisChange::UNCOLOR_ARROW, scmToInt(aid), scmToInt(bid))))
+        return SCM_UNSPECIFIED;
     env->visUncolorArrow(scmToInt(aid), scmToInt(bid));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmColorNodeLabel(SCM id, SCM r, SCM g, SCM b, SCM a)
 {
+    VisChange change(VisChange::COLOR_NODE_LABEL, scmToInt(id));
+    change.color = QColor(scmToInt(r), scmToInt(g), scmToInt(b), scmToInt(a));
+    if(env->batchChange(change))
+        return SCM_UNSPECIFIED;
+
     env->visColorNodeLabel(scmToInt(id), scmToInt(r), scmToInt(g), scmToInt(b), scmToInt(a));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmUncolorNodeLabel(SCM id)
 {
+    if(env->batchChange(VisChange(VisChange::UNCOLOR_NODE_LABEL, scmToInt(id))))
+        return SCM_UNSPECIFIED;
     env->visUncolorNodeLabel(scmToInt(id));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmColorEdgeLabel(SCM aid, SCM bid, SCM r, SCM g, SCM b, SCM a)
 {
+    VisChange change(VisChange::COLOR_EDGE_LABEL, scmToInt(aid), scmToInt(bid));
+    change.color = QColor(scmToInt(r), scmToInt(g), scmToInt(b), scmToInt(a));
+    if(env->batchChange(change))
+        return SCM_UNSPECIFIED;
+
     env->visColorEdgeLabel(scmToInt(aid), scmToInt(bid), scmToInt(r), scmToInt(g), scmToInt(b), scmToInt(a));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmUncolorEdgeLabel(SCM aid, SCM bid)
 {
+    if(env->batchChange(VisChange(VisChange::UNCOLOR_EDGE_LABEL, scmToInt(aid), scmToInt(bid))))
+        return SCM_UNSPECIFIED;
     env->visUncolorEdgeLabel(scmToInt(aid), scmToInt(bid));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmColorArrowLabel(SCM aid, SCM bid, SCM r, SCM g, SCM b, SCM a)
 {
+    VisChange change(VisChange::COLOR_ARROW_LABEL, scmToInt(aid), scmToInt(bid));
+    change.color = QColor(scmToInt(r), scmToInt(g), scmToInt(b), scmToInt(a));
+    if(env->batchChange(change))
+        return SCM_UNSPECIFIED;
+
     env->visColorArrowLabel(scmToInt(aid), scmToInt(bid), scmToInt(r), scmToInt(g), scmToInt(b), scmToInt(a));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmUncolorArrowLabel(SCM aid, SCM bid)
 {
+    if(env->batchChange(VisChange(VisChange::UNCOLOR_ARROW_LABEL, scmToInt(aid), scmToInt(bid))))
+        return SCM_UNSPECIFIED;
     env->visUncolorArrowLabel(scmToInt(aid), scmToInt(bid));
     return SCM_UNSPECIFIED;
 }
 
 SCM scmWait(SCM message)
 {
+    env->vis_trace.step(scmToString(message));
+    // Lo dibujado hasta ahora debe verse mientras se espera
+    env->flushBatch();
+    VisSchemeExecutor::throwIfCancelled();
     env->on_pause = true;
     env->visStepWait(scmToString(message));
-    while(env->on_pause){
+    while(env->on_pause and not VisSchemeExecutor::cancelRequested()){
 
     }
+    // Un algoritmo detenido termina aqui, la excepcion la recoge su worker
+    env->on_pause = false;
+    VisSchemeExecutor::throwIfCancelled();
     return SCM_UNSPECIFIED;
 }
 
 SCM scmShowMessage(SCM message)
 {
+    env->vis_trace.step(scmToString(message));
     env->visShowMessage(scmToString(message));
     return SCM_UNSPECIFIED;
 }
 
+SCM scmClearGraph()
+{
+    // Los cambios pendientes se refieren a elementos que ya no existen
+    env->vis_trace.record(VisChange(VisChange::CLEAR_GRAPH));
+    env->discardBatch();
+    env->visClearGraph();
+    return SCM_UNSPECIFIED;
+}
+
+SCM scmBatchBegin()
+{
+    env->beginBatch();
+    return SCM_UNSPECIFIED;
+}
+
+SCM scmBatchCommit()
+{
+    env->commitBatch();
+    return SCM_UNSPECIFIED;
+}
+
 SCM scmReload(SCM file)
 {
     env->evalFile(scmToString(file));
@@ -208,6 +347,11 @@ void Environment::initForeign()
 {
     scm_init_guile();
 
+    // Los modulos (grafo ...) compilados tambien se instalan junto al ejecutable
+    evalString(QString("(set! %load-compiled-path (cons \"") +
+               QCoreApplication::applicationDirPath() +
+               QString("\" %load-compiled-path))"));
+
     evalFile("init.scm");
 
     SCM_DEFUNC("cpp-paint-node!", 3,          scmPaintNode);
@@ -233,14 +377,28 @@ void Environment::initForeign()
     SCM_DEFUNC("cpp-uncolor-arrow-label!", 2, scmUncolorArrowLabel);
     SCM_DEFUNC("cpp-wait!", 1,                scmWait);
     SCM_DEFUNC("cpp-show-message!", 1,        scmShowMessage);
+    SCM_DEFUNC("cpp-clear-graph!", 0,         scmClearGraph);
+    SCM_DEFUNC("cpp-batch-begin!", 0,         scmBatchBegin);
+    SCM_DEFUNC("cpp-batch-commit!", 0,        scmBatchCommit);
     SCM_DEFUNC("cpp-reload!", 1,              scmReload);
     SCM_DEFUNC("cpp-pos-node", 1,             scmPosNode);
     SCM_DEFUNC("cpp-move-node!", 3,           scmMoveNode);
+    VisResultWriter::defineProcedures();
 
     evalFile("vis-graph.scm");
 
     evalFile("algorithms.scm");
 
+    executor = new VisSchemeExecutor(scm_current_module(), algorithm_workers);
+    connect(executor, SIGNAL(visJobStarted(int)),
+            this,     SIGNAL(visAlgorithmStarted(int)));
+    connect(executor, SIGNAL(visJobFinished(int,int)),
+            this,     SIGNAL(visAlgorithmFinished(int,int)));
+    connect(executor, SIGNAL(visJobFinished(int,int)),
+            this,     SLOT(visForgetSnapshot(int,int)));
+    connect(executor, SIGNAL(visJobFinished(int,int)),
+            this,     SLOT(visEndTrace(int,int)));
+
     newGraph(vis_scene->graph_type);
 
     evalString("(spring)", true);
@@ -256,9 +414,45 @@ SCM Environment::evalString(QString code, bool with_thread)
 
 void Environment::evalFile(QString path)
 {
+    // El objeto compilado en la construccion esta junto al ejecutable; se
+    // usa mientras no sea mas viejo que la fuente
+    QFileInfo source(path);
+    QFileInfo compiled(QDir(QCoreApplication::applicationDirPath()).filePath(
+                           source.path() + "/" + source.completeBaseName() + ".go"));
+    if(compiled.exists() and compiled.lastModified() >= source.lastModified()){
+        scm_call_1(scm_variable_ref(scm_c_lookup("load-compiled")),
+                   scm_from_locale_string(compiled.filePath().toStdString().data()));
+        return;
+    }
     scm_c_primitive_load(path.toStdString().data());
 }
 
+void Environment::requireAlgorithm(QString name)
+{
+    // Se carga en este hilo antes de lanzar el algoritmo en el suyo
+    evalString(QString("(require-algorithm! \"") + name + QString("\")"));
+}
+
+void Environment::runAlgorithm(QString code)
+{
+    // La instantanea se toma en este hilo, el mismo que edita G, y el
+    // algoritmo la recibe con el nombre G. Una reproduccion abierta deja
+    // la escena en otro paso, se vuelve a G antes de grabar o dibujar
+    trace_player->close();
+    if(record_traces and not vis_trace.isRecording())
+        vis_trace.begin(vis_scene);
+
+    // El archivo de resultados se da solo a este trabajo
+    if(not results_path.isEmpty())
+        code = QString("(parameterize ((result-file ") + scmQuote(results_path) + QString(")) ") + code + QString(")");
+
+    int snapshot = next_snapshot++;
+    evalString(QString("(store-algorithm-snapshot! ") + QString::number(snapshot) + QString(")"));
+    int job = executor->submit(QString("(let ((G (take-algorithm-snapshot! ") + QString::number(snapshot) +
+                               QString("))) ") + code + QString(")"));
+    job_snapshots.insert(job, snapshot);
+}
+
 void Environment::newGraph(VisGraphicsScene::GRAPH type)
 {
     switch(type){
@@ -271,16 +465,175 @@ void Environment::newGraph(VisGraphicsScene::GRAPH type)
     }
 }
 
-void Environment::delGraph(VisGraphicsScene::GRAPH type, bool thread)
+void Environment::delGraph()
 {
-    switch(type){
-    case VisGraphicsScene::UNDIRECTED:
-        break;
-    case VisGraphicsScene::DIRECTED:
-        break;
-    }
+    // Scheme descarta sus tablas y la escena elimina todo de una vez
     evalString("(set! spring-movement #false)");
-    evalString("(for-each (lambda (v) (remove-vertex! G v)) (vertices G))", thread);
+    evalString("(clear-graph! G)");
+}
+
+void Environment::loadDocument(const VisDocument& document)
+{
+    visSetGraphType(document.directed() ? 1 : 0);
+    delGraph();
+    emit visResetId();
+    vis_scene->visLoadDocument(document);
+
+    // G recibe las curvas que la escena acepto, sin pasar por add-edge!
+    QVector<qint32> ids(document.nodeCount());
+    memcpy(ids.data(), document.ids, ids.size()*sizeof(qint32));
+
+    QVector<qint32> sources;
+    QVector<qint32> targets;
+    if(graphType() == VisGraphicsScene::DIRECTED){
+        sources.reserve(vis_scene->graph_arrows.size());
+        targets.reserve(vis_scene->graph_arrows.size());
+        foreach(VisArrow* arrow, vis_scene->graph_arrows.values()){
+            sources.append(arrow->a_id);
+            targets.append(arrow->b_id);
+        }
+    }else{
+        sources.reserve(vis_scene->graph_edges.size());
+        targets.reserve(vis_scene->graph_edges.size());
+        foreach(VisEdge* edge, vis_scene->graph_edges.values()){
+            sources.append(edge->a_id);
+            targets.append(edge->b_id);
+        }
+    }
+
+    scm_call_4(scm_variable_ref(scm_c_lookup("load-graph!")),
+               scm_variable_ref(scm_c_lookup("G")),
+               scmFromInts(ids), scmFromInts(sources), scmFromInts(targets));
+}
+
+bool Environment::saveDocument(QString path, QString* error)
+{
+    return VisDocument::save(path, vis_scene, error);
+}
+
+bool Environment::openTrace(QString path, QString* error)
+{
+    if(vis_trace.isRecording()){
+        *error = "A trace is being recorded";
+        return false;
+    }
+    trace_player->close();
+    return vis_trace.open(path, error);
+}
+
+bool Environment::saveTrace(QString path, QString* error)
+{
+    return vis_trace.save(path, error);
+}
+
+bool Environment::exportFrames(VisFrameExporter& exporter, const VisFrameSettings& settings)
+{
+    return exporter.write(vis_trace, settings);
+}
+
+void Environment::replayTrace()
+{
+    // El primer paso pasa a ser el grafo actual, los demas solo se
+    // muestran en la escena
+    VisDocument document;
+    if(not hasTrace() or not document.open(vis_trace.keyframe(0)))
+        return;
+    loadDocument(document);
+    trace_player->setTrace(&vis_trace);
+}
+
+void Environment::loadAttributes(const QList<VisAttribute>& attributes)
+{
+    SCM add = scm_variable_ref(scm_c_lookup("add-atribute!"));
+    SCM g   = scm_variable_ref(scm_c_lookup("G"));
+    bool directed = graphType() == VisGraphicsScene::DIRECTED;
+
+    foreach(const VisAttribute& attribute, attributes){
+        // Solo los elementos que la escena acepto, G no conoce los demas
+        SCM item;
+        if(attribute.bid < 0){
+            if(not vis_scene->graph_nodes.contains(attribute.aid))
+                continue;
+            item = scm_from_int(attribute.aid);
+        }else{
+            bool exists = directed ? vis_scene->graph_arrows.contains(attribute.aid, attribute.bid)
+                                   : vis_scene->graph_edges.contains(attribute.aid, attribute.bid);
+            if(not exists)
+                continue;
+            item = scm_list_2(scm_from_int(attribute.aid), scm_from_int(attribute.bid));
+        }
+
+        SCM value;
+        switch(attribute.value.type()){
+        case QVariant::Bool:
+            value = scm_from_bool(attribute.value.toBool());
+            break;
+        case QVariant::LongLong:
+            value = scm_from_int64(attribute.value.toLongLong());
+            break;
+        case QVariant::Double:
+            value = scm_from_double(attribute.value.toDouble());
+            break;
+        default:
+            value = scm_from_utf8_string(attribute.value.toString().toUtf8().constData());
+        }
+        SCM key = scm_symbol_to_keyword(scm_from_utf8_symbol(attribute.name.constData()));
+        scm_call_4(add, g, item, key, value);
+    }
+}
+
+bool Environment::exportGraph(QString path, QString* error)
+{
+    return VisExporter::write(path, VisExporter::formatOf(path), vis_scene, error);
+}
+
+bool Environment::renderImage(VisImageExporter& exporter, QString path, const VisImageSettings& settings)
+{
+    return exporter.write(path, vis_scene, settings);
+}
+
+void Environment::beginBatch()
+{
+    batches.localData().depth++;
+}
+
+void Environment::commitBatch()
+{
+    Batch& batch = batches.localData();
+    if(batch.depth == 0)
+        return;
+    batch.depth--;
+    if(batch.depth > 0)
+        return;
+    flushBatch();
+}
+
+void Environment::flushBatch()
+{
+    Batch& batch = batches.localData();
+    if(batch.changes.isEmpty())
+        return;
+    VisChangeSet changes = batch.changes;
+    batch.changes.clear();
+    emit visApplyChanges(changes);
+}
+
+void Environment::discardBatch()
+{
+    batches.localData().changes.clear();
+}
+
+bool Environment::batchChange(const VisChange& change)
+{
+    // Todas las primitivas de dibujo pasan por aqui, tambien las que se
+    // aplican de inmediato
+    vis_trace.record(change);
+
+    Batch& batch = batches.localData();
+    if(batch.depth == 0)
+        return false;
+    batch.changes.append(change);
+    return true;
 }
 
 QString Environment::addNodeCode(int id, double x, double y)
@@ -324,6 +677,37 @@ QString Environment::removeArrowCode(int aid,int bid)
             QString(" ") + QString::number(bid) + QString("))");
 }
 
+QString Environment::removeItemsCode(const QList<int>& nodes,
+                                     const QList<QPair<int,int> >& edges,
+                                     const QList<QPair<int,int> >& arrows)
+{
+    // (begin (remove-edges! G '((a b) ...)) (remove-arrows! G '((a b) ...))
+    //        (remove-vertices! G '(v ...)))
+    QString code("(begin");
+    QPair<int,int> key;
+    if(!edges.isEmpty()){
+        code += QString(" (remove-edges! G '(");
+        foreach(key, edges)
+            code += QString("(") + QString::number(key.first) + QString(" ") +
+                    QString::number(key.second) + QString(")");
+        code += QString("))");
+    }
+    if(!arrows.isEmpty()){
+        code += QString(" (remove-arrows! G '(");
+        foreach(key, arrows)
+            code += QString("(") + QString::number(key.first) + QString(" ") +
+                    QString::number(key.second) + QString(")");
+        code += QString("))");
+    }
+    if(!nodes.isEmpty()){
+        code += QString(" (remove-vertices! G '(");
+        foreach(int id, nodes)
+            code += QString::number(id) + QString(" ");
+        code += QString("))");
+    }
+    return code + QString(")");
+}
+
 ///////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////
@@ -334,6 +718,8 @@ QString Environment::removeArrowCode(int aid,int bid)
 Environment::Environment(QWidget *parent) :
     QWidget(parent)
 {
+    qRegisterMetaType<VisChangeSet>("VisChangeSet");
+
     vis_scene = new VisGraphicsScene;
 
     vis_view = new VisGraphicsView(vis_scene);
@@ -407,6 +793,10 @@ Environment::Environment(QWidget *parent) :
                 vis_scene, SLOT(visIncrementId()));
         connect(this,      SIGNAL(visResetId()),
                 vis_scene, SLOT(visResetId()));
+        connect(this,      SIGNAL(visClearGraph()),
+                vis_scene, SLOT(visClearGraph()));
+        connect(this,      SIGNAL(visApplyChanges(VisChangeSet)),
+                vis_scene, SLOT(visApplyChanges(VisChangeSet)));
 
         connect(this,      SIGNAL(visMoveNode(int,double,double)),
                 vis_scene, SLOT(visMoveNode(int,double,double)));
@@ -415,12 +805,21 @@ Environment::Environment(QWidget *parent) :
     env = this;
     on_pause = false;
     with_curves = false;
+    collect_unpaints = false;
+    next_snapshot = 0;
+    record_traces = false;
+    trace_player = new VisTracePlayer(vis_scene, this);
+    autosave = new VisAutosave(vis_scene, trace_player);
 
     initForeign();
 }
 
 Environment::~Environment()
 {
+    // Los workers todavia pueden usar la escena
+    delete executor;
+    // Espera el ultimo checkpoint y borra el journal
+    delete autosave;
     delete vis_scene;
     delete vis_view;
     delete ui_layout;
@@ -437,6 +836,8 @@ void Environment::visChangeZoom(int percent)
 {
     double zoom = percent/100.0;
 
+    vis_view->visInteraction();
+
     QMatrix old_matrix = vis_view->matrix();
     vis_view->resetMatrix();
     vis_view->translate(old_matrix.dx(),old_matrix.dy());
@@ -452,12 +853,12 @@ void Environment::visToolSelected(int tool)
 void Environment::visSetGraphType(int type)
 {
     if(type == 1 and graphType() == VisGraphicsScene::UNDIRECTED){
-        delGraph(graphType(), false);
+        delGraph();
         emit visResetId();
         vis_scene->graph_type = VisGraphicsScene::DIRECTED;
         newGraph(VisGraphicsScene::DIRECTED);
     }else if(type == 0 and graphType() == VisGraphicsScene::DIRECTED){
-        delGraph(graphType(), false);
+        delGraph();
         emit visResetId();
         vis_scene->graph_type = VisGraphicsScene::UNDIRECTED;
         newGraph(VisGraphicsScene::UNDIRECTED);
@@ -466,7 +867,47 @@ void Environment::visSetGraphType(int type)
 
 void Environment::visRemoveSelection()
 {
-    vis_scene->visRemoveSelected();
+    QList<int> nodes;
+    QList<QPair<int,int> > edges;
+    QList<QPair<int,int> > arrows;
+    vis_scene->visSelectedGraphItems(nodes, edges, arrows);
+    if(nodes.isEmpty() and edges.isEmpty() and arrows.isEmpty())
+        return;
+
+    // Una sola llamada a Scheme; los elementos que elimine (incluidas las
+    // aristas incidentes) se quitan de la escena juntos al final
+    collect_unpaints = true;
+    evalString(removeItemsCode(nodes, edges, arrows));
+    collect_unpaints = false;
+
+    vis_scene->visUnpaintItems(unpainted_nodes, unpainted_edges, unpainted_arrows);
+    unpainted_nodes.clear();
+    unpainted_edges.clear();
+    unpainted_arrows.clear();
+}
+
+bool Environment::collectUnpaint(const VisChange& change)
+{
+    // Solo el hilo que elimina la seleccion; el cambio queda en la traza
+    // aunque la escena lo aplique despues junto con los demas
+    if(not collect_unpaints or QThread::currentThread() != thread())
+        return false;
+    vis_trace.record(change);
+
+    switch(change.kind){
+    case VisChange::UNPAINT_NODE:
+        unpainted_nodes.append(change.aid);
+        break;
+    case VisChange::UNPAINT_EDGE:
+        unpainted_edges.append(QPair<int,int>(change.aid, change.bid));
+        break;
+    case VisChange::UNPAINT_ARROW:
+        unpainted_arrows.append(QPair<int,int>(change.aid, change.bid));
+        break;
+    default:
+        break;
+    }
+    return true;
 }
 
 void Environment::visCleanGraph()
@@ -481,7 +922,7 @@ void Environment::visUnlabelGraph()
 
 void Environment::visEraseGraph()
 {
-    delGraph(graphType(), true);
+    delGraph();
     emit visResetId();
 }
 
@@ -491,7 +932,8 @@ void Environment::visRunBipartiteness()
     int response = dialog.exec();
 
     if(response == 1){ // OK Button clicked
-        evalString("(run-bipartiteness G)", true);
+        requireAlgorithm("bipartiteness");
+        runAlgorithm("(run-bipartiteness G)");
     }
 }
 
@@ -501,8 +943,9 @@ void Environment::visRunSpanningTreeBFS()
     int response = dialog.exec();
 
     if(response == 1){
+        requireAlgorithm("spanning-tree-bfs");
         int root_vertex = dialog.getRootVertex();
-        evalString(QString("(run-spanning-tree-bfs G ")+QString::number(root_vertex)+QString(")"), true);
+        runAlgorithm(QString("(run-spanning-tree-bfs G ")+QString::number(root_vertex)+QString(")"));
     }
 }
 
@@ -512,8 +955,9 @@ void Environment::visRunSpanningTreeDFS()
     int response = dialog.exec();
 
     if(response == 1){
+        requireAlgorithm("spanning-tree-dfs");
         int root_vertex = dialog.getRootVertex();
-        evalString(QString("(run-spanning-tree-dfs G ")+QString::number(root_vertex)+QString(")"), true);
+        runAlgorithm(QString("(run-spanning-tree-dfs G ")+QString::number(root_vertex)+QString(")"));
     }
 }
 
@@ -523,14 +967,15 @@ void Environment::visRunPrim()
     int response = dialog.exec();
 
     if(response == 1){
+        requireAlgorithm("prim");
         int root_vertex = dialog.getRootVertex();
         foreach(VisEdge* edge, vis_scene->graph_edges.values()){
             int aid = edge->a_id;
             int bid = edge->b_id;
             evalString(QString("(add-atribute! G '(" + QString::number(aid) + QString(" ") + QString::number(bid)
-                               + QString(") #:weight " + edge->label->toPlainText() + QString(")"))));
+                               + QString(") #:weight " + edge->labelText() + QString(")"))));
         }
-        evalString(QString("(run-prim G ") + QString::number(root_vertex) + QString(")"), true);
+        runAlgorithm(QString("(run-prim G ") + QString::number(root_vertex) + QString(")"));
     }
 }
 
@@ -540,13 +985,14 @@ void Environment::visRunKruskal()
     int response = dialog.exec();
 
     if(response == 1){
+        requireAlgorithm("kruskal");
         foreach(VisEdge* edge, vis_scene->graph_edges.values()){
             int aid = edge->a_id;
             int bid = edge->b_id;
             evalString(QString("(add-atribute! G '(" + QString::number(aid) + QString(" ") + QString::number(bid)
-                               + QString(") #:weight " + edge->label->toPlainText() + QString(")"))));
+                               + QString(") #:weight " + edge->labelText() + QString(")"))));
         }
-        evalString(QString("(run-kruskal G)"), true);
+        runAlgorithm(QString("(run-kruskal G)"));
     }
 }
 
@@ -556,15 +1002,16 @@ void Environment::visRunDijkstra()
     int response = dialog.exec();
 
     if(response == 1){
+        requireAlgorithm("dijkstra");
         int starting_vertex = dialog.getStartingVertex();
         int ending_vertex = dialog.getEndingVertex();
         foreach(VisArrow* arrow, vis_scene->graph_arrows.values()){
             int aid = arrow->a_id;
             int bid = arrow->b_id;
             evalString(QString("(add-atribute! G '(" + QString::number(aid) + QString(" ") + QString::number(bid)
-                               + QString(") #:distance " + arrow->label->toPlainText() + QString(")"))));
+                               + QString(") #:distance " + arrow->labelText() + QString(")"))));
         }
-        evalString(QString("(run-dijkstra G ")+QString::number(starting_vertex)+QString(" ")+QString::number(ending_vertex)+QString(")"), true);
+        runAlgorithm(QString("(run-dijkstra G ")+QString::number(starting_vertex)+QString(" ")+QString::number(ending_vertex)+QString(")"));
     }
 }
 
@@ -574,20 +1021,21 @@ void Environment::visRunFloydWarshall()
     int response = dialog.exec();
 
     if(response == 1){
+        requireAlgorithm("floyd-warshall");
         foreach(VisArrow* arrow, vis_scene->graph_arrows.values()){
             int aid = arrow->a_id;
             int bid = arrow->b_id;
             evalString(QString("(add-atribute! G '(" + QString::number(aid) + QString(" ") + QString::number(bid)
-                               + QString(") #:distance " +arrow->label->toPlainText() + QString(")"))));
+                               + QString(") #:distance " +arrow->labelText() + QString(")"))));
         }
-        evalString("(run-floyd-warshall G)", true);
+        runAlgorithm("(run-floyd-warshall G)");
     }
 }
 
 void Environment::fordFulkersonParseAndLabel(VisArrow* arrow)
 {
     // La etiqueta puede tener uno o dos valores separados por coma representando la capacidad o la restricción minima y capacidad ejemplo "1,2", "3", "1,5"
-    QString label = arrow->label->toPlainText();
+    QString label = arrow->labelText();
     QStringList lst = label.split(",", QString::SkipEmptyParts);
     int size = lst.size();
 
@@ -610,7 +1058,7 @@ void Environment::fordFulkersonParseAndLabel(VisArrow* arrow)
 void Environment::fordFulkersonParseAndLabel(VisNode* node)
 {
     // La etiqueta puede tener uno o dos valores separados por coma representando la capacidad o la restricción minima y capacidad ejemplo "1,2", "3", "1,5"
-    QString label = node->label->toPlainText();
+    QString label = node->labelText();
     QStringList lst = label.split(",", QString::SkipEmptyParts);
     int size = lst.size();
 
@@ -652,6 +1100,7 @@ void Environment::visRunFordFulkerson()
     double     flow    = dialog.getFlow();
 
     if(response == 1){
+        requireAlgorithm("ford-fulkerson");
         foreach(VisArrow* arrow, vis_scene->graph_arrows.values()){
             fordFulkersonParseAndLabel(arrow);
         }
@@ -660,9 +1109,9 @@ void Environment::visRunFordFulkerson()
         }
 
         if(flow == -1){  // El algoritmo deberá maximizar flujo
-            evalString(QString("(run-ford-fulkerson G ")+listToString(sources)+QString(" ")+listToString(sinks)+QString(")"), true);
+            runAlgorithm(QString("(run-ford-fulkerson G ")+listToString(sources)+QString(" ")+listToString(sinks)+QString(")"));
         }else{           // El algoritmo deberá obtener el flujo dado
-            evalString(QString("(run-ford-fulkerson G ")+listToString(sources)+QString(" ")+listToString(sinks)+QString(" ")+QString::number(flow)+QString(")"), true);
+            runAlgorithm(QString("(run-ford-fulkerson G ")+listToString(sources)+QString(" ")+listToString(sinks)+QString(" ")+QString::number(flow)+QString(")"));
         }
 
     }
@@ -672,7 +1121,7 @@ void Environment::minCostNCParseAndLabel(VisArrow* arrow)
 {
     int i = 0;
     // La etiqueta puede tener tres valores "r,q,$" o dos valores "q,$"
-    QString label = arrow->label->toPlainText();
+    QString label = arrow->labelText();
     QStringList lst = label.split(",", QString::SkipEmptyParts);
 
 
@@ -692,7 +1141,7 @@ void Environment::minCostNCParseAndLabel(VisArrow* arrow)
 void Environment::minCostNCParseAndLabel(VisNode* node)
 {
     // La etiqueta puede tener uno o dos valores separados por coma representando la capacidad o la restricción minima y capacidad ejemplo "1,2", "3", "1,5"
-    QString label = node->label->toPlainText();
+    QString label = node->labelText();
     QStringList lst = label.split(",", QString::SkipEmptyParts);
     int size = lst.size();
 
@@ -722,6 +1171,7 @@ void Environment::visRunMinimumCostConstantFlowNC()
     double     flow    = dialog.getFlow();
 
     if(response == 1){
+        requireAlgorithm("minimum-cost-nc");
         foreach(VisArrow* arrow, vis_scene->graph_arrows.values()){
             minCostNCParseAndLabel(arrow);
         }
@@ -729,14 +1179,14 @@ void Environment::visRunMinimumCostConstantFlowNC()
             minCostNCParseAndLabel(node);
         }
 
-        evalString(QString("(run-minimum-cost-constant-flow-nc G ")+listToString(sources)+QString(" ")+listToString(sinks)+QString(" ")+QString::number(flow)+QString(")"), true);
+        runAlgorithm(QString("(run-minimum-cost-constant-flow-nc G ")+listToString(sources)+QString(" ")+listToString(sinks)+QString(" ")+QString::number(flow)+QString(")"));
     }
 }
 
 void Environment::minCostSPParseAndLabel(VisArrow* arrow)
 {
     // La etiqueta debe tener dos valores separados por coma representando la capacidad y el costo ejemplo "1,2", "3", "1,5"
-    QString label = arrow->label->toPlainText();
+    QString label = arrow->labelText();
     QStringList lst = label.split(",", QString::SkipEmptyParts);
 
     evalString(QString("(add-atribute! G '(")+QString::number(arrow->a_id)+QString(" ")+QString::number(arrow->b_id)+
@@ -756,14 +1206,20 @@ void Environment::visRunMinimumCostConstantFlowSP()
     double     flow    = dialog.getFlow();
 
     if(response == 1){
+        requireAlgorithm("minimum-cost-sp");
         foreach(VisArrow* arrow, vis_scene->graph_arrows.values()){
             minCostSPParseAndLabel(arrow);
         }
 
-        evalString(QString("(run-minimum-cost-constant-flow-sp G ")+listToString(sources)+QString(" ")+listToString(sinks)+QString(" ")+QString::number(flow)+QString(")"), true);
+        runAlgorithm(QString("(run-minimum-cost-constant-flow-sp G ")+listToString(sources)+QString(" ")+listToString(sinks)+QString(" ")+QString::number(flow)+QString(")"));
     }
 }
 
+void Environment::visStopAlgorithms()
+{
+    executor->cancelAll();
+}
+
 void Environment::visCurves(bool with_curves)
 {
     this->with_curves = with_curves;
@@ -818,3 +1274,23 @@ QPointF Environment::visPosNode(int id)
 {
     return vis_scene->visPosNode(id);
 }
+
+void Environment::visRecordTraces(bool record)
+{
+    record_traces = record;
+}
+
+void Environment::visEndTrace(int, int)
+{
+    if(algorithmsRunning() or not vis_trace.isRecording())
+        return;
+    vis_trace.end();
+    emit visTraceRecorded();
+}
+
+void Environment::visForgetSnapshot(int job, int)
+{
+    // Un trabajo cancelado antes de empezar no recogio su instantanea
+    if(job_snapshots.contains(job))
+        evalString(QString("(take-algorithm-snapshot! ") + QString::number(job_snapshots.take(job)) + QString(")"));
+}
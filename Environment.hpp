@@ -6,12 +6,29 @@
 
 // Member classes
 #include <QHBoxLayout>
+#include <QMutex>
+#include <QHash>
+#include <QThreadStorage>
 #include <VisGraphicsScene.hpp>
 #include <VisGraphicsView.hpp>
+#include <VisSchemeExecutor.hpp>
+#include <VisDocument.hpp>
+#include <VisTrace.hpp>
+#include <VisTracePlayer.hpp>
+#include <VisAutosave.hpp>
+#include <VisFrameExporter.hpp>
+#include <VisImageExporter.hpp>
+#include <QList>
+#include <QVector>
 
 // Foreign language includes
 #include <libguile.h>
 
+struct VisAttribute;
+
+SCM scmFromInts(const QVector<qint32>& values);
+QString scmQuote(QString text);
+
 class Environment : public QWidget
 {
     Q_OBJECT
@@ -39,6 +56,9 @@ public:
     friend SCM scmUncolorArrowLabel(SCM, SCM);
     friend SCM scmWait(SCM);
     friend SCM scmShowMessage(SCM);
+    friend SCM scmClearGraph();
+    friend SCM scmBatchBegin();
+    friend SCM scmBatchCommit();
 
     friend SCM visPosNode(SCM id);
     friend SCM visMoveNode(SCM id, SCM dx, SCM dy);
@@ -47,9 +67,54 @@ public:
     ~Environment();
 
     SCM evalString(QString, bool = false);
-    void evalFile(QString);
+    // Prefers the compiled object next to the executable, also used in
+    // batch mode where there is no environment
+    static void evalFile(QString);
+    void requireAlgorithm(QString);
+    void runAlgorithm(QString);
+    bool algorithmsRunning() { return executor->pendingJobs() > 0; }
     void newGraph(VisGraphicsScene::GRAPH);
-    void delGraph(VisGraphicsScene::GRAPH, bool thread);
+    void delGraph();
+
+    // Binary documents. Loading replaces the current graph and switches to
+    // the document's graph type.
+    void loadDocument(const VisDocument& document);
+    bool saveDocument(QString path, QString* error);
+
+    // Typed data of imported XML files, set in G once the graph is loaded
+    void loadAttributes(const QList<VisAttribute>& attributes);
+    bool exportGraph(QString path, QString* error);
+    // Draws the current graph as PNG or SVG, see VisImageExporter
+    bool renderImage(VisImageExporter& exporter, QString path, const VisImageSettings& settings);
+
+    // Algorithm traces. While recording is on, every run records its
+    // drawing calls and steps until no algorithm is left running; replay
+    // loads the first step as the current graph and hands the trace to the
+    // player.
+    bool hasTrace() { return not vis_trace.isRecording() and not vis_trace.isEmpty(); }
+    bool traceDirected() { return vis_trace.directed(); }
+    bool openTrace(QString path, QString* error);
+    bool saveTrace(QString path, QString* error);
+    // Renders every step of the trace, see VisFrameExporter
+    bool exportFrames(VisFrameExporter& exporter, const VisFrameSettings& settings);
+    void replayTrace();
+    VisTracePlayer* tracePlayer() { return trace_player; }
+
+    // Session journal, restored by the window before it is started
+    VisAutosave* autosaver() { return autosave; }
+
+    // Algorithms started while a results file is set also write their
+    // result tables there, see VisResultWriter
+    void setResultsFile(QString path) { results_path = path; }
+
+    // Batch mode: drawing calls made between beginBatch and the matching
+    // commitBatch are recorded and reach the scene together at commit.
+    // Each thread has its own batch, the calls of other threads go on.
+    void beginBatch();
+    void commitBatch();
+    void flushBatch();
+    void discardBatch();
+    bool batchChange(const VisChange& change);
 
     QString addNodeCode(int, double, double);
     QString removeNodeCode(int);
@@ -57,10 +122,22 @@ public:
     QString removeEdgeCode(int,int);
     QString addArrowCode(int,int);
     QString removeArrowCode(int,int);
+    QString removeItemsCode(const QList<int>&,
+                            const QList<QPair<int,int> >&,
+                            const QList<QPair<int,int> >&);
 
     bool on_pause;
     bool with_curves;
 
+    // While set, cpp-unpaint-* calls of the GUI thread are recorded in the
+    // trace and collected to be applied in one pass; workers still unpaint
+    // on their own. False when the change is not collected.
+    bool collect_unpaints;
+    bool collectUnpaint(const VisChange& change);
+    QList<int>             unpainted_nodes;
+    QList<QPair<int,int> > unpainted_edges;
+    QList<QPair<int,int> > unpainted_arrows;
+
     VisGraphicsScene::GRAPH graphType() {return vis_scene->graph_type;}
 
     QPointF visPosNode(int id);
@@ -69,8 +146,32 @@ public:
 private:
     VisGraphicsScene* vis_scene;
 
+    struct Batch
+    {
+        int          depth;
+        VisChangeSet changes;
+
+        Batch() : depth(0) {}
+    };
+    QThreadStorage<Batch> batches;
+
+    VisTrace        vis_trace;
+    VisTracePlayer* trace_player;
+    bool            record_traces;
+    QString         results_path;
+
+    VisAutosave*    autosave;
+
     VisGraphicsView* vis_view;
 
+    // Algorithms share G and the step button, they run one after another
+    VisSchemeExecutor* executor;
+    const static int algorithm_workers = 1;
+
+    // Snapshot of G stored for each algorithm job until it finishes
+    QHash<int,int> job_snapshots;
+    int            next_snapshot;
+
     QHBoxLayout* ui_layout;
 
     void initForeign();
@@ -85,6 +186,9 @@ signals:
     // To VisMainWindow
     void visStepWait(QString);
     void visShowMessage(QString);
+    void visAlgorithmStarted(int id);
+    void visAlgorithmFinished(int id, int status);
+    void visTraceRecorded();
 
     // To VisGraphicsScene
     void visPaintNode(int id, double x, double y);
@@ -110,6 +214,8 @@ signals:
     void visUncolorArrowLabel(int aid, int bid);
     void visIncrementId();
     void visResetId();
+    void visClearGraph();
+    void visApplyChanges(VisChangeSet changes);
 
     void visMoveNode(int id, double dx, double dy);
 
@@ -133,7 +239,9 @@ public slots:
     void visRunFordFulkerson();
     void visRunMinimumCostConstantFlowNC();
     void visRunMinimumCostConstantFlowSP();
+    void visStopAlgorithms();
     void visCurves(bool);
+    void visRecordTraces(bool);
 
 private slots:
     // From VisGraphicsScene
@@ -143,6 +251,10 @@ private slots:
     void visRemoveEdge(int aid, int bid);
     void visAddArrow(int aid, int bid);
     void visRemoveArrow(int aid, int bid);
+
+    // From VisSchemeExecutor
+    void visForgetSnapshot(int job, int status);
+    void visEndTrace(int job, int status);
 };
 
 #endif // ENVIRONMENT_HPP
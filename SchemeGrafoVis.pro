@@ -8,6 +8,9 @@ QT       += core gui
 
 greaterThan(QT_MAJOR_VERSION, 4): QT += widgets
 
+# Image export writes SVG through QSvgGenerator
+QT       += svg
+
 TARGET = SchemeGrafoVis
 TEMPLATE = app
 
@@ -32,7 +35,21 @@ SOURCES += main.cpp\
     VisFordFulkerson.cpp \
     VisFloydWarshall.cpp \
     VisMinimumCostConstantFlowNC.cpp \
-    VisMinimumCostConstantFlowSP.cpp
+    VisMinimumCostConstantFlowSP.cpp \
+    VisTextCache.cpp \
+    VisVertexModel.cpp \
+    VisVertexPicker.cpp \
+    VisSchemeExecutor.cpp \
+    VisDocument.cpp \
+    VisImporter.cpp \
+    VisExporter.cpp \
+    VisTrace.cpp \
+    VisTracePlayer.cpp \
+    VisBatch.cpp \
+    VisResultWriter.cpp \
+    VisAutosave.cpp \
+    VisFrameExporter.cpp \
+    VisImageExporter.cpp
 
 HEADERS  += VisMainWindow.hpp \
     Environment.hpp \
@@ -53,8 +70,70 @@ HEADERS  += VisMainWindow.hpp \
     VisFordFulkerson.hpp \
     VisFloydWarshall.hpp \
     VisMinimumCostConstantFlowNC.hpp \
-    VisMinimumCostConstantFlowSP.hpp
+    VisMinimumCostConstantFlowSP.hpp \
+    VisTextCache.hpp \
+    VisChangeSet.hpp \
+    VisItemPool.hpp \
+    VisItemTable.hpp \
+    VisVertexModel.hpp \
+    VisVertexPicker.hpp \
+    VisSchemeExecutor.hpp \
+    VisDocument.hpp \
+    VisImporter.hpp \
+    VisExporter.hpp \
+    VisTrace.hpp \
+    VisTracePlayer.hpp \
+    VisBatch.hpp \
+    VisResultWriter.hpp \
+    VisAutosave.hpp \
+    VisFrameExporter.hpp \
+    VisImageExporter.hpp
 
 QMAKE_CXXFLAGS += -pthread -I/usr/include/guile/2.0
 QMAKE_CFLAGS += -pthread -I/usr/include/guile/2.0
-QMAKE_LIBS += -lguile-2.0 -lgc
+QMAKE_LIBS += -lguile-2.0 -lgc -lz
+
+# Scheme files compiled ahead of time to .go objects next to the binary,
+# Environment::evalFile loads them instead of the sources when they are
+# up to date. init.scm only imports modules and starts the REPL server, it
+# is always loaded from source.
+SCHEME_SCRIPTS = build-debug/vis-graph.scm \
+    build-debug/algorithms.scm
+
+SCHEME_MODULES = build-debug/grafo/hashtable.scm \
+    build-debug/grafo/graph.scm \
+    build-debug/grafo/utils.scm
+
+scheme_scripts.input = SCHEME_SCRIPTS
+scheme_scripts.output = ${QMAKE_FILE_BASE}.go
+scheme_scripts.commands = guile $$PWD/build-debug/compile-scheme.scm ${QMAKE_FILE_NAME} ${QMAKE_FILE_OUT}
+scheme_scripts.depends = $$SCHEME_MODULES $$PWD/build-debug/compile-scheme.scm
+scheme_scripts.CONFIG += no_link target_predeps
+QMAKE_EXTRA_COMPILERS += scheme_scripts
+
+# Algorithms are loaded on first use from algorithms/, their objects go to
+# the same subdirectory next to the binary
+SCHEME_ALGORITHMS = build-debug/algorithms/bipartiteness.scm \
+    build-debug/algorithms/spanning-tree-bfs.scm \
+    build-debug/algorithms/spanning-tree-dfs.scm \
+    build-debug/algorithms/heap.scm \
+    build-debug/algorithms/prim.scm \
+    build-debug/algorithms/kruskal.scm \
+    build-debug/algorithms/dijkstra.scm \
+    build-debug/algorithms/floyd-warshall.scm \
+    build-debug/algorithms/ford-fulkerson.scm \
+    build-debug/algorithms/minimum-cost-nc.scm \
+    build-debug/algorithms/minimum-cost-sp.scm
+
+scheme_algorithms.input = SCHEME_ALGORITHMS
+scheme_algorithms.output = algorithms/${QMAKE_FILE_BASE}.go
+scheme_algorithms.commands = guile $$PWD/build-debug/compile-scheme.scm ${QMAKE_FILE_NAME} ${QMAKE_FILE_OUT}
+scheme_algorithms.depends = $$SCHEME_MODULES $$PWD/build-debug/compile-scheme.scm
+scheme_algorithms.CONFIG += no_link target_predeps
+QMAKE_EXTRA_COMPILERS += scheme_algorithms
+
+scheme_modules.input = SCHEME_MODULES
+scheme_modules.output = grafo/${QMAKE_FILE_BASE}.go
+scheme_modules.commands = guild compile -L $$PWD/build-debug -o ${QMAKE_FILE_OUT} ${QMAKE_FILE_NAME}
+scheme_modules.CONFIG += no_link target_predeps
+QMAKE_EXTRA_COMPILERS += scheme_modules
@@ -3,6 +3,7 @@
 
 #include "VisBezierCurve.hpp"
 #include "VisNode.hpp"
+#include "VisItemPool.hpp"
 
 class VisArrow : public VisBezierCurve
 {
@@ -13,6 +14,9 @@ public:
 
     int type() const {return Type;}
 
+    // Allocated from VisItemPool
+    VIS_POOL_ALLOCATED
+
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
 };
 
@@ -0,0 +1,394 @@
+#include "VisAutosave.hpp"
+
+#include <QFile>
+#include <QSaveFile>
+#include <QLockFile>
+#include <QDir>
+#include <QStandardPaths>
+#include <QCryptographicHash>
+#include <QRunnable>
+#include <QtDebug>
+
+#include <cstring>
+
+#include "VisGraphicsScene.hpp"
+#include "VisTracePlayer.hpp"
+
+static const char journal_magic[4] = {'S', 'G', 'V', 'J'};
+
+static quint64 aligned(quint64 offset)
+{
+    return (offset+7) & ~quint64(7);
+}
+
+template <typename T>
+static QByteArray bytesOf(const QVector<T>& values)
+{
+    return QByteArray::fromRawData((const char*) values.constData(), values.size()*sizeof(T));
+}
+
+template <typename T>
+static void assign(QVector<T>* values, const QByteArray& bytes)
+{
+    values->resize(bytes.size()/sizeof(T));
+    memcpy(values->data(), bytes.constData(), values->size()*sizeof(T));
+}
+
+// Las secciones del journal son las mismas del documento
+static QByteArray sectionOf(const VisDocumentContent& content, int section)
+{
+    switch(section){
+    case VisDocumentHeader::IDS:               return bytesOf(content.ids);
+    case VisDocumentHeader::POSITIONS:         return bytesOf(content.positions);
+    case VisDocumentHeader::ROWS:              return bytesOf(content.rows);
+    case VisDocumentHeader::TARGETS:           return bytesOf(content.targets);
+    case VisDocumentHeader::CTRL_POINTS:       return bytesOf(content.ctrl_points);
+    case VisDocumentHeader::NODE_FLAGS:        return bytesOf(content.node_flags);
+    case VisDocumentHeader::EDGE_FLAGS:        return bytesOf(content.edge_flags);
+    case VisDocumentHeader::NODE_COLORS:       return bytesOf(content.node_colors);
+    case VisDocumentHeader::NODE_LABEL_COLORS: return bytesOf(content.node_label_colors);
+    case VisDocumentHeader::EDGE_COLORS:       return bytesOf(content.edge_colors);
+    case VisDocumentHeader::EDGE_LABEL_COLORS: return bytesOf(content.edge_label_colors);
+    case VisDocumentHeader::LABEL_OFFSETS:     return bytesOf(content.label_offsets);
+    case VisDocumentHeader::LABEL_DATA:        return content.label_data;
+    default:                                   return QByteArray();
+    }
+}
+
+static void setSection(VisDocumentContent* content, int section, const QByteArray& bytes)
+{
+    switch(section){
+    case VisDocumentHeader::IDS:               assign(&content->ids, bytes);               break;
+    case VisDocumentHeader::POSITIONS:         assign(&content->positions, bytes);         break;
+    case VisDocumentHeader::ROWS:              assign(&content->rows, bytes);              break;
+    case VisDocumentHeader::TARGETS:           assign(&content->targets, bytes);           break;
+    case VisDocumentHeader::CTRL_POINTS:       assign(&content->ctrl_points, bytes);       break;
+    case VisDocumentHeader::NODE_FLAGS:        assign(&content->node_flags, bytes);        break;
+    case VisDocumentHeader::EDGE_FLAGS:        assign(&content->edge_flags, bytes);        break;
+    case VisDocumentHeader::NODE_COLORS:       assign(&content->node_colors, bytes);       break;
+    case VisDocumentHeader::NODE_LABEL_COLORS: assign(&content->node_label_colors, bytes); break;
+    case VisDocumentHeader::EDGE_COLORS:       assign(&content->edge_colors, bytes);       break;
+    case VisDocumentHeader::EDGE_LABEL_COLORS: assign(&content->edge_label_colors, bytes); break;
+    case VisDocumentHeader::LABEL_OFFSETS:     assign(&content->label_offsets, bytes);     break;
+    case VisDocumentHeader::LABEL_DATA:        content->label_data = QByteArray(bytes.constData(), bytes.size()); break;
+    default:                                   break;
+    }
+}
+
+static quint32 bit(int section)
+{
+    return quint32(1) << section;
+}
+
+// Secciones del documento que cambia cada clase de edicion
+static quint32 sectionsOf(int edits)
+{
+    if(edits & VisGraphicsScene::TOPOLOGY)
+        return bit(VisDocumentHeader::SECTION_COUNT)-1;
+    quint32 sections = 0;
+    if(edits & VisGraphicsScene::GEOMETRY)
+        sections |= bit(VisDocumentHeader::POSITIONS) | bit(VisDocumentHeader::CTRL_POINTS) |
+                    bit(VisDocumentHeader::EDGE_FLAGS);
+    if(edits & VisGraphicsScene::COLORS)
+        sections |= bit(VisDocumentHeader::NODE_FLAGS) | bit(VisDocumentHeader::EDGE_FLAGS) |
+                    bit(VisDocumentHeader::NODE_COLORS) | bit(VisDocumentHeader::NODE_LABEL_COLORS) |
+                    bit(VisDocumentHeader::EDGE_COLORS) | bit(VisDocumentHeader::EDGE_LABEL_COLORS);
+    if(edits & VisGraphicsScene::LABELS)
+        sections |= bit(VisDocumentHeader::LABEL_OFFSETS) | bit(VisDocumentHeader::LABEL_DATA);
+    return sections;
+}
+
+static QByteArray digestOf(const QByteArray& bytes)
+{
+    return QCryptographicHash::hash(bytes, QCryptographicHash::Md5);
+}
+
+static bool consistent(const VisDocumentContent& c, quint32 n, quint32 m)
+{
+    return (quint32) c.ids.size() == n and (quint32) c.positions.size() == 2*n and
+           (quint32) c.rows.size() == n+1 and (quint32) c.targets.size() == m and
+           (quint32) c.ctrl_points.size() == 4*m and (quint32) c.node_flags.size() == n and
+           (quint32) c.edge_flags.size() == m and (quint32) c.node_colors.size() == n and
+           (quint32) c.node_label_colors.size() == n and (quint32) c.edge_colors.size() == m and
+           (quint32) c.edge_label_colors.size() == m and (quint32) c.label_offsets.size() == n+m+1;
+}
+
+// Escribe un checkpoint en el hilo del autosave
+class VisCheckpointTask : public QRunnable
+{
+public:
+    VisCheckpointTask(VisAutosave* autosave_, const VisDocumentContent& content_, quint32 sections_)
+        : autosave(autosave_), content(content_), sections(sections_) {}
+
+    void run()
+    {
+        autosave->write(content, sections);
+        autosave->writeDone();
+    }
+
+private:
+    VisAutosave*       autosave;
+    VisDocumentContent content;
+    quint32            sections;
+};
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Class procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+VisAutosave::VisAutosave(VisGraphicsScene* scene_, VisTracePlayer* player_, QObject* parent)
+    : QObject(parent), scene(scene_), player(player_), lock(NULL), busy(0), dirty(0),
+      compact(true), checkpoints(0), journal_size(0)
+{
+    memset(&last_commit, 0, sizeof(last_commit));
+
+    QDir dir(QStandardPaths::writableLocation(QStandardPaths::DataLocation));
+    dir.mkpath(".");
+    path = dir.filePath("session.sgj");
+
+    // Otra instancia abierta conserva su journal, esta no guarda nada
+    lock = new QLockFile(path + ".lock");
+    if(not lock->tryLock(0)){
+        delete lock;
+        lock = NULL;
+    }
+
+    // Un solo hilo, los checkpoints se escriben en orden
+    pool.setMaxThreadCount(1);
+    timer.setInterval(interval);
+    connect(&timer, SIGNAL(timeout()),
+            this,   SLOT(visCheckpoint()));
+    connect(scene,  SIGNAL(visEdited(int)),
+            this,   SLOT(visSceneEdited(int)));
+}
+
+VisAutosave::~VisAutosave()
+{
+    timer.stop();
+    pool.waitForDone();
+
+    // Al salir bien no queda nada que recuperar
+    if(lock != NULL){
+        QFile::remove(path);
+        delete lock;
+    }
+}
+
+bool VisAutosave::hasJournal() const
+{
+    return isEnabled() and QFile::exists(path);
+}
+
+void VisAutosave::start()
+{
+    if(not isEnabled())
+        return;
+    dirty = VisGraphicsScene::TOPOLOGY;
+    timer.start();
+}
+
+void VisAutosave::visSceneEdited(int edits)
+{
+    dirty |= edits;
+}
+
+void VisAutosave::visCheckpoint()
+{
+    // Una traza en reproduccion no es G, se guarda al cerrarla; si el
+    // anterior sigue escribiendo se espera al siguiente tick
+    if(dirty == 0 or player->isActive() or not busy.testAndSetOrdered(0, 1))
+        return;
+
+    // Los elementos en orden solo se recorren de nuevo si cambio el grafo,
+    // de lo contrario se copian las secciones editadas
+    VisDocumentContent content;
+    if(dirty & VisGraphicsScene::TOPOLOGY)
+        VisDocument::orderOf(scene, &content, &nodes, &curves);
+    content.directed = scene->graph_type == VisGraphicsScene::DIRECTED;
+    content.next_id  = scene->id();
+    if(dirty & (VisGraphicsScene::TOPOLOGY | VisGraphicsScene::GEOMETRY))
+        VisDocument::geometryOf(nodes, curves, &content);
+    if(dirty & (VisGraphicsScene::TOPOLOGY | VisGraphicsScene::GEOMETRY | VisGraphicsScene::COLORS))
+        VisDocument::flagsOf(nodes, curves, &content);
+    if(dirty & (VisGraphicsScene::TOPOLOGY | VisGraphicsScene::LABELS))
+        VisDocument::labelsOf(nodes, curves, &content);
+
+    pool.start(new VisCheckpointTask(this, content, sectionsOf(dirty)));
+    dirty = 0;
+}
+
+bool VisAutosave::writeRecord(QIODevice* out, quint32 kind, quint32 section,
+                              const QByteArray& payload, const QByteArray& digest)
+{
+    VisJournalRecord record;
+    record.kind    = kind;
+    record.section = section;
+    record.size    = payload.size();
+    memcpy(record.digest, digest.constData(), sizeof(record.digest));
+
+    static const char padding[8] = {0};
+    int pad = aligned(payload.size()) - payload.size();
+    return out->write((const char*) &record, sizeof(record)) == sizeof(record) and
+           out->write(payload) == payload.size() and
+           out->write(padding, pad) == pad;
+}
+
+void VisAutosave::write(const VisDocumentContent& copied, quint32 copied_sections)
+{
+    // Las secciones que no se copiaron siguen como en el anterior
+    for(int s = 0; s < VisDocumentHeader::SECTION_COUNT; s++){
+        if(copied_sections & bit(s))
+            setSection(&last, s, sectionOf(copied, s));
+    }
+    last.directed = copied.directed;
+    last.next_id  = copied.next_id;
+    const VisDocumentContent& content = last;
+
+    VisJournalCommit commit;
+    commit.flags      = content.directed ? VisDocumentHeader::DIRECTED : 0;
+    commit.node_count = content.ids.size();
+    commit.edge_count = content.targets.size();
+    commit.next_id    = content.next_id;
+
+    QByteArray sections[VisDocumentHeader::SECTION_COUNT];
+    QByteArray digests_now[VisDocumentHeader::SECTION_COUNT];
+    QList<int> changed;
+    qint64 image_size = sizeof(VisJournalHeader);
+    for(int s = 0; s < VisDocumentHeader::SECTION_COUNT; s++){
+        sections[s]    = sectionOf(content, s);
+        digests_now[s] = copied_sections & bit(s) ? digestOf(sections[s]) : digests[s];
+        image_size    += sizeof(VisJournalRecord) + aligned(sections[s].size());
+        if(digests_now[s] != digests[s])
+            changed.append(s);
+    }
+    if(not compact and changed.isEmpty() and memcmp(&commit, &last_commit, sizeof(commit)) == 0)
+        return;
+
+    if(checkpoints >= max_checkpoints or journal_size > compact_ratio*image_size)
+        compact = true;
+
+    QByteArray commit_bytes((const char*) &commit, sizeof(commit));
+    bool ok;
+    qint64 written = 0;
+    if(compact){
+        // El journal nuevo solo reemplaza al anterior si quedo completo
+        QSaveFile out(path);
+        VisJournalHeader header;
+        memcpy(header.magic, journal_magic, sizeof(journal_magic));
+        header.byte_order = VisDocument::byte_order;
+        header.version    = version;
+        header.reserved   = 0;
+        ok = out.open(QIODevice::WriteOnly) and
+             out.write((const char*) &header, sizeof(header)) == sizeof(header);
+        for(int s = 0; ok and s < VisDocumentHeader::SECTION_COUNT; s++)
+            ok = writeRecord(&out, VisJournalRecord::SECTION, s, sections[s], digests_now[s]);
+        ok = ok and writeRecord(&out, VisJournalRecord::COMMIT, 0, commit_bytes, digestOf(commit_bytes));
+        ok = ok and out.commit();
+        written = out.size();
+        if(ok){
+            journal_size = written;
+            checkpoints  = 0;
+        }
+    }else{
+        QFile out(path);
+        ok = out.open(QIODevice::WriteOnly | QIODevice::Append);
+        foreach(int s, changed){
+            if(not ok)
+                break;
+            ok = writeRecord(&out, VisJournalRecord::SECTION, s, sections[s], digests_now[s]);
+        }
+        ok = ok and writeRecord(&out, VisJournalRecord::COMMIT, 0, commit_bytes, digestOf(commit_bytes));
+        ok = ok and out.flush();
+        journal_size = out.size();
+        checkpoints++;
+    }
+
+    if(not ok){
+        // Lo escrito a medias no tiene commit; la proxima vez se reescribe
+        qWarning() << "Autosave failed:" << path;
+        compact = true;
+        return;
+    }
+    compact = false;
+    last_commit = commit;
+    for(int s = 0; s < VisDocumentHeader::SECTION_COUNT; s++)
+        digests[s] = digests_now[s];
+}
+
+bool VisAutosave::restore(VisDocumentContent* content, QString* error)
+{
+    QFile file(path);
+    if(not file.open(QIODevice::ReadOnly)){
+        *error = file.errorString();
+        return false;
+    }
+    qint64 size = file.size();
+    const uchar* data = size > 0 ? file.map(0, size) : NULL;
+    if(data == NULL or size < (qint64) sizeof(VisJournalHeader)){
+        *error = "The session journal is empty or can not be read";
+        return false;
+    }
+
+    const VisJournalHeader* header = (const VisJournalHeader*) data;
+    if(memcmp(header->magic, journal_magic, sizeof(journal_magic)) != 0 or
+       header->byte_order != VisDocument::byte_order or header->version != version){
+        *error = "The session journal was written by another version";
+        return false;
+    }
+
+    // Las secciones solo cuentan cuando su checkpoint tiene commit; un
+    // registro cortado o alterado termina la lectura
+    QByteArray staged[VisDocumentHeader::SECTION_COUNT];
+    QByteArray committed[VisDocumentHeader::SECTION_COUNT];
+    bool touched[VisDocumentHeader::SECTION_COUNT] = {false};
+    VisJournalCommit commit;
+    bool has_commit = false;
+
+    qint64 pos = sizeof(VisJournalHeader);
+    while(pos + (qint64) sizeof(VisJournalRecord) <= size){
+        const VisJournalRecord* record = (const VisJournalRecord*) (data+pos);
+        qint64 end = pos + sizeof(VisJournalRecord) + record->size;
+        if(record->size > (quint64) size or end > size)
+            break;
+        QByteArray payload = QByteArray::fromRawData((const char*) (record+1), record->size);
+        if(memcmp(digestOf(payload).constData(), record->digest, sizeof(record->digest)) != 0)
+            break;
+
+        if(record->kind == VisJournalRecord::SECTION and record->section < VisDocumentHeader::SECTION_COUNT){
+            staged[record->section]  = payload;
+            touched[record->section] = true;
+        }else if(record->kind == VisJournalRecord::COMMIT and payload.size() == sizeof(commit)){
+            memcpy(&commit, payload.constData(), sizeof(commit));
+            for(int s = 0; s < VisDocumentHeader::SECTION_COUNT; s++){
+                if(touched[s])
+                    committed[s] = staged[s];
+                touched[s] = false;
+            }
+            has_commit = true;
+        }else{
+            break;
+        }
+        pos = aligned(end);
+    }
+
+    if(has_commit){
+        content->directed = commit.flags & VisDocumentHeader::DIRECTED;
+        content->next_id  = commit.next_id;
+        for(int s = 0; s < VisDocumentHeader::SECTION_COUNT; s++)
+            setSection(content, s, committed[s]);
+    }
+    file.unmap((uchar*) data);
+
+    if(not has_commit){
+        *error = "The session journal holds no complete checkpoint";
+        return false;
+    }
+    if(not consistent(*content, commit.node_count, commit.edge_count)){
+        *error = "The session journal is inconsistent";
+        return false;
+    }
+    return true;
+}
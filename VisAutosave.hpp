@@ -0,0 +1,121 @@
+#ifndef VISAUTOSAVE_HPP
+#define VISAUTOSAVE_HPP
+
+// Parent class
+#include <QObject>
+
+// Member classes
+#include <QTimer>
+#include <QThreadPool>
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QString>
+#include <VisDocument.hpp>
+
+class QIODevice;
+class QLockFile;
+class VisGraphicsScene;
+class VisTracePlayer;
+class VisNode;
+class VisBezierCurve;
+
+// Start of the session journal
+struct VisJournalHeader
+{
+    char    magic[4];
+    quint32 byte_order;
+    quint32 version;
+    quint32 reserved;
+};
+
+// Record of the journal, followed by size bytes padded to 8. A section
+// record carries one document section, a commit record closes the
+// checkpoint that wrote the sections before it.
+struct VisJournalRecord
+{
+    enum KIND {SECTION, COMMIT};
+
+    quint32 kind;
+    quint32 section;
+    quint64 size;
+    char    digest[16];   // MD5 of the payload
+};
+
+struct VisJournalCommit
+{
+    quint32 flags;        // VisDocumentHeader::FLAGS
+    quint32 node_count;
+    quint32 edge_count;
+    qint32  next_id;
+};
+
+// Keeps the session in a journal while the application runs and deletes it
+// on a clean exit, so a journal found at startup was left by a crash.
+//
+// The scene reports what its edits changed; the GUI thread copies only the
+// document sections those edits touched, and nothing while a trace is
+// replayed. A single background thread keeps the other sections from the
+// checkpoint before, compares the copied ones with what it wrote and
+// appends the sections that differ, followed by a commit record. The
+// journal is rewritten with only the current sections after
+// max_checkpoints checkpoints or once it grows compact_ratio times larger
+// than a full image.
+class VisAutosave : public QObject
+{
+    Q_OBJECT
+
+public:
+    const static int     interval        = 30000;
+    const static int     max_checkpoints = 64;
+    const static int     compact_ratio   = 4;
+    const static quint32 version         = 1;
+
+    VisAutosave(VisGraphicsScene* scene, VisTracePlayer* player, QObject* parent = 0);
+    ~VisAutosave();
+
+    // False when another instance holds the journal
+    bool isEnabled() const { return lock != NULL; }
+    bool hasJournal() const;
+
+    // Last complete checkpoint of the journal left behind
+    bool restore(VisDocumentContent* content, QString* error);
+
+    // Checkpoints begin here, the first one replaces the old journal
+    void start();
+
+    // Called by the writer thread, copied_sections has a bit for each
+    // section copied
+    void write(const VisDocumentContent& copied, quint32 copied_sections);
+    void writeDone() { busy.store(0); }
+
+private slots:
+    void visSceneEdited(int edits);
+    void visCheckpoint();
+
+private:
+    VisGraphicsScene* scene;
+    VisTracePlayer*   player;
+    QString           path;
+    QLockFile*        lock;
+    QTimer            timer;
+    QThreadPool       pool;
+    QAtomicInt        busy;
+    int               dirty;
+
+    // Items in document order as of the last topology copy
+    QVector<VisNode*>        nodes;
+    QVector<VisBezierCurve*> curves;
+
+    // Only used by the writer thread
+    VisDocumentContent last;
+    QByteArray        digests[VisDocumentHeader::SECTION_COUNT];
+    VisJournalCommit  last_commit;
+    bool              compact;
+    int               checkpoints;
+    qint64            journal_size;
+
+    bool writeRecord(QIODevice* out, quint32 kind, quint32 section,
+                     const QByteArray& payload, const QByteArray& digest);
+};
+
+#endif // VISAUTOSAVE_HPP
@@ -0,0 +1,675 @@
+#include "VisBatch.hpp"
+
+#include "Environment.hpp"
+#include "VisSchemeExecutor.hpp"
+#include "VisDocument.hpp"
+#include "VisImporter.hpp"
+#include "VisResultWriter.hpp"
+
+#include <QCoreApplication>
+#include <QCommandLineParser>
+#include <QThreadStorage>
+#include <QThread>
+#include <QFileInfo>
+#include <QDir>
+#include <QSet>
+#include <QFile>
+#include <QSaveFile>
+#include <QTextStream>
+#include <QRegExp>
+#include <QJsonArray>
+#include <QJsonObject>
+#include <QJsonDocument>
+#include <QtDebug>
+
+#include <cstdio>
+#include <cstring>
+#include <cstdlib>
+
+#define SCM_DEFUNC(NAME, ARGS, PROC) scm_c_define_gsubr(NAME, ARGS, 0, 0, ((scm_t_subr) PROC ))
+
+static VisBatch* batch = NULL;
+
+// Tarea que resuelve cada worker, para los mensajes del algoritmo
+static QThreadStorage<int> current_task;
+
+static const VisBatch::Algorithm algorithms[] = {
+    {"bipartiteness",     "bipartiteness",     "run-bipartiteness",                 false, VisBatch::NONE,           VisBatch::NO_PARAMS},
+    {"spanning-tree-bfs", "spanning-tree-bfs", "run-spanning-tree-bfs",             false, VisBatch::NONE,           VisBatch::ROOT},
+    {"spanning-tree-dfs", "spanning-tree-dfs", "run-spanning-tree-dfs",             false, VisBatch::NONE,           VisBatch::ROOT},
+    {"prim",              "prim",              "run-prim",                          false, VisBatch::WEIGHT,         VisBatch::ROOT},
+    {"kruskal",           "kruskal",           "run-kruskal",                       false, VisBatch::WEIGHT,         VisBatch::NO_PARAMS},
+    {"dijkstra",          "dijkstra",          "run-dijkstra",                      true,  VisBatch::DISTANCE,       VisBatch::PATH},
+    {"floyd-warshall",    "floyd-warshall",    "run-floyd-warshall",                true,  VisBatch::DISTANCE,       VisBatch::NO_PARAMS},
+    {"ford-fulkerson",    "ford-fulkerson",    "run-ford-fulkerson",                true,  VisBatch::FORD_FULKERSON, VisBatch::FLOW},
+    {"minimum-cost-nc",   "minimum-cost-nc",   "run-minimum-cost-constant-flow-nc", true,  VisBatch::MIN_COST_NC,    VisBatch::FIXED_FLOW},
+    {"minimum-cost-sp",   "minimum-cost-sp",   "run-minimum-cost-constant-flow-sp", true,  VisBatch::MIN_COST_SP,    VisBatch::FIXED_FLOW}
+};
+static const int algorithm_count = sizeof(algorithms)/sizeof(algorithms[0]);
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Foreign language procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+
+// Guile reserva la cadena con malloc
+static QString stringOf(SCM str)
+{
+    char* text = scm_to_utf8_string(str);
+    QString result = QString::fromUtf8(text);
+    free(text);
+    return result;
+}
+
+// Sin escena los primitivos de dibujo no hacen nada
+static SCM scmIgnore0()                                   { return SCM_UNSPECIFIED; }
+static SCM scmIgnore1(SCM)                                { return SCM_UNSPECIFIED; }
+static SCM scmIgnore2(SCM, SCM)                           { return SCM_UNSPECIFIED; }
+static SCM scmIgnore3(SCM, SCM, SCM)                      { return SCM_UNSPECIFIED; }
+static SCM scmIgnore5(SCM, SCM, SCM, SCM, SCM)            { return SCM_UNSPECIFIED; }
+static SCM scmIgnore6(SCM, SCM, SCM, SCM, SCM, SCM)       { return SCM_UNSPECIFIED; }
+
+static SCM scmBatchShowMessage(SCM message)
+{
+    batch->message(stringOf(message));
+    return SCM_UNSPECIFIED;
+}
+
+static SCM scmBatchReload(SCM file)
+{
+    char* path = scm_to_locale_string(file);
+    QString name(path);
+    free(path);
+    Environment::evalFile(name);
+    return SCM_UNSPECIFIED;
+}
+
+static SCM scmBatchPosNode(SCM)
+{
+    return scm_cons(scm_from_double(0), scm_from_double(0));
+}
+
+static SCM scmBatchGraph(SCM index)
+{
+    return batch->graph(scm_to_int(index));
+}
+
+static SCM scmBatchArguments(SCM index)
+{
+    return batch->arguments(scm_to_int(index));
+}
+
+static SCM scmBatchResult(SCM index, SCM value)
+{
+    batch->result(scm_to_int(index), value);
+    return SCM_UNSPECIFIED;
+}
+
+static SCM scmBatchError(SCM index, SCM error)
+{
+    batch->fail(scm_to_int(index), stringOf(scm_object_to_string(error, SCM_UNDEFINED)));
+    return SCM_UNSPECIFIED;
+}
+
+static SCM scmFromIntList(const QList<int>& values)
+{
+    SCM list = SCM_EOL;
+    for(int i = values.size()-1; i >= 0; i--)
+        list = scm_cons(scm_from_int(values[i]), list);
+    return list;
+}
+
+static QList<int> intsOf(const QString& text, bool* ok)
+{
+    QList<int> values;
+    *ok = true;
+    foreach(const QString& value, text.split(",", QString::SkipEmptyParts)){
+        values.append(value.trimmed().toInt(ok));
+        if(not *ok)
+            break;
+    }
+    return values;
+}
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Class procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+VisBatch::VisBatch(QObject* parent)
+    : QObject(parent), algorithm(NULL), executor(NULL), pending(0), root(-1)
+{
+    batch = this;
+}
+
+VisBatch::~VisBatch()
+{
+    delete executor;
+    qDeleteAll(tasks);
+    batch = NULL;
+}
+
+bool VisBatch::requested(int argc, char* argv[])
+{
+    for(int i = 1; i < argc; i++){
+        if(strcmp(argv[i], "--batch") == 0 or strncmp(argv[i], "--batch=", 8) == 0)
+            return true;
+    }
+    return false;
+}
+
+int VisBatch::run(const QStringList& arguments)
+{
+    QCommandLineParser parser;
+    parser.setApplicationDescription("Runs an algorithm on graph files without a window.");
+    parser.addHelpOption();
+    QCommandLineOption batch_option("batch", "Algorithm to run.", "algorithm");
+    QCommandLineOption sources_option("sources", "Comma separated source vertices.", "list");
+    QCommandLineOption sinks_option("sinks", "Comma separated sink vertices.", "list");
+    QCommandLineOption flow_option("flow", "Flow to send, the maximum flow when omitted.", "flow");
+    QCommandLineOption root_option("root", "Root vertex of spanning trees.", "vertex");
+    QCommandLineOption format_option("format", "Result format, csv or json.", "format");
+    QCommandLineOption output_option("output", "Result file, standard output when omitted.", "file");
+    QCommandLineOption jobs_option("jobs", "Files solved at the same time.", "count",
+                                   QString::number(QThread::idealThreadCount()));
+    parser.addOption(batch_option);
+    parser.addOption(sources_option);
+    parser.addOption(sinks_option);
+    parser.addOption(flow_option);
+    parser.addOption(root_option);
+    parser.addOption(format_option);
+    parser.addOption(output_option);
+    parser.addOption(jobs_option);
+    QCommandLineOption results_option("results", "Directory for the result tables of each file.", "directory");
+    QCommandLineOption columnar_option("columnar", "Write the result tables as columnar .sgr files.");
+    QCommandLineOption mapped_option("mapped", "Write the columnar tables through a mapped file.");
+    parser.addOption(results_option);
+    parser.addOption(columnar_option);
+    parser.addOption(mapped_option);
+    parser.addPositionalArgument("inputs", "Graph files or directories holding them.", "FILE|DIRECTORY...");
+    parser.process(arguments);
+
+    QString name = parser.value(batch_option);
+    for(int i = 0; i < algorithm_count and algorithm == NULL; i++){
+        if(name == algorithms[i].name)
+            algorithm = &algorithms[i];
+    }
+    if(algorithm == NULL){
+        QStringList names;
+        for(int i = 0; i < algorithm_count; i++)
+            names.append(algorithms[i].name);
+        qCritical() << "Unknown algorithm" << name << "- expected one of:" << names.join(", ");
+        return 2;
+    }
+
+    QString output = parser.value(output_option);
+    QString format = parser.value(format_option).toLower();
+    if(format.isEmpty())
+        format = QFileInfo(output).suffix().toLower() == "json" ? "json" : "csv";
+    if(format != "csv" and format != "json"){
+        qCritical() << "Unknown result format" << format;
+        return 2;
+    }
+
+    bool ok = true;
+    QList<int> sources = intsOf(parser.value(sources_option), &ok);
+    QList<int> sinks;
+    if(ok)
+        sinks = intsOf(parser.value(sinks_option), &ok);
+    double flow = -1;
+    if(ok and parser.isSet(flow_option))
+        flow = parser.value(flow_option).toDouble(&ok);
+    if(ok and parser.isSet(root_option))
+        root = parser.value(root_option).toInt(&ok);
+    int jobs = 1;
+    if(ok)
+        jobs = parser.value(jobs_option).toInt(&ok);
+    if(not ok or jobs < 1){
+        qCritical() << "Invalid vertex list, flow, root or job count";
+        return 2;
+    }
+    if(algorithm->params == ROOT and root < 0){
+        qCritical() << name << "needs --root";
+        return 2;
+    }
+
+    QStringList inputs = inputsOf(parser.positionalArguments());
+    if(inputs.isEmpty()){
+        qCritical() << "No graph files given";
+        return 2;
+    }
+
+    QDir results(parser.value(results_option));
+    if(parser.isSet(results_option) and not results.mkpath(".")){
+        qCritical() << "Could not create" << results.path();
+        return 2;
+    }
+    QString suffix = parser.isSet(columnar_option) ? ".sgr" : ".csv";
+    QSet<QString> result_files;
+
+    foreach(const QString& path, inputs){
+        VisBatchTask* task = new VisBatchTask;
+        task->path    = path;
+        task->sources = sources;
+        task->sinks   = sinks;
+        task->flow    = flow;
+        if(parser.isSet(results_option)){
+            // Archivos de directorios distintos pueden llamarse igual
+            QString base = QFileInfo(path).completeBaseName();
+            QString file = base + suffix;
+            for(int n = 2; result_files.contains(file); n++)
+                file = base + "-" + QString::number(n) + suffix;
+            result_files.insert(file);
+            task->result_file = results.filePath(file);
+        }
+        tasks.append(task);
+    }
+
+    initForeign();
+    executor = new VisSchemeExecutor(scm_current_module(), qMin(jobs, tasks.size()));
+    connect(executor, SIGNAL(visJobFinished(int,int)),
+            this,     SLOT(visJobFinished(int,int)));
+
+    // Cada trabajo lee su archivo y resuelve el problema en el mismo worker
+    pending = tasks.size();
+    for(int i = 0; i < tasks.size(); i++){
+        QString k = QString::number(i);
+        QString code = QString("(let ((G (cpp-batch-graph ") + k + QString("))) "
+                               "(when G (catch #t "
+                               "(lambda () (cpp-batch-result! ") + k + QString(" (apply ") +
+                       algorithm->procedure + QString(" G (cpp-batch-arguments ") + k + QString(")))) "
+                               "(lambda error (cpp-batch-error! ") + k + QString(" error)))))");
+        if(not tasks[i]->result_file.isEmpty())
+            code = QString("(parameterize ((result-file ") + scmQuote(tasks[i]->result_file) +
+                   QString(") (result-mapped ") + QString(parser.isSet(mapped_option) ? "#true" : "#false") +
+                   QString(")) ") + code + QString(")");
+        job_tasks.insert(executor->submit(code), i);
+    }
+    QCoreApplication::exec();
+
+    if(not write(output, format))
+        return 2;
+    foreach(VisBatchTask* task, tasks){
+        if(task->status != "finished")
+            return 1;
+    }
+    return 0;
+}
+
+void VisBatch::initForeign()
+{
+    scm_init_guile();
+
+    // init.scm tambien abre el servidor REPL, aqui solo se cargan los modulos
+    scm_c_eval_string((QString("(set! %load-compiled-path (cons \"") +
+                       QCoreApplication::applicationDirPath() +
+                       QString("\" %load-compiled-path))")).toStdString().data());
+    scm_c_eval_string("(add-to-load-path (getcwd))");
+    scm_c_eval_string("(use-modules (oop goops) (grafo graph) (grafo utils) (srfi srfi-1) (ice-9 q) (srfi srfi-43))");
+
+    SCM_DEFUNC("cpp-paint-node!", 3,          scmIgnore3);
+    SCM_DEFUNC("cpp-unpaint-node!", 1,        scmIgnore1);
+    SCM_DEFUNC("cpp-paint-edge!", 2,          scmIgnore2);
+    SCM_DEFUNC("cpp-unpaint-edge!", 2,        scmIgnore2);
+    SCM_DEFUNC("cpp-paint-arrow!", 2,         scmIgnore2);
+    SCM_DEFUNC("cpp-unpaint-arrow!", 2,       scmIgnore2);
+    SCM_DEFUNC("cpp-label-node!", 2,          scmIgnore2);
+    SCM_DEFUNC("cpp-label-edge!", 3,          scmIgnore3);
+    SCM_DEFUNC("cpp-label-arrow!", 3,         scmIgnore3);
+    SCM_DEFUNC("cpp-color-node!", 5,          scmIgnore5);
+    SCM_DEFUNC("cpp-uncolor-node!", 1,        scmIgnore1);
+    SCM_DEFUNC("cpp-color-edge!", 6,          scmIgnore6);
+    SCM_DEFUNC("cpp-uncolor-edge!", 2,        scmIgnore2);
+    SCM_DEFUNC("cpp-color-arrow!", 6,         scmIgnore6);
+    SCM_DEFUNC("cpp-uncolor-arrow!", 2,       scmIgnore2);
+    SCM_DEFUNC("cpp-color-node-label!", 5,    scmIgnore5);
+    SCM_DEFUNC("cpp-uncolor-node-label!", 1,  scmIgnore1);
+    SCM_DEFUNC("cpp-color-edge-label!", 6,    scmIgnore6);
+    SCM_DEFUNC("cpp-uncolor-edge-label!", 2,  scmIgnore2);
+    SCM_DEFUNC("cpp-color-arrow-label!", 6,   scmIgnore6);
+    SCM_DEFUNC("cpp-uncolor-arrow-label!", 2, scmIgnore2);
+    SCM_DEFUNC("cpp-wait!", 1,                scmIgnore1);
+    SCM_DEFUNC("cpp-show-message!", 1,        scmBatchShowMessage);
+    SCM_DEFUNC("cpp-clear-graph!", 0,         scmIgnore0);
+    SCM_DEFUNC("cpp-batch-begin!", 0,         scmIgnore0);
+    SCM_DEFUNC("cpp-batch-commit!", 0,        scmIgnore0);
+    SCM_DEFUNC("cpp-reload!", 1,              scmBatchReload);
+    SCM_DEFUNC("cpp-pos-node", 1,             scmBatchPosNode);
+    SCM_DEFUNC("cpp-move-node!", 3,           scmIgnore3);
+    SCM_DEFUNC("cpp-batch-graph", 1,          scmBatchGraph);
+    SCM_DEFUNC("cpp-batch-arguments", 1,      scmBatchArguments);
+    SCM_DEFUNC("cpp-batch-result!", 2,        scmBatchResult);
+    SCM_DEFUNC("cpp-batch-error!", 2,         scmBatchError);
+    VisResultWriter::defineProcedures();
+
+    Environment::evalFile("vis-graph.scm");
+    Environment::evalFile("algorithms.scm");
+
+    // Los mensajes de los pasos ni siquiera se arman
+    scm_c_eval_string("(define (wait! . msg) *unspecified*)");
+
+    // Se carga antes de lanzar los trabajos, require-algorithm! no es
+    // seguro entre hilos
+    scm_call_1(scm_variable_ref(scm_c_lookup("require-algorithm!")),
+               scm_from_locale_string(algorithm->file));
+}
+
+QStringList VisBatch::inputsOf(const QStringList& paths)
+{
+    QStringList filters;
+    filters << "*.sgv" << "*.txt" << "*.edges" << "*.el" << "*.max" << "*.min" << "*.dimacs"
+            << "*.inp" << "*.mtx" << "*.graphml" << "*.gexf";
+
+    QStringList inputs;
+    foreach(const QString& path, paths){
+        QFileInfo info(path);
+        if(not info.isDir()){
+            inputs.append(path);
+            continue;
+        }
+        QDir dir(path);
+        foreach(const QString& file, dir.entryList(filters, QDir::Files, QDir::Name))
+            inputs.append(dir.filePath(file));
+    }
+    return inputs;
+}
+
+SCM VisBatch::graph(int index)
+{
+    VisBatchTask* task = tasks[index];
+    current_task.setLocalData(index);
+
+    QElapsedTimer load;
+    load.start();
+
+    VisDocument document;
+    if(QFileInfo(task->path).suffix().toLower() == "sgv"){
+        if(not document.open(task->path)){
+            task->error = document.errorString();
+            return SCM_BOOL_F;
+        }
+    }else{
+        // El contenido se libera en cuanto el documento tiene su copia
+        VisImporter importer;
+        VisDocumentContent content;
+        if(not importer.import(task->path, VisImporter::formatOf(task->path), algorithm->directed, &content)){
+            task->error = importer.errorString();
+            return SCM_BOOL_F;
+        }
+        if(not document.open(content)){
+            task->error = document.errorString();
+            return SCM_BOOL_F;
+        }
+        // El problema del archivo vale si la linea de ordenes no da otro
+        if(task->sources.isEmpty() and task->sinks.isEmpty()){
+            task->sources = importer.sources;
+            task->sinks   = importer.sinks;
+        }
+        if(task->flow < 0 and importer.flow > 0)
+            task->flow = importer.flow;
+    }
+
+    if(document.directed() != algorithm->directed){
+        task->error = algorithm->directed ? "The algorithm needs a directed graph"
+                                          : "The algorithm needs an undirected graph";
+        return SCM_BOOL_F;
+    }
+    switch(algorithm->params){
+    case PATH:
+    case FLOW:
+        if(task->sources.isEmpty() or task->sinks.isEmpty()){
+            task->error = "No sources or sinks given";
+            return SCM_BOOL_F;
+        }
+        break;
+    case FIXED_FLOW:
+        if(task->sources.isEmpty() or task->sinks.isEmpty() or task->flow < 0){
+            task->error = "No sources, sinks or flow given";
+            return SCM_BOOL_F;
+        }
+        break;
+    default:
+        break;
+    }
+
+    quint32 n = document.nodeCount();
+    quint32 m = document.edgeCount();
+    QVector<qint32> ids(n);
+    memcpy(ids.data(), document.ids, n*sizeof(qint32));
+    QVector<qint32> sources;
+    QVector<qint32> targets;
+    sources.reserve(m);
+    targets.reserve(m);
+    for(quint32 i = 0; i < n; i++){
+        // Como VisGraphicsScene::visLoadDocument, se saltan los indices
+        // fuera de rango de un archivo dañado
+        for(quint32 e = document.rows[i]; e < document.rows[i+1] and e < m; e++){
+            quint32 j = document.targets[e];
+            if(j >= n)
+                continue;
+            sources.append(document.ids[i]);
+            targets.append(document.ids[j]);
+        }
+    }
+
+    SCM g = scm_call_1(scm_variable_ref(scm_c_lookup("make")),
+                       scm_variable_ref(scm_c_lookup(algorithm->directed ? "<directed-graph>"
+                                                                         : "<undirected-graph>")));
+    scm_call_4(scm_variable_ref(scm_c_lookup("load-graph!")), g,
+               scmFromInts(ids), scmFromInts(sources), scmFromInts(targets));
+
+    QString error;
+    if(not setAttributes(g, document, &error)){
+        task->error = error;
+        return SCM_BOOL_F;
+    }
+
+    task->vertices = n;
+    task->edges    = sources.size();
+    task->load_ms  = load.elapsed();
+    task->timer.start();
+    return g;
+}
+
+// Las etiquetas se leen como lo hace el entorno antes de cada algoritmo
+bool VisBatch::setAttributes(SCM g, const VisDocument& document, QString* error)
+{
+    if(algorithm->labels == NONE)
+        return true;
+
+    SCM add      = scm_variable_ref(scm_c_lookup("add-atribute!"));
+    SCM q_max    = scm_from_utf8_keyword("q-max");
+    SCM q_min    = scm_from_utf8_keyword("q-min");
+    SCM cost     = scm_from_utf8_keyword("cost");
+    SCM distance = scm_from_utf8_keyword(algorithm->labels == WEIGHT ? "weight" : "distance");
+
+    quint32 n = document.nodeCount();
+    quint32 m = document.edgeCount();
+    for(quint32 i = 0; i < n; i++){
+        for(quint32 e = document.rows[i]; e < document.rows[i+1] and e < m; e++){
+            if(document.targets[e] >= n)
+                continue;
+            qint32  aid   = document.ids[i];
+            qint32  bid   = document.ids[document.targets[e]];
+            SCM     item  = scm_list_2(scm_from_int(aid), scm_from_int(bid));
+            QString label = document.edgeLabel(e);
+            QStringList lst = label.split(",", QString::SkipEmptyParts);
+            QString where = QString("edge ") + QString::number(aid) + QString("-") + QString::number(bid);
+
+            switch(algorithm->labels){
+            case WEIGHT:
+            case DISTANCE:{
+                SCM value = scm_string_to_number(scm_from_utf8_string(label.trimmed().toUtf8().constData()),
+                                                 SCM_UNDEFINED);
+                if(scm_is_false(value)){
+                    *error = where + QString(" has no numeric label");
+                    return false;
+                }
+                scm_call_4(add, g, item, distance, value);
+                break;
+            }
+            case FORD_FULKERSON:
+                if(lst.size() == 0){
+                    scm_call_4(add, g, item, q_max, scm_from_double(0));
+                }else if(lst.size() == 1){
+                    scm_call_4(add, g, item, q_max, scm_from_double(lst[0].toDouble()));
+                }else{
+                    scm_call_4(add, g, item, q_max, scm_from_double(lst[1].toDouble()));
+                    scm_call_4(add, g, item, q_min, scm_from_double(lst[0].toDouble()));
+                }
+                break;
+            case MIN_COST_NC:
+            case MIN_COST_SP:{
+                // "r,q,$c" o "q,$c"
+                if(lst.size() < 2){
+                    *error = where + QString(" needs a capacity and a cost");
+                    return false;
+                }
+                int k = 0;
+                if(algorithm->labels == MIN_COST_NC and lst.size() >= 3){
+                    k = 1;
+                    scm_call_4(add, g, item, q_min, scm_from_double(lst[0].toDouble()));
+                }
+                scm_call_4(add, g, item, q_max, scm_from_double(lst[k].toDouble()));
+                scm_call_4(add, g, item, cost, scm_from_double(lst[k+1].remove(0,1).toDouble()));
+                break;
+            }
+            default:
+                break;
+            }
+        }
+    }
+
+    // Capacidades de los vertices, "q" o "r,q"
+    if(algorithm->labels == FORD_FULKERSON or algorithm->labels == MIN_COST_NC){
+        for(quint32 i = 0; i < document.nodeCount(); i++){
+            QStringList lst = document.nodeLabel(i).split(",", QString::SkipEmptyParts);
+            SCM item = scm_from_int(document.ids[i]);
+            if(lst.size() == 1){
+                scm_call_4(add, g, item, q_max, scm_from_double(lst[0].toDouble()));
+            }else if(lst.size() > 1){
+                scm_call_4(add, g, item, q_max, scm_from_double(lst[1].toDouble()));
+                scm_call_4(add, g, item, q_min, scm_from_double(lst[0].toDouble()));
+            }
+        }
+    }
+    return true;
+}
+
+SCM VisBatch::arguments(int index)
+{
+    VisBatchTask* task = tasks[index];
+    switch(algorithm->params){
+    case ROOT:
+        return scm_list_1(scm_from_int(root));
+    case PATH:
+        return scm_list_2(scm_from_int(task->sources.first()), scm_from_int(task->sinks.first()));
+    case FLOW:
+        if(task->flow < 0)
+            return scm_list_2(scmFromIntList(task->sources), scmFromIntList(task->sinks));
+        // El flujo dado se pasa igual que el fijo
+        return scm_list_3(scmFromIntList(task->sources), scmFromIntList(task->sinks),
+                          scm_from_double(task->flow));
+    case FIXED_FLOW:
+        return scm_list_3(scmFromIntList(task->sources), scmFromIntList(task->sinks),
+                          scm_from_double(task->flow));
+    default:
+        return SCM_EOL;
+    }
+}
+
+void VisBatch::result(int index, SCM value)
+{
+    VisBatchTask* task = tasks[index];
+    task->run_ms = task->timer.elapsed();
+    if(not scm_is_eq(value, SCM_UNSPECIFIED))
+        task->result = stringOf(scm_object_to_string(value, SCM_UNDEFINED));
+}
+
+void VisBatch::fail(int index, const QString& error)
+{
+    VisBatchTask* task = tasks[index];
+    task->run_ms = task->timer.elapsed();
+    task->error  = error;
+}
+
+void VisBatch::message(const QString& text)
+{
+    if(current_task.hasLocalData())
+        tasks[current_task.localData()]->messages.append(text);
+}
+
+void VisBatch::visJobFinished(int job, int status)
+{
+    VisBatchTask* task = tasks[job_tasks.take(job)];
+    if(status == VisSchemeExecutor::CANCELLED)
+        task->status = "cancelled";
+    else if(status == VisSchemeExecutor::FAILED or not task->error.isEmpty())
+        task->status = "failed";
+    else
+        task->status = "finished";
+
+    qDebug().nospace() << qPrintable(task->path) << ": " << qPrintable(task->status);
+    if(--pending == 0)
+        QCoreApplication::quit();
+}
+
+static QString csvField(QString text)
+{
+    if(not text.contains(QRegExp("[\",\n\r]")))
+        return text;
+    return QString("\"") + text.replace("\"", "\"\"") + QString("\"");
+}
+
+bool VisBatch::write(const QString& path, const QString& format)
+{
+    QByteArray bytes;
+    if(format == "json"){
+        QJsonArray results;
+        foreach(VisBatchTask* task, tasks){
+            QJsonObject object;
+            object["file"]      = task->path;
+            object["algorithm"] = QString(algorithm->name);
+            object["status"]    = task->status;
+            object["vertices"]  = task->vertices;
+            object["edges"]     = task->edges;
+            object["load_ms"]   = (double) task->load_ms;
+            object["run_ms"]    = (double) task->run_ms;
+            object["result"]    = task->result;
+            object["messages"]  = QJsonArray::fromStringList(task->messages);
+            object["error"]     = task->error;
+            object["results"]   = task->result_file;
+            results.append(object);
+        }
+        bytes = QJsonDocument(results).toJson();
+    }else{
+        QTextStream out(&bytes);
+        out.setCodec("UTF-8");
+        out << "file,algorithm,status,vertices,edges,load_ms,run_ms,result,messages,error,results\n";
+        foreach(VisBatchTask* task, tasks){
+            out << csvField(task->path) << ',' << algorithm->name << ',' << task->status << ','
+                << task->vertices << ',' << task->edges << ',' << task->load_ms << ','
+                << task->run_ms << ',' << csvField(task->result) << ','
+                << csvField(task->messages.join("\n")) << ',' << csvField(task->error) << ','
+                << csvField(task->result_file) << '\n';
+        }
+    }
+
+    if(path.isEmpty()){
+        QFile out;
+        out.open(stdout, QIODevice::WriteOnly);
+        out.write(bytes);
+        return true;
+    }
+    QSaveFile file(path);
+    if(not file.open(QIODevice::WriteOnly) or file.write(bytes) != bytes.size() or not file.commit()){
+        qCritical() << "Could not write" << path << "-" << file.errorString();
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,106 @@
+#ifndef VISBATCH_HPP
+#define VISBATCH_HPP
+
+// Parent class
+#include <QObject>
+
+// Member classes
+#include <QList>
+#include <QHash>
+#include <QString>
+#include <QStringList>
+#include <QElapsedTimer>
+
+// Foreign language includes
+#include <libguile.h>
+
+class VisSchemeExecutor;
+class VisDocument;
+
+// One input file of a batch run and what became of it
+struct VisBatchTask
+{
+    QString     path;
+    QString     status;
+    QString     error;
+    QString     result;
+    QString     result_file;
+    QStringList messages;
+
+    // Flow problem given on the command line or by a DIMACS file
+    QList<int> sources;
+    QList<int> sinks;
+    double     flow;
+
+    int    vertices;
+    int    edges;
+    qint64 load_ms;
+    qint64 run_ms;
+    QElapsedTimer timer;
+
+    VisBatchTask() : flow(-1), vertices(0), edges(0), load_ms(0), run_ms(0) {}
+};
+
+// Headless mode: runs one algorithm on every input file with no window and
+// no scene. Drawing primitives and cpp-wait! do nothing, the inputs are
+// read and solved in parallel by a pool of Scheme workers and the results
+// are written as CSV or JSON once every file is done.
+//
+// With --results every file also gets the result tables of its run, see
+// VisResultWriter.
+//
+//   SchemeGrafoVis --batch ALGORITHM [options] FILE|DIRECTORY...
+class VisBatch : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum LABELS {NONE, WEIGHT, DISTANCE, FORD_FULKERSON, MIN_COST_NC, MIN_COST_SP};
+    enum PARAMS {NO_PARAMS, ROOT, PATH, FLOW, FIXED_FLOW};
+
+    struct Algorithm
+    {
+        const char* name;
+        const char* file;
+        const char* procedure;
+        bool        directed;
+        LABELS      labels;
+        PARAMS      params;
+    };
+
+    VisBatch(QObject* parent = 0);
+    ~VisBatch();
+
+    // True when the command line asks for batch mode, checked before any
+    // application object exists
+    static bool requested(int argc, char* argv[]);
+
+    // Returns the exit status: 0 when every file was solved, 1 when some
+    // failed and 2 for usage errors
+    int run(const QStringList& arguments);
+
+    // Called by the Scheme primitives, in the workers
+    SCM  graph(int index);
+    SCM  arguments(int index);
+    void result(int index, SCM value);
+    void fail(int index, const QString& error);
+    void message(const QString& text);
+
+private slots:
+    void visJobFinished(int job, int status);
+
+private:
+    const Algorithm*     algorithm;
+    QList<VisBatchTask*> tasks;
+    QHash<int, int>      job_tasks;
+    VisSchemeExecutor*   executor;
+    int                  pending;
+    int                  root;
+
+    void initForeign();
+    QStringList inputsOf(const QStringList& paths);
+    bool setAttributes(SCM g, const VisDocument& document, QString* error);
+    bool write(const QString& path, const QString& format);
+};
+
+#endif // VISBATCH_HPP
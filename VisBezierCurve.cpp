@@ -1,4 +1,5 @@
 #include "VisBezierCurve.hpp"
+#include "VisGraphicsScene.hpp"
 
 #include <QPainter>
 #include <cmath>
@@ -6,58 +7,153 @@
 #include <QStyleOptionGraphicsItem>
 #include <QGraphicsSceneContextMenuEvent>
 #include <QPainterPathStroker>
+#include <QGraphicsScene>
 
 VisBezierCurve::VisBezierCurve(VisNode* _nodeA, VisNode* _nodeB, QString label_text, bool straight_, QGraphicsItem* parent)
-    : QGraphicsItem(parent), is_highlighted(false), highlight_color(QColor(255,255,255))
+    : QGraphicsItem(parent), is_highlighted(false), highlight_color(QColor(255,255,255)), moving_ctrls(false)
 {
     setFlag(QGraphicsItem::ItemIsSelectable, true);
     nodeA = _nodeA;
     nodeB = _nodeB;
-    nodeApos = QPointF(nodeA->pos().x()+nodeA->rect().width()/2.0,
-                       nodeA->pos().y()+nodeA->rect().height()/2.0);
-    nodeBpos = QPointF(nodeB->pos().x()+nodeB->rect().width()/2.0,
-                       nodeB->pos().y()+nodeB->rect().height()/2.0);
     setZValue(0);
 
     a_id = nodeA->id;
     b_id = nodeB->id;
 
-    label = new VisLabel(label_text);
-    ctrl1 = new VisPoint(0,0);
-    ctrl2 = new VisPoint(0,0);
+    // Los puntos de control y la etiqueta se crean solo cuando se necesitan
+    label = NULL;
+    ctrl1 = NULL;
+    ctrl2 = NULL;
+    if(label_text != "")
+        label = new VisLabel(label_text);
+
+    straight = straight_;
+
+    nodeA->attach(this);
+    nodeB->attach(this);
 
+    resetCtrlPoints();
+}
+VisBezierCurve::~VisBezierCurve()
+{
+    if(nodeA != NULL)
+        nodeA->detach(this);
+    if(nodeB != NULL)
+        nodeB->detach(this);
+    delete label;
+    destroyCtrlPoints();
+}
+
+void VisBezierCurve::resetCtrlPoints()
+{
     QPointF Abox = nodeA->rect().center();
     QPointF Bbox = nodeB->rect().center();
 
     QPointF A = nodeA->pos()+Abox;
     QPointF B = nodeB->pos()+Bbox;
 
-    ctrl1->setPos(A+(1/3.0)*(B-A)-QPointF(ctrl1->w/2.0, ctrl1->h/2.0));
-    ctrl2->setPos(A+(2/3.0)*(B-A)-QPointF(ctrl2->w/2.0, ctrl2->h/2.0));
+    ctrl1_pos = A+(1/3.0)*(B-A);
+    ctrl2_pos = A+(2/3.0)*(B-A);
+
+    moving_ctrls = true;
+    if(ctrl1 != NULL)
+        ctrl1->setPos(ctrl1_pos-QPointF(VisPoint::w/2.0, VisPoint::h/2.0));
+    if(ctrl2 != NULL)
+        ctrl2->setPos(ctrl2_pos-QPointF(VisPoint::w/2.0, VisPoint::h/2.0));
+    moving_ctrls = false;
 
-    straight = straight;
+    nodeApos = A;
+    nodeBpos = B;
+
+    updateGeometry();
 }
-VisBezierCurve::~VisBezierCurve()
+
+void VisBezierCurve::setCtrlPositions(const QPointF& pos1, const QPointF& pos2)
 {
-    // Si elimino label, ctrl1 o ctrl2 sale un segmentation fault
-    delete label;
+    ctrl1_pos = pos1;
+    ctrl2_pos = pos2;
+
+    moving_ctrls = true;
+    if(ctrl1 != NULL)
+        ctrl1->setPos(ctrl1_pos-QPointF(VisPoint::w/2.0, VisPoint::h/2.0));
+    if(ctrl2 != NULL)
+        ctrl2->setPos(ctrl2_pos-QPointF(VisPoint::w/2.0, VisPoint::h/2.0));
+    moving_ctrls = false;
+
+    updateGeometry();
+}
+
+void VisBezierCurve::createCtrlPoints()
+{
+    if(ctrl1 != NULL or scene() == NULL)
+        return;
+
+    ctrl1 = new VisPoint(0,0);
+    ctrl2 = new VisPoint(0,0);
+    ctrl1->setPos(ctrl1_pos-QPointF(VisPoint::w/2.0, VisPoint::h/2.0));
+    ctrl2->setPos(ctrl2_pos-QPointF(VisPoint::w/2.0, VisPoint::h/2.0));
+    ctrl1->curve = this;
+    ctrl2->curve = this;
+    scene()->addItem(ctrl1);
+    scene()->addItem(ctrl2);
+}
+
+void VisBezierCurve::forgetAttachments()
+{
+    nodeA = NULL;
+    nodeB = NULL;
+    label = NULL;
+    if(ctrl1 != NULL){
+        ctrl1->curve = NULL;
+        ctrl2->curve = NULL;
+        ctrl1 = NULL;
+        ctrl2 = NULL;
+    }
+}
+
+void VisBezierCurve::destroyCtrlPoints()
+{
+    if(ctrl1 == NULL)
+        return;
+
+    ctrl1->curve = NULL;
+    ctrl2->curve = NULL;
     delete ctrl1;
     delete ctrl2;
+    ctrl1 = NULL;
+    ctrl2 = NULL;
 }
 
-void VisBezierCurve::setCtrlPoints(VisPoint* pt1, VisPoint* pt2)
+VisLabel* VisBezierCurve::ensureLabel()
 {
-    ctrl1 = pt1;
-    ctrl2 = pt2;
+    if(label == NULL){
+        label = new VisLabel("");
+        if(scene() != NULL)
+            scene()->addItem(label);
+        label->setAnchor(curve_path.pointAtPercent(.5));
+    }
+    return label;
+}
 
-    QPointF Abox = nodeA->rect().center();
-    QPointF Bbox = nodeB->rect().center();
+void VisBezierCurve::setLabelText(const QString& text)
+{
+    if(label == NULL and text == "")
+        return;
+    ensureLabel()->setText(text);
+}
 
-    QPointF A = nodeA->pos()+Abox;
-    QPointF B = nodeB->pos()+Bbox;
+QString VisBezierCurve::labelText() const
+{
+    if(label == NULL)
+        return QString("");
+    return label->toPlainText();
+}
 
-    ctrl1->setPos(A+(1/3.0)*(B-A)-QPointF(ctrl1->w/2.0, ctrl1->h/2.0));
-    ctrl2->setPos(A+(2/3.0)*(B-A)-QPointF(ctrl2->w/2.0, ctrl2->h/2.0));
+void VisBezierCurve::setStraight(bool straight_)
+{
+    straight = straight_;
+    resetCtrlPoints();
+    updateCtrlVisibility();
 }
 
 void VisBezierCurve::set_highlight(int r,int g,int b,int a)
@@ -71,13 +167,8 @@ void VisBezierCurve::set_unhighlighted()
     is_highlighted = false;
 }
 
-void VisBezierCurve::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+void VisBezierCurve::nodeMoved(VisNode* node)
 {
-    if(isSelected()){
-        label->setSelected(true);
-    }
-    QPainterPath path;
-
     QRectF Abox = nodeA->rect();
     QRectF Bbox = nodeB->rect();
 
@@ -86,132 +177,142 @@ void VisBezierCurve::paint(QPainter* painter, const QStyleOptionGraphicsItem* op
     double Bx = nodeB->pos().x()+Bbox.width()/2.0;
     double By = nodeB->pos().y()+Bbox.height()/2.0;
 
-    if(not straight){
-        if(QPointF(Ax, Ay) != nodeApos){
-            ctrl1->moveBy(Ax-nodeApos.x(), Ay-nodeApos.y());
-            nodeApos = QPointF(Ax, Ay);
-        }
-
-        if(QPointF(Bx, By) != nodeBpos){
-            ctrl2->moveBy(Bx-nodeBpos.x(), By-nodeBpos.y());
-            nodeBpos = QPointF(Bx, By);
+    // Los puntos de control acompañan al nodo que se movio
+    moving_ctrls = true;
+    if(node == nodeA and QPointF(Ax, Ay) != nodeApos){
+        if(not straight){
+            ctrl1_pos += QPointF(Ax, Ay)-nodeApos;
+            if(ctrl1 != NULL)
+                ctrl1->moveBy(Ax-nodeApos.x(), Ay-nodeApos.y());
         }
-
-        if(is_highlighted == true){
-            painter->fillPath(shape(), highlight_color);
-        }
-        path.moveTo(Ax, Ay);
-        path.cubicTo(ctrl1->vis_pos(),ctrl2->vis_pos(), QPointF(Bx,By));
-
-        if (option->state & QStyle::State_Selected){
-            if(ctrl1 != NULL and ctrl2 != NULL and !ctrl1->isVisible() and !ctrl1->isVisible()){
-                ctrl1->show();
-                ctrl2->show();
-            }
-        }else if(ctrl1 != NULL and ctrl2 != NULL and !ctrl1->isSelected() and !ctrl2->isSelected()){
-            ctrl1->hide();
-            ctrl2->hide();
-        }
-    }else{
-        if(is_highlighted == true){
-            painter->fillPath(shape(), highlight_color);
+        nodeApos = QPointF(Ax, Ay);
+    }
+    if(node == nodeB and QPointF(Bx, By) != nodeBpos){
+        if(not straight){
+            ctrl2_pos += QPointF(Bx, By)-nodeBpos;
+            if(ctrl2 != NULL)
+                ctrl2->moveBy(Bx-nodeBpos.x(), By-nodeBpos.y());
         }
-        path.moveTo(Ax, Ay);
-        path.lineTo(Bx, By);
-        ctrl1->hide();
-        ctrl2->hide();
+        nodeBpos = QPointF(Bx, By);
     }
-    painter->drawPath(path);
+    moving_ctrls = false;
 
-    if (option->state & QStyle::State_Selected){
-        QPainterPath select_path = this->shape();
-        painter->setPen(QPen(QColor(127,127,127), 0, Qt::DashLine));
-        painter->setBrush(Qt::NoBrush);
-        painter->drawPath(select_path);
-    }
+    updateGeometry();
+}
 
-    double lh = label->boundingRect().height()+6;
-    double lw = label->boundingRect().width()/2.0;
-    label->setPos(path.pointAtPercent(.5).x()-lw, path.pointAtPercent(.5).y()-lh);
+void VisBezierCurve::ctrlMoved()
+{
+    if(moving_ctrls or ctrl1 == NULL)
+        return;
+    ctrl1_pos = ctrl1->vis_pos();
+    ctrl2_pos = ctrl2->vis_pos();
+    updateGeometry();
 }
 
-QRectF VisBezierCurve::boundingRect() const
+void VisBezierCurve::updateGeometry()
 {
+    prepareGeometryChange();
+
     QRectF Abox = nodeA->rect();
     QRectF Bbox = nodeB->rect();
 
     double Ax = nodeA->pos().x()+Abox.width()/2.0;
     double Ay = nodeA->pos().y()+Abox.height()/2.0;
     double Bx = nodeB->pos().x()+Bbox.width()/2.0;
-    double By = nodeB->pos().y()+Bbox.width()/2.0;
+    double By = nodeB->pos().y()+Bbox.height()/2.0;
+
+    curve_path = QPainterPath();
+    curve_path.moveTo(Ax, Ay);
+
+    QPainterPathStroker stroker;
+    stroker.setWidth(10);
 
-    QPainterPath path;
     if(not straight){
-        path.moveTo(Ax, Ay);
-        path.cubicTo(ctrl1->vis_pos(),ctrl2->vis_pos(), QPointF(Bx,By));
+        curve_path.cubicTo(ctrl1_pos, ctrl2_pos, QPointF(Bx, By));
+        stroker.setJoinStyle(Qt::MiterJoin);
+        select_path = stroker.createStroke(curve_path).simplified();
+
+        QPointF A(Ax, Ay), B(Bx, By);
+        draft_polygon.resize(draft_segments+1);
+        for(int i = 0; i <= draft_segments; i++){
+            double t = (double)i/draft_segments;
+            double u = 1-t;
+            draft_polygon[i] = u*u*u*A + 3*u*u*t*ctrl1_pos + 3*u*t*t*ctrl2_pos + t*t*t*B;
+        }
     }else{
-        path.moveTo(Ax, Ay);
-        path.lineTo(Bx, By);
-        QPainterPathStroker stroker;
-        stroker.setWidth(10);
-        path = (stroker.createStroke(path)+path).simplified();
+        curve_path.lineTo(Bx, By);
+        select_path = (stroker.createStroke(curve_path)+curve_path).simplified();
+
+        draft_polygon.resize(2);
+        draft_polygon[0] = QPointF(Ax, Ay);
+        draft_polygon[1] = QPointF(Bx, By);
+    }
+
+    bounding_rect = select_path.boundingRect() | curve_path.boundingRect();
+
+    if(label != NULL){
+        label->setAnchor(curve_path.pointAtPercent(.5));
     }
-    return path.boundingRect();
 }
 
-QPainterPath VisBezierCurve::shape() const
+void VisBezierCurve::updateCtrlVisibility()
 {
-    QPainterPath select_path;
-
-    double offset = 5.0;
-    QRectF Abox = nodeA->rect();
-    QRectF Bbox = nodeB->rect();
+    bool ctrl_selected = ctrl1 != NULL and (ctrl1->isSelected() or ctrl2->isSelected());
+    if(not straight and (isSelected() or ctrl_selected))
+        createCtrlPoints();
+    else
+        destroyCtrlPoints();
+}
 
-    double Ax = nodeA->pos().x()+Abox.width()/2.0;
-    double Ay = nodeA->pos().y()+Abox.height()/2.0;
-    double Bx = nodeB->pos().x()+Bbox.width()/2.0;
-    double By = nodeB->pos().y()+Bbox.width()/2.0;
+QVariant VisBezierCurve::itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant &value)
+{
+    if(change == QGraphicsItem::ItemSelectedHasChanged and value.toBool() and label != NULL){
+        label->setSelected(true);
+    }
+    return QGraphicsItem::itemChange(change, value);
+}
 
-    if(not straight){
-        /*
-        double dxCtrl1 = ctrl1->vis_pos().x() - Ax;
-        double dyCtrl1 = ctrl1->vis_pos().y() - Ay;
-        double lenCtrl1 = sqrt(dxCtrl1*dxCtrl1 + dyCtrl1*dyCtrl1);
-        QPointF a1(Ax+offset*dyCtrl1/lenCtrl1, Ay-offset*dxCtrl1/lenCtrl1);
-        QPointF a2(Ax-offset*dyCtrl1/lenCtrl1, Ay+offset*dxCtrl1/lenCtrl1);
-
-        double dxCtrl2 = ctrl2->vis_pos().x() - Bx;
-        double dyCtrl2= ctrl2->vis_pos().y() - By;
-        double lenCtrl2 = sqrt(dxCtrl2*dxCtrl2 + dyCtrl2*dyCtrl2);
-        QPointF b1(Bx-offset*dyCtrl2/lenCtrl2, By+offset*dxCtrl2/lenCtrl2);
-        QPointF b2(Bx+offset*dyCtrl2/lenCtrl2, By-offset*dxCtrl2/lenCtrl2);
-
-        select_path.moveTo(a1);
-        select_path.cubicTo(ctrl1->vis_pos().x()+offset*dyCtrl1/lenCtrl1, ctrl1->vis_pos().y()-offset*dxCtrl1/lenCtrl1, ctrl2->vis_pos().x()-offset*dyCtrl2/lenCtrl2, ctrl2->vis_pos().y()+offset*dxCtrl2/lenCtrl2, b1.x(), b1.y());
-        select_path.lineTo(b2);
-        select_path.cubicTo(ctrl2->vis_pos().x()+offset*dyCtrl2/lenCtrl2, ctrl2->vis_pos().y()-offset*dxCtrl2/lenCtrl2, ctrl1->vis_pos().x()-offset*dyCtrl1/lenCtrl1, ctrl1->vis_pos().y()+offset*dxCtrl1/lenCtrl1, a2.x(), a2.y());
-        select_path.lineTo(a1);
-        */
-        select_path.moveTo(Ax, Ay);
-        select_path.cubicTo(ctrl1->vis_pos(), ctrl2->vis_pos(), QPointF(Bx, By));
-        QPainterPathStroker stroker;
-        stroker.setWidth(10);
-        stroker.setJoinStyle(Qt::MiterJoin);
-        //select_path = (stroker.createStroke(select_path)+select_path).simplified();
-        select_path = stroker.createStroke(select_path).simplified();
+void VisBezierCurve::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+{
+    // Mientras hay interaccion la curva es la poligonal
+    if(VisGraphicsScene::isDraft(this)){
+        if(is_highlighted == true){
+            painter->save();
+            painter->setPen(QPen(highlight_color, 10));
+            painter->drawPolyline(draft_polygon);
+            painter->restore();
+        }
+        painter->drawPolyline(draft_polygon);
+        return;
+    }
 
-    }else{
-        select_path.moveTo(Ax, Ay);
-        select_path.lineTo(Bx, By);
-        QPainterPathStroker stroker;
-        stroker.setWidth(10);
-        select_path = (stroker.createStroke(select_path)+select_path).simplified();
+    if(is_highlighted == true){
+        painter->fillPath(select_path, highlight_color);
+    }
+    painter->drawPath(curve_path);
 
+    if (option->state & QStyle::State_Selected){
+        painter->setPen(QPen(QColor(127,127,127), 0, Qt::DashLine));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawPath(select_path);
     }
+}
+
+QRectF VisBezierCurve::boundingRect() const
+{
+    return bounding_rect;
+}
 
+QPainterPath VisBezierCurve::shape() const
+{
     return select_path;
 }
 
+void VisBezierCurve::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *)
+{
+    ensureLabel()->setTextInteraction(true, true);
+}
+
 void VisBezierCurve::contextMenuEvent(QGraphicsSceneContextMenuEvent *event)
 {
     QMenu menu;
@@ -242,4 +343,8 @@ void VisBezierCurve::contextMenuEvent(QGraphicsSceneContextMenuEvent *event)
 
     }
     update();
+
+    VisGraphicsScene* vis_scene = dynamic_cast<VisGraphicsScene*>(scene());
+    if(vis_scene != NULL)
+        vis_scene->visTrackHighlight(this);
 }
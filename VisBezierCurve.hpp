@@ -3,6 +3,7 @@
 
 #include <QGraphicsItem>
 #include <QPainterPath>
+#include <QPolygonF>
 #include <QMenu>
 
 #include "VisNode.hpp"
@@ -23,13 +24,39 @@ public:
 
     void contextMenuEvent(QGraphicsSceneContextMenuEvent *);
 
-    void setCtrlPoints(VisPoint* pt1, VisPoint* pt2);
+    QVariant itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant &value);
+
+    void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *);
+
+    void resetCtrlPoints();
+    void setStraight(bool straight_);
+    // Control point centers in scene coordinates, as stored in documents
+    void setCtrlPositions(const QPointF& pos1, const QPointF& pos2);
+
+    // Helper items are created only while they are needed
+    void createCtrlPoints();
+    void destroyCtrlPoints();
+    // Drop references to other items, used before the scene deletes them all
+    void forgetAttachments();
+    VisLabel* ensureLabel();
+    void setLabelText(const QString& text);
+    QString labelText() const;
+
+    // Geometry propagation from the attached nodes and control points
+    void nodeMoved(VisNode* node);
+    void ctrlMoved();
+    void updateGeometry();
+    void updateCtrlVisibility();
 
     VisNode*  nodeA;
     VisNode*  nodeB;
     VisPoint* ctrl1;
     VisPoint* ctrl2;
 
+    // Control point centers, kept even when ctrl1 and ctrl2 do not exist
+    QPointF ctrl1_pos;
+    QPointF ctrl2_pos;
+
     QPointF nodeApos;
     QPointF nodeBpos;
     QPointF labelpos;
@@ -52,6 +79,18 @@ public:
     void set_unhighlighted();
 
     bool straight;
+
+protected:
+    // Cached geometry, rebuilt by updateGeometry()
+    QPainterPath curve_path;
+    QPainterPath select_path;
+    QRectF       bounding_rect;
+
+    // Coarse polyline drawn instead of curve_path while interacting
+    QPolygonF    draft_polygon;
+    const static int draft_segments = 8;
+
+    bool moving_ctrls;
 };
 
 #endif // VISBEZIERCURVE_HPP
@@ -0,0 +1,44 @@
+#ifndef VISCHANGESET_HPP
+#define VISCHANGESET_HPP
+
+#include <QVector>
+#include <QString>
+#include <QColor>
+#include <QMetaType>
+
+// One drawing call recorded while the environment is in batch mode
+struct VisChange
+{
+    enum KIND {PAINT_NODE, UNPAINT_NODE,
+               PAINT_EDGE, UNPAINT_EDGE,
+               PAINT_ARROW, UNPAINT_ARROW,
+               LABEL_NODE, LABEL_EDGE, LABEL_ARROW,
+               COLOR_NODE, UNCOLOR_NODE,
+               COLOR_EDGE, UNCOLOR_EDGE,
+               COLOR_ARROW, UNCOLOR_ARROW,
+               COLOR_NODE_LABEL, UNCOLOR_NODE_LABEL,
+               COLOR_EDGE_LABEL, UNCOLOR_EDGE_LABEL,
+               COLOR_ARROW_LABEL, UNCOLOR_ARROW_LABEL,
+               CLEAR_GRAPH} kind;
+
+    // Node id, or the ends of an edge or arrow
+    int aid;
+    int bid;
+
+    double x;
+    double y;
+    bool with_curves;
+
+    QString text;
+    QColor  color;
+
+    VisChange(KIND kind_ = PAINT_NODE, int aid_ = 0, int bid_ = 0)
+        : kind(kind_), aid(aid_), bid(bid_), x(0), y(0), with_curves(false) {}
+};
+
+// Changes are applied by the scene in the order they were recorded
+typedef QVector<VisChange> VisChangeSet;
+
+Q_DECLARE_METATYPE(VisChangeSet)
+
+#endif // VISCHANGESET_HPP
@@ -1,7 +1,7 @@
 #include "VisDijkstra.hpp"
 #include <QHBoxLayout>
 
-VisDijkstra::VisDijkstra(QList<int> ids, QWidget *parent)
+VisDijkstra::VisDijkstra(const QVector<int>& ids, QWidget *parent)
     : QDialog(parent)
 {
     setWindowTitle("Dijkstra");
@@ -10,22 +10,16 @@ VisDijkstra::VisDijkstra(QList<int> ids, QWidget *parent)
     ui_description->setWordWrap(true);
     ui_description->setText("Obtain the shortest path from a starting vertex to an ending vertex using Dijkstra's algorithm");
 
-    ui_select_starting = new QComboBox;
-    foreach(int id, ids){
-        ui_select_starting->addItem(QString::number(id));
-    }
+    ui_select_starting = new VisVertexPicker(ids, false);
     ui_select_starting_label = new QLabel("Start vertex:");
-    ui_select_starting_label->setAlignment(Qt::AlignVCenter | Qt::AlignRight);
+    ui_select_starting_label->setAlignment(Qt::AlignTop | Qt::AlignRight);
     ui_select_starting_layout = new QHBoxLayout;
     ui_select_starting_layout->addWidget(ui_select_starting_label);
     ui_select_starting_layout->addWidget(ui_select_starting);
 
-    ui_select_ending = new QComboBox;
-    foreach(int id, ids){
-        ui_select_ending->addItem(QString::number(id));
-    }
+    ui_select_ending = new VisVertexPicker(ids, false);
     ui_select_ending_label = new QLabel("End vertex:");
-    ui_select_ending_label->setAlignment(Qt::AlignVCenter | Qt::AlignRight);
+    ui_select_ending_label->setAlignment(Qt::AlignTop | Qt::AlignRight);
     ui_select_ending_layout = new QHBoxLayout;
     ui_select_ending_layout->addWidget(ui_select_ending_label);
     ui_select_ending_layout->addWidget(ui_select_ending);
@@ -37,6 +31,13 @@ VisDijkstra::VisDijkstra(QList<int> ids, QWidget *parent)
     connect(ui_buttons, SIGNAL(accepted()), this, SLOT(accept()));
     connect(ui_buttons, SIGNAL(rejected()), this, SLOT(reject()));
 
+    // Sin vertices elegidos no hay con que ejecutar el algoritmo
+    connect(ui_select_starting, SIGNAL(visSelectionChanged()),
+            this, SLOT(visUpdateButtons()));
+    connect(ui_select_ending, SIGNAL(visSelectionChanged()),
+            this, SLOT(visUpdateButtons()));
+    visUpdateButtons();
+
     ui_layout = new QVBoxLayout;
     ui_layout->addWidget(ui_description);
     ui_layout->addStretch();
@@ -68,8 +69,14 @@ VisDijkstra::~VisDijkstra()
 int VisDijkstra::exec()
 {
     int response = QDialog::exec();
-    starting_vertex = ui_select_starting->currentText().toInt();
-    ending_vertex = ui_select_ending->currentText().toInt();
+    starting_vertex = ui_select_starting->selectedId();
+    ending_vertex = ui_select_ending->selectedId();
 
     return response;
 }
+
+void VisDijkstra::visUpdateButtons()
+{
+    ui_buttons->button(QDialogButtonBox::Ok)->setEnabled(ui_select_starting->hasSelection() and
+                                                        ui_select_ending->hasSelection());
+}
@@ -6,16 +6,16 @@
 
 // Member classes
 #include <QLabel>
-#include <QComboBox>
 #include <QVBoxLayout>
 #include <QDialogButtonBox>
+#include <VisVertexPicker.hpp>
 
 class VisDijkstra : public QDialog
 {
     Q_OBJECT
 
 public:
-    VisDijkstra(QList<int> ids, QWidget* parent = 0);
+    VisDijkstra(const QVector<int>& ids, QWidget* parent = 0);
     ~VisDijkstra();
 
     int exec();
@@ -27,18 +27,21 @@ private:
     QVBoxLayout* ui_layout;
     QLabel* ui_description;
 
-    QComboBox*   ui_select_starting;
-    QLabel*      ui_select_starting_label;
-    QHBoxLayout* ui_select_starting_layout;
+    VisVertexPicker* ui_select_starting;
+    QLabel*          ui_select_starting_label;
+    QHBoxLayout*     ui_select_starting_layout;
 
-    QComboBox*   ui_select_ending;
-    QLabel*      ui_select_ending_label;
-    QHBoxLayout* ui_select_ending_layout;
+    VisVertexPicker* ui_select_ending;
+    QLabel*          ui_select_ending_label;
+    QHBoxLayout*     ui_select_ending_layout;
 
     QDialogButtonBox* ui_buttons;
 
     int starting_vertex;
     int ending_vertex;
+
+private slots:
+    void visUpdateButtons();
 };
 
 #endif // VISDIJKSTRA_HPP
@@ -0,0 +1,425 @@
+#include "VisDocument.hpp"
+
+#include <QSaveFile>
+#include <QBuffer>
+#include <QHash>
+
+#include <cstring>
+
+#include "VisGraphicsScene.hpp"
+
+static const char document_magic[4] = {'S', 'G', 'V', 'D'};
+
+static quint64 aligned(quint64 offset)
+{
+    return (offset+7) & ~quint64(7);
+}
+
+void VisDocumentContent::resize(quint32 n, quint32 m)
+{
+    ids.resize(n);
+    positions.fill(0, 2*n);
+    rows.fill(0, n+1);
+    targets.resize(m);
+    ctrl_points.fill(0, 4*m);
+    node_flags.fill(0, n);
+    edge_flags.fill(0, m);
+    node_colors.fill(0, n);
+    node_label_colors.fill(0, n);
+    edge_colors.fill(0, m);
+    edge_label_colors.fill(0, m);
+}
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Class procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+VisDocument::VisDocument()
+    : data(NULL)
+{
+    close();
+}
+
+VisDocument::~VisDocument()
+{
+    close();
+}
+
+bool VisDocument::open(const QString& path)
+{
+    close();
+
+    file.setFileName(path);
+    if(not file.open(QIODevice::ReadOnly)){
+        error = file.errorString();
+        return false;
+    }
+    if(file.size() < (qint64) sizeof(VisDocumentHeader)){
+        error = "Not a graph document";
+        close();
+        return false;
+    }
+    data = file.map(0, file.size());
+    if(data == NULL){
+        error = file.errorString();
+        close();
+        return false;
+    }
+    return attach(data, file.size());
+}
+
+bool VisDocument::open(const VisDocumentContent& content)
+{
+    QByteArray bytes;
+    QBuffer buffer(&bytes);
+    buffer.open(QIODevice::WriteOnly);
+    write(&buffer, content);
+    buffer.close();
+    return open(bytes);
+}
+
+bool VisDocument::open(const QByteArray& bytes)
+{
+    close();
+
+    image = bytes;
+    return attach((const uchar*) image.constData(), image.size());
+}
+
+bool VisDocument::attach(const uchar* bytes, quint64 length)
+{
+    base   = bytes;
+    size   = length;
+    header = (const VisDocumentHeader*) base;
+    error  = "";
+
+    if(size < sizeof(VisDocumentHeader) or
+       memcmp(header->magic, document_magic, sizeof(document_magic)) != 0)
+        error = "Not a graph document";
+    else if(header->byte_order != byte_order)
+        error = "The document was written on a machine with another byte order";
+    else if(header->version != version)
+        error = QString("Unsupported document version %1").arg(header->version);
+    else if(header->section_count != VisDocumentHeader::SECTION_COUNT)
+        error = "Damaged graph document";
+    if(not error.isEmpty()){
+        close();
+        return false;
+    }
+
+    // Solo se comprueba que cada seccion quepa en el documento, los
+    // registros se leen tal cual estan
+    quint64 n = header->node_count;
+    quint64 m = header->edge_count;
+    ids               = (const qint32*)  section(VisDocumentHeader::IDS, 4*n);
+    positions         = (const double*)  section(VisDocumentHeader::POSITIONS, 16*n);
+    rows              = (const quint32*) section(VisDocumentHeader::ROWS, 4*(n+1));
+    targets           = (const quint32*) section(VisDocumentHeader::TARGETS, 4*m);
+    ctrl_points       = (const double*)  section(VisDocumentHeader::CTRL_POINTS, 32*m);
+    node_flags        = (const quint8*)  section(VisDocumentHeader::NODE_FLAGS, n);
+    edge_flags        = (const quint8*)  section(VisDocumentHeader::EDGE_FLAGS, m);
+    node_colors       = (const quint32*) section(VisDocumentHeader::NODE_COLORS, 4*n);
+    node_label_colors = (const quint32*) section(VisDocumentHeader::NODE_LABEL_COLORS, 4*n);
+    edge_colors       = (const quint32*) section(VisDocumentHeader::EDGE_COLORS, 4*m);
+    edge_label_colors = (const quint32*) section(VisDocumentHeader::EDGE_LABEL_COLORS, 4*m);
+    label_offsets     = (const quint32*) section(VisDocumentHeader::LABEL_OFFSETS, 4*(n+m+1));
+    if(error.isEmpty()){
+        label_size = label_offsets[n+m];
+        label_data = (const char*) section(VisDocumentHeader::LABEL_DATA, label_size);
+    }
+    if(error.isEmpty() and (rows[0] != 0 or rows[n] != m))
+        error = "Damaged graph document";
+
+    if(not error.isEmpty()){
+        close();
+        return false;
+    }
+    return true;
+}
+
+void VisDocument::close()
+{
+    if(data != NULL)
+        file.unmap(data);
+    if(file.isOpen())
+        file.close();
+    image.clear();
+
+    data              = NULL;
+    base              = NULL;
+    size              = 0;
+    header            = NULL;
+    ids               = NULL;
+    positions         = NULL;
+    rows              = NULL;
+    targets           = NULL;
+    ctrl_points       = NULL;
+    node_flags        = NULL;
+    edge_flags        = NULL;
+    node_colors       = NULL;
+    node_label_colors = NULL;
+    edge_colors       = NULL;
+    edge_label_colors = NULL;
+    label_offsets     = NULL;
+    label_data        = NULL;
+    label_size        = 0;
+}
+
+bool VisDocument::directed() const
+{
+    return header->flags & VisDocumentHeader::DIRECTED;
+}
+
+quint32 VisDocument::nodeCount() const
+{
+    return header->node_count;
+}
+
+quint32 VisDocument::edgeCount() const
+{
+    return header->edge_count;
+}
+
+qint32 VisDocument::nextId() const
+{
+    return header->next_id;
+}
+
+QString VisDocument::nodeLabel(quint32 i) const
+{
+    return label(i);
+}
+
+QString VisDocument::edgeLabel(quint32 e) const
+{
+    return label(header->node_count+e);
+}
+
+QString VisDocument::label(quint32 i) const
+{
+    quint32 begin = label_offsets[i];
+    quint32 end   = label_offsets[i+1];
+    if(begin >= end or end > label_size)
+        return QString("");
+    return QString::fromUtf8(label_data+begin, end-begin);
+}
+
+const uchar* VisDocument::section(int index, quint64 length)
+{
+    if(not error.isEmpty())
+        return NULL;
+
+    quint64 offset = header->sections[index];
+    if(offset % 8 != 0 or offset > size or length > size-offset){
+        error = "Damaged graph document";
+        return NULL;
+    }
+    return base+offset;
+}
+
+bool VisDocument::save(const QString& path, VisGraphicsScene* scene, QString* error)
+{
+    VisDocumentContent content = contentOf(scene);
+
+    // El documento anterior solo se reemplaza si se escribio completo
+    QSaveFile out(path);
+    if(not out.open(QIODevice::WriteOnly)){
+        *error = out.errorString();
+        return false;
+    }
+    if(not write(&out, content))
+        out.cancelWriting();
+    if(not out.commit()){
+        *error = out.errorString();
+        return false;
+    }
+    return true;
+}
+
+VisDocumentContent VisDocument::contentOf(VisGraphicsScene* scene)
+{
+    VisDocumentContent content;
+    QVector<VisNode*> nodes;
+    QVector<VisBezierCurve*> curves;
+    orderOf(scene, &content, &nodes, &curves);
+    geometryOf(nodes, curves, &content);
+    flagsOf(nodes, curves, &content);
+    labelsOf(nodes, curves, &content);
+    return content;
+}
+
+void VisDocument::orderOf(VisGraphicsScene* scene, VisDocumentContent* content,
+                          QVector<VisNode*>* nodes, QVector<VisBezierCurve*>* curves)
+{
+    content->directed = scene->graph_type == VisGraphicsScene::DIRECTED;
+    content->next_id  = scene->id();
+
+    QList<VisBezierCurve*> scene_curves;
+    if(content->directed){
+        foreach(VisArrow* arrow, scene->graph_arrows.values())
+            scene_curves.append(arrow);
+    }else{
+        foreach(VisEdge* edge, scene->graph_edges.values())
+            scene_curves.append(edge);
+    }
+
+    QVector<int> node_ids = scene->graph_node_ids();
+    quint32 n = node_ids.size();
+    quint32 m = scene_curves.size();
+    content->ids.resize(n);
+    content->rows.fill(0, n+1);
+    content->targets.resize(m);
+    nodes->resize(n);
+    curves->resize(m);
+
+    QHash<int, quint32> index;
+    index.reserve(n);
+    for(quint32 i = 0; i < n; i++){
+        (*nodes)[i] = scene->graph_nodes.value(node_ids[i]);
+        index.insert(node_ids[i], i);
+        content->ids[i] = node_ids[i];
+    }
+
+    // Las curvas se agrupan por su primer vertice con una suma de prefijos
+    foreach(VisBezierCurve* curve, scene_curves)
+        content->rows[index.value(curve->a_id)+1]++;
+    for(quint32 i = 0; i < n; i++)
+        content->rows[i+1] += content->rows[i];
+
+    QVector<quint32> next = content->rows;
+    foreach(VisBezierCurve* curve, scene_curves)
+        (*curves)[next[index.value(curve->a_id)]++] = curve;
+    for(quint32 e = 0; e < m; e++)
+        content->targets[e] = index.value((*curves)[e]->b_id);
+}
+
+void VisDocument::geometryOf(const QVector<VisNode*>& nodes, const QVector<VisBezierCurve*>& curves,
+                             VisDocumentContent* content)
+{
+    quint32 n = nodes.size();
+    quint32 m = curves.size();
+    content->positions.resize(2*n);
+    content->ctrl_points.resize(4*m);
+    for(quint32 i = 0; i < n; i++){
+        content->positions[2*i]   = nodes[i]->pos().x();
+        content->positions[2*i+1] = nodes[i]->pos().y();
+    }
+    for(quint32 e = 0; e < m; e++){
+        VisBezierCurve* curve = curves[e];
+        content->ctrl_points[4*e]   = curve->ctrl1_pos.x();
+        content->ctrl_points[4*e+1] = curve->ctrl1_pos.y();
+        content->ctrl_points[4*e+2] = curve->ctrl2_pos.x();
+        content->ctrl_points[4*e+3] = curve->ctrl2_pos.y();
+    }
+}
+
+void VisDocument::flagsOf(const QVector<VisNode*>& nodes, const QVector<VisBezierCurve*>& curves,
+                          VisDocumentContent* content)
+{
+    quint32 n = nodes.size();
+    quint32 m = curves.size();
+    content->node_flags.fill(0, n);
+    content->edge_flags.fill(0, m);
+    content->node_colors.fill(0, n);
+    content->node_label_colors.fill(0, n);
+    content->edge_colors.fill(0, m);
+    content->edge_label_colors.fill(0, m);
+
+    for(quint32 i = 0; i < n; i++){
+        VisNode* node = nodes[i];
+        if(node->is_highlighted){
+            content->node_flags[i] |= HIGHLIGHTED;
+            content->node_colors[i] = node->highlight_color.rgba();
+        }
+        if(node->label != NULL and node->label->is_highlighted){
+            content->node_flags[i] |= LABEL_HIGHLIGHTED;
+            content->node_label_colors[i] = node->label->highlight_color.rgba();
+        }
+    }
+    for(quint32 e = 0; e < m; e++){
+        VisBezierCurve* curve = curves[e];
+        if(curve->straight)
+            content->edge_flags[e] |= STRAIGHT;
+        if(curve->is_highlighted){
+            content->edge_flags[e] |= HIGHLIGHTED;
+            content->edge_colors[e] = curve->highlight_color.rgba();
+        }
+        if(curve->label != NULL and curve->label->is_highlighted){
+            content->edge_flags[e] |= LABEL_HIGHLIGHTED;
+            content->edge_label_colors[e] = curve->label->highlight_color.rgba();
+        }
+    }
+}
+
+void VisDocument::labelsOf(const QVector<VisNode*>& nodes, const QVector<VisBezierCurve*>& curves,
+                           VisDocumentContent* content)
+{
+    content->label_offsets.clear();
+    content->label_offsets.reserve(nodes.size()+curves.size()+1);
+    content->label_data.clear();
+    foreach(VisNode* node, nodes){
+        content->label_offsets.append(content->label_data.size());
+        content->label_data.append(node->labelText().toUtf8());
+    }
+    foreach(VisBezierCurve* curve, curves){
+        content->label_offsets.append(content->label_data.size());
+        content->label_data.append(curve->labelText().toUtf8());
+    }
+    content->label_offsets.append(content->label_data.size());
+}
+
+bool VisDocument::write(QIODevice* out, const VisDocumentContent& content)
+{
+    quint32 n = content.ids.size();
+    quint32 m = content.targets.size();
+
+    VisDocumentHeader header;
+    memset(&header, 0, sizeof(header));
+    memcpy(header.magic, document_magic, sizeof(document_magic));
+    header.byte_order    = byte_order;
+    header.version       = version;
+    header.flags         = content.directed ? VisDocumentHeader::DIRECTED : 0;
+    header.node_count    = n;
+    header.edge_count    = m;
+    header.next_id       = content.next_id;
+    header.section_count = VisDocumentHeader::SECTION_COUNT;
+
+    const char* arrays[VisDocumentHeader::SECTION_COUNT] = {
+        (const char*) content.ids.constData(),
+        (const char*) content.positions.constData(),
+        (const char*) content.rows.constData(),
+        (const char*) content.targets.constData(),
+        (const char*) content.ctrl_points.constData(),
+        (const char*) content.node_flags.constData(),
+        (const char*) content.edge_flags.constData(),
+        (const char*) content.node_colors.constData(),
+        (const char*) content.node_label_colors.constData(),
+        (const char*) content.edge_colors.constData(),
+        (const char*) content.edge_label_colors.constData(),
+        (const char*) content.label_offsets.constData(),
+        content.label_data.constData()
+    };
+    quint64 sizes[VisDocumentHeader::SECTION_COUNT] = {
+        4*quint64(n), 16*quint64(n), 4*quint64(n+1), 4*quint64(m), 32*quint64(m),
+        n, m, 4*quint64(n), 4*quint64(n), 4*quint64(m), 4*quint64(m),
+        4*quint64(content.label_offsets.size()), quint64(content.label_data.size())
+    };
+
+    quint64 offset = aligned(sizeof(header));
+    for(int s = 0; s < VisDocumentHeader::SECTION_COUNT; s++){
+        header.sections[s] = offset;
+        offset = aligned(offset+sizes[s]);
+    }
+
+    static const char padding[8] = {0, 0, 0, 0, 0, 0, 0, 0};
+    bool ok = out->write((const char*) &header, sizeof(header)) == sizeof(header);
+    for(int s = 0; s < VisDocumentHeader::SECTION_COUNT and ok; s++){
+        qint64 gap = header.sections[s]-out->pos();
+        ok = out->write(padding, gap) == gap and
+             out->write(arrays[s], sizes[s]) == (qint64) sizes[s];
+    }
+    return ok;
+}
@@ -0,0 +1,147 @@
+#ifndef VISDOCUMENT_HPP
+#define VISDOCUMENT_HPP
+
+#include <QFile>
+#include <QString>
+#include <QVector>
+#include <QByteArray>
+
+class QIODevice;
+class VisGraphicsScene;
+class VisNode;
+class VisBezierCurve;
+
+// Fixed size header at the start of a document. Every section is an array
+// of fixed size records starting at an 8 byte boundary, so a mapped file is
+// read in place.
+struct VisDocumentHeader
+{
+    enum SECTION {IDS,                  // qint32[n], sorted
+                  POSITIONS,            // double[2n]
+                  ROWS,                 // quint32[n+1], CSR offsets by source
+                  TARGETS,              // quint32[m], target vertex index
+                  CTRL_POINTS,          // double[4m], scene coordinates
+                  NODE_FLAGS,           // quint8[n]
+                  EDGE_FLAGS,           // quint8[m]
+                  NODE_COLORS,          // quint32[n], QRgb
+                  NODE_LABEL_COLORS,    // quint32[n]
+                  EDGE_COLORS,          // quint32[m]
+                  EDGE_LABEL_COLORS,    // quint32[m]
+                  LABEL_OFFSETS,        // quint32[n+m+1], vertices then edges
+                  LABEL_DATA,           // UTF-8
+                  SECTION_COUNT};
+
+    enum FLAGS {DIRECTED = 1};
+
+    char    magic[4];
+    quint32 byte_order;
+    quint32 version;
+    quint32 flags;
+    quint32 node_count;
+    quint32 edge_count;
+    qint32  next_id;
+    quint32 section_count;
+    quint64 sections[SECTION_COUNT];
+};
+
+// Arrays of a document before they are written, filled from the scene when
+// saving and by the importers. resize() sizes every per item array.
+struct VisDocumentContent
+{
+    bool    directed;
+    qint32  next_id;
+
+    QVector<qint32>  ids;
+    QVector<double>  positions;
+    QVector<quint32> rows;
+    QVector<quint32> targets;
+    QVector<double>  ctrl_points;
+    QVector<quint8>  node_flags;
+    QVector<quint8>  edge_flags;
+    QVector<quint32> node_colors;
+    QVector<quint32> node_label_colors;
+    QVector<quint32> edge_colors;
+    QVector<quint32> edge_label_colors;
+    QVector<quint32> label_offsets;
+    QByteArray       label_data;
+
+    VisDocumentContent() : directed(false), next_id(0) {}
+
+    void resize(quint32 n, quint32 m);
+};
+
+// Versioned binary graph document. Edges are stored by source vertex in
+// CSR order, an undirected edge only once.
+class VisDocument
+{
+public:
+    enum ITEM_FLAGS {HIGHLIGHTED = 1, LABEL_HIGHLIGHTED = 2, STRAIGHT = 4};
+
+    const static quint32 version    = 1;
+    const static quint32 byte_order = 0x01020304;
+
+    VisDocument();
+    ~VisDocument();
+
+    // Maps the file, the arrays below point into it until close()
+    bool open(const QString& path);
+    // Keeps an image of the content instead, used by the importers
+    bool open(const VisDocumentContent& content);
+    // Keeps a copy of an image written by write(), used by trace keyframes
+    bool open(const QByteArray& bytes);
+    void close();
+    QString errorString() const { return error; }
+
+    static bool save(const QString& path, VisGraphicsScene* scene, QString* error);
+    static VisDocumentContent contentOf(VisGraphicsScene* scene);
+    // contentOf in parts: orderOf fills ids, rows and targets and gives the
+    // items in document order, the others fill their sections from them
+    static void orderOf(VisGraphicsScene* scene, VisDocumentContent* content,
+                        QVector<VisNode*>* nodes, QVector<VisBezierCurve*>* curves);
+    static void geometryOf(const QVector<VisNode*>& nodes, const QVector<VisBezierCurve*>& curves,
+                           VisDocumentContent* content);
+    static void flagsOf(const QVector<VisNode*>& nodes, const QVector<VisBezierCurve*>& curves,
+                        VisDocumentContent* content);
+    static void labelsOf(const QVector<VisNode*>& nodes, const QVector<VisBezierCurve*>& curves,
+                         VisDocumentContent* content);
+    static bool write(QIODevice* out, const VisDocumentContent& content);
+
+    bool    directed() const;
+    quint32 nodeCount() const;
+    quint32 edgeCount() const;
+    qint32  nextId() const;
+
+    QString nodeLabel(quint32 i) const;
+    QString edgeLabel(quint32 e) const;
+
+    const qint32*  ids;
+    const double*  positions;
+    const quint32* rows;
+    const quint32* targets;
+    const double*  ctrl_points;
+    const quint8*  node_flags;
+    const quint8*  edge_flags;
+    const quint32* node_colors;
+    const quint32* node_label_colors;
+    const quint32* edge_colors;
+    const quint32* edge_label_colors;
+
+private:
+    QFile        file;
+    uchar*       data;
+    QByteArray   image;
+    const uchar* base;
+    quint64      size;
+    QString      error;
+
+    const VisDocumentHeader* header;
+    const quint32* label_offsets;
+    const char*    label_data;
+    quint32        label_size;
+
+    bool attach(const uchar* bytes, quint64 length);
+    QString label(quint32 i) const;
+    const uchar* section(int index, quint64 length);
+};
+
+#endif // VISDOCUMENT_HPP
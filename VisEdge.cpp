@@ -1,5 +1,7 @@
 #include "VisEdge.hpp"
 
+VIS_POOL_ALLOCATED_IMPL(VisEdge)
+
 VisEdge::VisEdge(VisNode* u, VisNode* v, QString label_text, QGraphicsItem* parent)
     : VisBezierCurve(u, v, label_text, parent)
 {
@@ -2,6 +2,7 @@
 #define VISEDGE_HPP
 
 #include "VisBezierCurve.hpp"
+#include "VisItemPool.hpp"
 
 class VisEdge : public VisBezierCurve
 {
@@ -11,6 +12,9 @@ public:
     VisEdge(VisNode*, VisNode*, QString label_text = "", QGraphicsItem* parent = 0);
 
     int type() const {return Type;}
+
+    // Allocated from VisItemPool
+    VIS_POOL_ALLOCATED
 };
 
 #endif // VISEDGE_HPP
@@ -0,0 +1,183 @@
+#include "VisExporter.hpp"
+
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QXmlStreamWriter>
+#include <QList>
+
+#include "VisGraphicsScene.hpp"
+
+// Edges or arrows of the scene, whichever the graph type uses
+static QList<VisBezierCurve*> curvesOf(VisGraphicsScene* scene)
+{
+    QList<VisBezierCurve*> curves;
+    if(scene->graph_type == VisGraphicsScene::DIRECTED){
+        foreach(VisArrow* arrow, scene->graph_arrows.values())
+            curves.append(arrow);
+    }else{
+        foreach(VisEdge* edge, scene->graph_edges.values())
+            curves.append(edge);
+    }
+    return curves;
+}
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Class procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+VisExporter::FORMAT VisExporter::formatOf(const QString& path)
+{
+    if(QFileInfo(path).suffix().toLower() == "gexf")
+        return GEXF;
+    return GRAPHML;
+}
+
+bool VisExporter::write(const QString& path, FORMAT format, VisGraphicsScene* scene, QString* error)
+{
+    // El archivo anterior solo se reemplaza si se escribio completo
+    QSaveFile out(path);
+    if(not out.open(QIODevice::WriteOnly)){
+        *error = out.errorString();
+        return false;
+    }
+
+    QXmlStreamWriter xml(&out);
+    xml.setAutoFormatting(true);
+    xml.writeStartDocument();
+    if(format == GEXF)
+        writeGexf(xml, scene);
+    else
+        writeGraphml(xml, scene);
+    xml.writeEndDocument();
+
+    if(xml.hasError())
+        out.cancelWriting();
+    if(not out.commit()){
+        *error = out.errorString();
+        return false;
+    }
+    return true;
+}
+
+void VisExporter::writeGraphml(QXmlStreamWriter& xml, VisGraphicsScene* scene)
+{
+    xml.writeStartElement("graphml");
+    xml.writeDefaultNamespace("http://graphml.graphdrawing.org/xmlns");
+
+    const char* keys[5][4] = {{"d0", "node", "x", "double"},
+                              {"d1", "node", "y", "double"},
+                              {"d2", "node", "label", "string"},
+                              {"d3", "edge", "label", "string"},
+                              {"d4", "edge", "weight", "double"}};
+    for(int k = 0; k < 5; k++){
+        xml.writeEmptyElement("key");
+        xml.writeAttribute("id", keys[k][0]);
+        xml.writeAttribute("for", keys[k][1]);
+        xml.writeAttribute("attr.name", keys[k][2]);
+        xml.writeAttribute("attr.type", keys[k][3]);
+    }
+
+    xml.writeStartElement("graph");
+    xml.writeAttribute("id", "G");
+    xml.writeAttribute("edgedefault", scene->graph_type == VisGraphicsScene::DIRECTED ?
+                                      "directed" : "undirected");
+
+    foreach(int id, scene->graph_node_ids()){
+        VisNode* node = scene->graph_nodes.value(id);
+        xml.writeStartElement("node");
+        xml.writeAttribute("id", "n" + QString::number(id));
+        xml.writeStartElement("data");
+        xml.writeAttribute("key", "d0");
+        xml.writeCharacters(QString::number(node->pos().x()));
+        xml.writeEndElement();
+        xml.writeStartElement("data");
+        xml.writeAttribute("key", "d1");
+        xml.writeCharacters(QString::number(node->pos().y()));
+        xml.writeEndElement();
+        QString label = node->labelText();
+        if(not label.isEmpty()){
+            xml.writeStartElement("data");
+            xml.writeAttribute("key", "d2");
+            xml.writeCharacters(label);
+            xml.writeEndElement();
+        }
+        xml.writeEndElement();
+    }
+
+    foreach(VisBezierCurve* curve, curvesOf(scene)){
+        xml.writeStartElement("edge");
+        xml.writeAttribute("source", "n" + QString::number(curve->a_id));
+        xml.writeAttribute("target", "n" + QString::number(curve->b_id));
+        QString label = curve->labelText();
+        if(not label.isEmpty()){
+            xml.writeStartElement("data");
+            xml.writeAttribute("key", "d3");
+            xml.writeCharacters(label);
+            xml.writeEndElement();
+
+            bool numeric;
+            label.toDouble(&numeric);
+            if(numeric){
+                xml.writeStartElement("data");
+                xml.writeAttribute("key", "d4");
+                xml.writeCharacters(label);
+                xml.writeEndElement();
+            }
+        }
+        xml.writeEndElement();
+    }
+
+    xml.writeEndElement();
+    xml.writeEndElement();
+}
+
+void VisExporter::writeGexf(QXmlStreamWriter& xml, VisGraphicsScene* scene)
+{
+    QString viz = "http://www.gexf.net/1.3/viz";
+    xml.writeStartElement("gexf");
+    xml.writeDefaultNamespace("http://www.gexf.net/1.3");
+    xml.writeNamespace(viz, "viz");
+    xml.writeAttribute("version", "1.3");
+
+    xml.writeStartElement("graph");
+    xml.writeAttribute("defaultedgetype", scene->graph_type == VisGraphicsScene::DIRECTED ?
+                                          "directed" : "undirected");
+
+    xml.writeStartElement("nodes");
+    foreach(int id, scene->graph_node_ids()){
+        VisNode* node = scene->graph_nodes.value(id);
+        xml.writeStartElement("node");
+        xml.writeAttribute("id", QString::number(id));
+        xml.writeAttribute("label", node->labelText());
+        xml.writeEmptyElement(viz, "position");
+        xml.writeAttribute("x", QString::number(node->pos().x()));
+        xml.writeAttribute("y", QString::number(node->pos().y()));
+        xml.writeAttribute("z", "0");
+        xml.writeEndElement();
+    }
+    xml.writeEndElement();
+
+    xml.writeStartElement("edges");
+    int e = 0;
+    foreach(VisBezierCurve* curve, curvesOf(scene)){
+        xml.writeEmptyElement("edge");
+        xml.writeAttribute("id", QString::number(e++));
+        xml.writeAttribute("source", QString::number(curve->a_id));
+        xml.writeAttribute("target", QString::number(curve->b_id));
+        QString label = curve->labelText();
+        if(not label.isEmpty()){
+            xml.writeAttribute("label", label);
+            bool numeric;
+            label.toDouble(&numeric);
+            if(numeric)
+                xml.writeAttribute("weight", label);
+        }
+    }
+    xml.writeEndElement();
+
+    xml.writeEndElement();
+    xml.writeEndElement();
+}
@@ -0,0 +1,27 @@
+#ifndef VISEXPORTER_HPP
+#define VISEXPORTER_HPP
+
+#include <QString>
+
+class QXmlStreamWriter;
+class VisGraphicsScene;
+
+// Writes the scene as GraphML or GEXF with QXmlStreamWriter, element by
+// element. Vertices keep their id, position and label; edges their label,
+// and a numeric label is also written as the edge weight.
+class VisExporter
+{
+public:
+    enum FORMAT {GRAPHML, GEXF};
+
+    // GraphML unless the suffix is .gexf
+    static FORMAT formatOf(const QString& path);
+
+    static bool write(const QString& path, FORMAT format, VisGraphicsScene* scene, QString* error);
+
+private:
+    static void writeGraphml(QXmlStreamWriter& xml, VisGraphicsScene* scene);
+    static void writeGexf(QXmlStreamWriter& xml, VisGraphicsScene* scene);
+};
+
+#endif // VISEXPORTER_HPP
@@ -3,7 +3,7 @@
 
 #include <QtDebug>
 
-VisFordFulkerson::VisFordFulkerson(QList<int> ids, QWidget *parent)
+VisFordFulkerson::VisFordFulkerson(const QVector<int>& ids, QWidget *parent)
     : QDialog(parent)
 {
     setWindowTitle("Floyd Warshall");
@@ -13,24 +13,17 @@ VisFordFulkerson::VisFordFulkerson(QList<int> ids, QWidget *parent)
     ui_description->setText("Obtain the maximum flow for the network with the Ford-Fulkerson algorithm.");
 
     ui_sources_label = new QLabel("Sources:");
-    ui_sources = new QListWidget;
-    ui_sources->setSelectionMode(QListWidget::ExtendedSelection);
+    ui_sources = new VisVertexPicker(ids, true);
     ui_sources_layout = new QVBoxLayout;
     ui_sources_layout->addWidget(ui_sources_label);
     ui_sources_layout->addWidget(ui_sources);
 
     ui_sinks_label = new QLabel("Sinks:");
-    ui_sinks = new QListWidget;
-    ui_sinks->setSelectionMode(QListWidget::ExtendedSelection);
+    ui_sinks = new VisVertexPicker(ids, true);
     ui_sinks_layout = new QVBoxLayout;
     ui_sinks_layout->addWidget(ui_sinks_label);
     ui_sinks_layout->addWidget(ui_sinks);
 
-    foreach(int id, ids){
-        ui_sources->addItem(QString::number(id));
-        ui_sinks->addItem(QString::number(id));
-    }
-
     ui_options_layout = new QHBoxLayout;
     ui_options_layout->addLayout(ui_sources_layout);
     ui_options_layout->addLayout(ui_sinks_layout);
@@ -56,6 +49,13 @@ VisFordFulkerson::VisFordFulkerson(QList<int> ids, QWidget *parent)
     connect(ui_buttons, SIGNAL(accepted()), this, SLOT(accept()));
     connect(ui_buttons, SIGNAL(rejected()), this, SLOT(reject()));
 
+    // Sin fuentes o sumideros elegidos no hay con que ejecutar el algoritmo
+    connect(ui_sources, SIGNAL(visSelectionChanged()),
+            this, SLOT(visUpdateButtons()));
+    connect(ui_sinks, SIGNAL(visSelectionChanged()),
+            this, SLOT(visUpdateButtons()));
+    visUpdateButtons();
+
     ui_layout = new QVBoxLayout;
     ui_layout->addWidget(ui_description);
     ui_layout->addStretch();
@@ -79,13 +79,8 @@ int VisFordFulkerson::exec()
 {
     int response = QDialog::exec();
 
-    foreach(QListWidgetItem* li, ui_sources->selectedItems()){
-        sources.append(li->text().toInt());
-    }
-
-    foreach(QListWidgetItem* li, ui_sinks->selectedItems()){
-        sinks.append(li->text().toInt());
-    }
+    sources = ui_sources->selectedIds();
+    sinks   = ui_sinks->selectedIds();
 
     if(ui_constant_enabler->isChecked())
         constant = ui_constant->value();
@@ -94,3 +89,9 @@ int VisFordFulkerson::exec()
 
     return response;
 }
+
+void VisFordFulkerson::visUpdateButtons()
+{
+    ui_buttons->button(QDialogButtonBox::Ok)->setEnabled(ui_sources->hasSelection() and
+                                                        ui_sinks->hasSelection());
+}
@@ -10,7 +10,7 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QDialogButtonBox>
-#include <QListWidget>
+#include <VisVertexPicker.hpp>
 #include <QDoubleSpinBox>
 #include <QCheckBox>
 
@@ -19,7 +19,7 @@ class VisFordFulkerson : public QDialog
     Q_OBJECT
 
 public:
-    VisFordFulkerson(QList<int> ids, QWidget* parent = 0);
+    VisFordFulkerson(const QVector<int>& ids, QWidget* parent = 0);
     ~VisFordFulkerson();
 
     int exec();
@@ -38,10 +38,10 @@ private:
     QLabel* ui_sinks_label;
     QLabel* ui_constant_label;
 
-    QListWidget*    ui_sources;
-    QListWidget*    ui_sinks;
-    QDoubleSpinBox* ui_constant;
-    QCheckBox*      ui_constant_enabler;
+    VisVertexPicker* ui_sources;
+    VisVertexPicker* ui_sinks;
+    QDoubleSpinBox*  ui_constant;
+    QCheckBox*       ui_constant_enabler;
 
     QVBoxLayout* ui_sources_layout;
     QVBoxLayout* ui_sinks_layout;
@@ -51,6 +51,9 @@ private:
     QList<int> sources;
     QList<int> sinks;
     double constant;
+
+private slots:
+    void visUpdateButtons();
 };
 
 #endif // VISFORDFULKERSON_HPP
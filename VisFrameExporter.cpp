@@ -0,0 +1,263 @@
+#include "VisFrameExporter.hpp"
+
+#include "VisTrace.hpp"
+#include "VisDocument.hpp"
+#include "VisGraphicsScene.hpp"
+
+#include <QDir>
+#include <QPainter>
+#include <QProcess>
+#include <QRunnable>
+#include <QThreadPool>
+
+class VisFrameTask : public QRunnable
+{
+public:
+    VisFrameTask(VisFrameExporter* exporter, int block)
+        : exporter(exporter), block(block) {}
+
+    void run() { exporter->renderBlock(block); }
+
+private:
+    VisFrameExporter* exporter;
+    int               block;
+};
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Class procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+VisFrameExporter::VisFrameExporter(QObject* parent)
+    : QObject(parent), trace(NULL), frame_count(0), next_frame(0), max_frames(0)
+{
+}
+
+bool VisFrameExporter::write(const VisTrace& trace_, const VisFrameSettings& settings_)
+{
+    trace    = &trace_;
+    settings = settings_;
+    error    = "";
+    cancelled.store(0);
+    failed.store(0);
+    frames_done.store(0);
+    frames.clear();
+    next_frame = 0;
+
+    if(trace->isEmpty()){
+        error = "There is no trace to export";
+        return false;
+    }
+    if(settings.size.isEmpty()){
+        error = "Invalid frame size";
+        return false;
+    }
+    frame_count = trace->stepCount();
+    source = sceneBounds();
+    if(isStopped())
+        return false;
+
+    // Los bloques se encolan en orden, el que tiene el siguiente paso ya
+    // se esta dibujando o termino
+    QThreadPool pool;
+    max_frames = pool.maxThreadCount()*frames_per_thread;
+    for(int block = 0; block < trace->blockCount(); block++)
+        pool.start(new VisFrameTask(this, block));
+
+    if(not settings.encoder.isEmpty())
+        return writeEncoded(pool);
+
+    while(not pool.waitForDone(100))
+        emit visProgress(qint64(frames_done.load())*1000/frame_count);
+    return not isStopped();
+}
+
+void VisFrameExporter::visCancel()
+{
+    cancelled.store(1);
+    QMutexLocker locker(&mutex);
+    frame_ready.wakeAll();
+    frame_taken.wakeAll();
+}
+
+void VisFrameExporter::fail(const QString& message)
+{
+    QMutexLocker locker(&mutex);
+    if(error.isEmpty())
+        error = message;
+    failed.store(1);
+    frame_ready.wakeAll();
+    frame_taken.wakeAll();
+}
+
+bool VisFrameExporter::isStopped()
+{
+    return cancelled.load() != 0 or failed.load() != 0;
+}
+
+QRectF VisFrameExporter::sceneBounds()
+{
+    // Los keyframes tienen el grafo al empezar cada bloque, los vertices
+    // que se agregan dentro de un bloque vienen en sus cambios
+    double left = 0, top = 0, right = 0, bottom = 0;
+    bool empty = true;
+    for(int block = 0; block < trace->blockCount() and not isStopped(); block++){
+        VisDocument document;
+        if(not document.open(trace->keyframe(block))){
+            fail(document.errorString());
+            return QRectF();
+        }
+
+        QVector<QPointF> points;
+        for(quint32 i = 0; i < document.nodeCount(); i++){
+            QPointF pos(document.positions[2*i], document.positions[2*i+1]);
+            points << pos << pos + QPointF(VisNode::w, VisNode::h);
+        }
+        for(quint32 e = 0; e < document.edgeCount(); e++){
+            points << QPointF(document.ctrl_points[4*e],   document.ctrl_points[4*e+1])
+                   << QPointF(document.ctrl_points[4*e+2], document.ctrl_points[4*e+3]);
+        }
+        VisChangeSet changes = trace->changes(block, trace->blockChanges(block),
+                                              trace->firstStep(block), trace->lastStep(block));
+        foreach(const VisChange& change, changes){
+            if(change.kind == VisChange::PAINT_NODE){
+                QPointF pos(change.x, change.y);
+                points << pos << pos + QPointF(VisNode::w, VisNode::h);
+            }
+        }
+
+        foreach(const QPointF& p, points){
+            if(empty){
+                left = right = p.x();
+                top = bottom = p.y();
+                empty = false;
+            }
+            left   = qMin(left, p.x());
+            right  = qMax(right, p.x());
+            top    = qMin(top, p.y());
+            bottom = qMax(bottom, p.y());
+        }
+    }
+    return QRectF(left-margin, top-margin, right-left+2*margin, bottom-top+2*margin);
+}
+
+void VisFrameExporter::renderBlock(int block)
+{
+    if(isStopped())
+        return;
+
+    VisGraphicsScene scene;
+    scene.graph_type = trace->directed() ? VisGraphicsScene::DIRECTED : VisGraphicsScene::UNDIRECTED;
+    {
+        VisDocument document;
+        if(not document.open(trace->keyframe(block))){
+            fail(document.errorString());
+            return;
+        }
+        scene.visLoadDocument(document);
+    }
+
+    // El ultimo paso de un bloque es el primero del siguiente, lo dibuja
+    // ese bloque salvo al final de la traza
+    QByteArray data = trace->blockChanges(block);
+    int first = trace->firstStep(block);
+    int last  = trace->lastStep(block);
+    if(block < trace->blockCount()-1)
+        last--;
+
+    QImage image(settings.size, QImage::Format_ARGB32_Premultiplied);
+    for(int step = first; step <= last and not isStopped(); step++){
+        if(step > first)
+            scene.visApplyChanges(trace->changes(block, data, step-1, step));
+
+        image.fill(settings.background);
+        {
+            QPainter painter(&image);
+            painter.setRenderHint(QPainter::Antialiasing);
+            painter.setRenderHint(QPainter::TextAntialiasing);
+            scene.render(&painter, QRectF(image.rect()), source, Qt::KeepAspectRatio);
+        }
+
+        if(settings.encoder.isEmpty()){
+            QString name = settings.prefix + QString("%1").arg(step, name_digits, 10, QChar('0')) + ".png";
+            QString path = QDir(settings.directory).filePath(name);
+            if(not image.save(path, "PNG")){
+                fail("Can not write " + QDir::toNativeSeparators(path));
+                return;
+            }
+        }else{
+            deliver(step, image.convertToFormat(QImage::Format_RGBA8888));
+        }
+        frames_done.ref();
+    }
+}
+
+void VisFrameExporter::deliver(int step, const QImage& image)
+{
+    // El siguiente paso se acepta siempre, quien escribe nunca espera a un
+    // hilo que a su vez espera lugar
+    QMutexLocker locker(&mutex);
+    while(step != next_frame and frames.size() >= max_frames and not isStopped())
+        frame_taken.wait(&mutex);
+    frames.insert(step, image);
+    frame_ready.wakeAll();
+}
+
+bool VisFrameExporter::writeEncoded(QThreadPool& pool)
+{
+    QProcess encoder;
+    encoder.start(settings.encoder, settings.encoder_arguments);
+    if(not encoder.waitForStarted())
+        fail("Can not start " + settings.encoder + ": " + encoder.errorString());
+
+    while(next_frame < frame_count and not isStopped()){
+        QImage image;
+        {
+            QMutexLocker locker(&mutex);
+            if(not frames.contains(next_frame) and not isStopped())
+                frame_ready.wait(&mutex, 100);
+            if(frames.contains(next_frame)){
+                image = frames.take(next_frame);
+                next_frame++;
+                frame_taken.wakeAll();
+            }
+        }
+        emit visProgress(qint64(next_frame)*1000/frame_count);
+        if(image.isNull())
+            continue;
+
+        // Las filas RGBA de 4 bytes no llevan relleno
+        encoder.write((const char*) image.constBits(), image.byteCount());
+        while(encoder.bytesToWrite() > 0 and not isStopped()){
+            if(not encoder.waitForBytesWritten(100) and encoder.state() != QProcess::Running)
+                fail(settings.encoder + " stopped: " + QString::fromLocal8Bit(encoder.readAllStandardError()).trimmed());
+            emit visProgress(qint64(next_frame)*1000/frame_count);
+        }
+    }
+    pool.waitForDone();
+
+    if(isStopped()){
+        encoder.kill();
+        encoder.waitForFinished();
+        return false;
+    }
+
+    // El codificador termina el archivo cuando se cierra su entrada
+    encoder.closeWriteChannel();
+    while(not encoder.waitForFinished(100) and encoder.state() == QProcess::Running){
+        if(wasCancelled()){
+            encoder.kill();
+            encoder.waitForFinished();
+            return false;
+        }
+        emit visProgress(1000);
+    }
+    if(encoder.exitStatus() != QProcess::NormalExit or encoder.exitCode() != 0){
+        QString output = QString::fromLocal8Bit(encoder.readAllStandardError()).trimmed();
+        error = settings.encoder + " failed: " + output.section('\n', -1);
+        return false;
+    }
+    return true;
+}
@@ -0,0 +1,96 @@
+#ifndef VISFRAMEEXPORTER_HPP
+#define VISFRAMEEXPORTER_HPP
+
+// Parent class
+#include <QObject>
+
+// Member classes
+#include <QMap>
+#include <QSize>
+#include <QColor>
+#include <QImage>
+#include <QRectF>
+#include <QString>
+#include <QStringList>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+class QThreadPool;
+class VisTrace;
+
+// Output of an export: a PNG file per step in directory, named prefix and
+// the step number, or raw RGBA frames written to the standard input of
+// encoder when one is given
+struct VisFrameSettings
+{
+    QSize       size;
+    QColor      background;
+    QString     directory;
+    QString     prefix;
+    QString     encoder;
+    QStringList encoder_arguments;
+
+    VisFrameSettings() : size(1280, 720), background(Qt::white) {}
+};
+
+// Renders every step of a trace at a fixed resolution. Each block of the
+// trace starts with a keyframe, so the blocks are independent: a pool
+// thread loads the keyframe of a block in a scene of its own, applies the
+// changes step by step and renders each one into an image. All frames show
+// the same scene rectangle, the union of the graph in every keyframe.
+//
+// PNG files are written by the threads that render them. Frames for an
+// encoder are handed to the calling thread, which writes them in step
+// order; at most frames_per_thread frames per thread wait to be written.
+class VisFrameExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    const static int frames_per_thread = 2;
+    const static int margin            = 40;
+    // Digits of the step number in the file names
+    const static int name_digits       = 6;
+
+    VisFrameExporter(QObject* parent = 0);
+
+    bool write(const VisTrace& trace, const VisFrameSettings& settings);
+    QString errorString() const { return error; }
+    bool wasCancelled() const { return cancelled.load() != 0; }
+
+    // Called by the pool threads
+    void renderBlock(int block);
+
+signals:
+    void visProgress(int permille);
+
+public slots:
+    void visCancel();
+
+private:
+    const VisTrace*  trace;
+    VisFrameSettings settings;
+    QRectF           source;
+    int              frame_count;
+    QAtomicInt       cancelled;
+    QAtomicInt       frames_done;
+    QAtomicInt       failed;
+    QString          error;
+
+    // Frames rendered for the encoder and not yet written, by step
+    QMutex         mutex;
+    QWaitCondition frame_ready;
+    QWaitCondition frame_taken;
+    QMap<int, QImage> frames;
+    int            next_frame;
+    int            max_frames;
+
+    QRectF sceneBounds();
+    bool writeEncoded(QThreadPool& pool);
+    void deliver(int step, const QImage& image);
+    void fail(const QString& message);
+    bool isStopped();
+};
+
+#endif // VISFRAMEEXPORTER_HPP
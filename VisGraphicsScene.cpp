@@ -3,6 +3,11 @@
 #include <QGraphicsSceneMouseEvent>
 #include <QAction>
 #include <QMenu>
+#include <QTimer>
+#include <QtAlgorithms>
+
+#include "VisItemPool.hpp"
+#include "VisDocument.hpp"
 
 #include <QtDebug>
 
@@ -15,13 +20,37 @@
 ///////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////
 VisGraphicsScene::VisGraphicsScene(QObject* parent)
-    : QGraphicsScene(parent)
+    : QGraphicsScene(parent), graph_edges(true), graph_arrows(false)
 {
     setItemIndexMethod(QGraphicsScene::NoIndex);
     mode = EDIT;
     graph_type = UNDIRECTED;
     current_id = 0;
     line = NULL;
+    ctrl_update_pending = false;
+    bulk_update = false;
+    bulk_edits = 0;
+    draft = false;
+
+    connect(this, SIGNAL(selectionChanged()),
+            this, SLOT(visSelectionChanged()));
+}
+
+VisGraphicsScene::~VisGraphicsScene()
+{
+    disconnect(this, SIGNAL(selectionChanged()),
+               this, SLOT(visSelectionChanged()));
+
+    // Las curvas se eliminan antes que sus nodos, ellas se desligan de ellos
+    foreach(VisEdge* edge, graph_edges.values()){
+        delete edge;
+    }
+    foreach(VisArrow* arrow, graph_arrows.values()){
+        delete arrow;
+    }
+    foreach(VisNode* node, graph_nodes.values()){
+        delete node;
+    }
 }
 
 void VisGraphicsScene::mousePressEvent(QGraphicsSceneMouseEvent* event)
@@ -89,6 +118,9 @@ void VisGraphicsScene::mouseReleaseEvent(QGraphicsSceneMouseEvent* event)
     switch(this->mode){
     case VisGraphicsScene::EDIT:
         QGraphicsScene::mouseReleaseEvent(event);
+        // Puede terminar de arrastrar vertices o puntos de control
+        if(event->button() == Qt::LeftButton)
+            edited(GEOMETRY);
         break;
     case VisGraphicsScene::INSERT_EDGE:
         if(line == NULL) break;
@@ -168,92 +200,143 @@ void VisGraphicsScene::mouseReleaseEvent(QGraphicsSceneMouseEvent* event)
     }
 }
 
-void VisGraphicsScene::visRemoveSelected()
-{
-    QGraphicsItem* item;
-    p1_selected = selectedItems();
-    if(p1_selected.isEmpty()){
-        return;
-    }else{
-        item = p1_selected.first();
-        if(item != NULL){
-            switch(item->type()){
-            case VisNode::Type:
-                node = qgraphicsitem_cast<VisNode*>(item);
-                node->label->setSelected(false);
-                node->setSelected(false);
-                emit visNodeRemoved(node->id);
-                break;
-            case VisEdge::Type:
-                edge = qgraphicsitem_cast<VisEdge*>(item);
-                edge->label->setSelected(false);
-                edge->ctrl1->setSelected(false);
-                edge->ctrl2->setSelected(false);
-                edge->setSelected(false);
-                emit visEdgeRemoved(edge->a_id, edge->b_id);
-                break;
-            case VisArrow::Type:
-                arrow = qgraphicsitem_cast<VisArrow*>(item);
-                arrow->label->setSelected(false);
-                arrow->ctrl1->setSelected(false);
-                arrow->ctrl2->setSelected(false);
-                arrow->setSelected(false);
-                emit visArrowRemoved(arrow->a_id, arrow->b_id);
-                break;
-            default:
-                item->setSelected(false);
-                break;
-            }
-        }
-        visRemoveSelected();
-    }
-}
-
-void VisGraphicsScene::visCleanGraph()
+void VisGraphicsScene::visSelectedGraphItems(QList<int>& nodes,
+                                             QList<QPair<int,int> >& edges,
+                                             QList<QPair<int,int> >& arrows)
 {
-    QList<QGraphicsItem *> all_items = items();
-    foreach( QGraphicsItem *item, all_items ) {
+    foreach(QGraphicsItem* item, selectedItems()){
         switch(item->type()){
         case VisNode::Type:
-            node = qgraphicsitem_cast<VisNode*>(item);
-            node->set_unhighlighted();
+            nodes.append(qgraphicsitem_cast<VisNode*>(item)->id);
             break;
         case VisEdge::Type:
             edge = qgraphicsitem_cast<VisEdge*>(item);
-            edge->set_unhighlighted();
+            edges.append(QPair<int,int>(edge->a_id, edge->b_id));
             break;
         case VisArrow::Type:
             arrow = qgraphicsitem_cast<VisArrow*>(item);
-            arrow->set_unhighlighted();
-            break;
-        case VisLabel::Type:
-            label = qgraphicsitem_cast<VisLabel*>(item);
-            label->set_unhighlighted();
+            arrows.append(QPair<int,int>(arrow->a_id, arrow->b_id));
             break;
         }
-        item->update();
     }
 }
 
-void VisGraphicsScene::visUnlabelGraph()
+void VisGraphicsScene::visUnpaintItems(const QList<int>& nodes,
+                                       const QList<QPair<int,int> >& edges,
+                                       const QList<QPair<int,int> >& arrows)
+{
+    // Una sola pasada: las curvas se eliminan antes que sus nodos y la
+    // escena se repinta una vez al final
+    clearSelection();
+
+    QSet<VisBezierCurve*> removed_curves;
+    QPair<int,int> key;
+    foreach(key, edges){
+        edge = graph_edges.value(key.first, key.second);
+        if(edge == NULL) continue;
+        graph_edges.remove(key.first, key.second);
+        visUntrack(edge, edge->label);
+        removed_curves.insert(edge);
+        delete edge;
+    }
+    foreach(key, arrows){
+        arrow = graph_arrows.value(key.first, key.second);
+        if(arrow == NULL) continue;
+        graph_arrows.remove(key.first, key.second);
+        visUntrack(arrow, arrow->label);
+        removed_curves.insert(arrow);
+        delete arrow;
+    }
+    foreach(int id, nodes){
+        node = graph_nodes.value(id);
+        if(node == NULL) continue;
+        graph_nodes.remove(id);
+        visUntrack(node, node->label);
+        delete node;
+    }
+    edge = NULL;
+    arrow = NULL;
+    node = NULL;
+
+    if(!removed_curves.isEmpty()){
+        QList<VisBezierCurve*> shown;
+        foreach(VisBezierCurve* curve, ctrl_shown){
+            if(!removed_curves.contains(curve))
+                shown.append(curve);
+        }
+        ctrl_shown = shown;
+    }
+
+    edited(TOPOLOGY);
+    update(sceneRect());
+}
+
+void VisGraphicsScene::visCleanGraph()
 {
-    QList<QGraphicsItem *> all_items = items();
-    foreach( QGraphicsItem *item, all_items ) {
+    // Solo se visitan los elementos resaltados, con un unico repintado
+    QRectF dirty;
+    foreach(QGraphicsItem* item, highlighted_items){
         switch(item->type()){
         case VisNode::Type:
-            node = qgraphicsitem_cast<VisNode*>(item);
-            node->label->setPlainText("");
+            qgraphicsitem_cast<VisNode*>(item)->set_unhighlighted();
             break;
         case VisEdge::Type:
-            edge = qgraphicsitem_cast<VisEdge*>(item);
-            edge->label->setPlainText("");
+            qgraphicsitem_cast<VisEdge*>(item)->set_unhighlighted();
             break;
         case VisArrow::Type:
-            arrow = qgraphicsitem_cast<VisArrow*>(item);
-            arrow->label->setPlainText("");
+            qgraphicsitem_cast<VisArrow*>(item)->set_unhighlighted();
             break;
+        case VisLabel::Type:
+            // Las etiquetas guardan su dibujo en cache, hay que invalidarlo
+            label = qgraphicsitem_cast<VisLabel*>(item);
+            label->set_unhighlighted();
+            label->update();
+            continue;
         }
-        item->update();
+        dirty |= item->sceneBoundingRect();
+    }
+    highlighted_items.clear();
+    if(!dirty.isNull())
+        update(dirty);
+    edited(COLORS);
+}
+
+void VisGraphicsScene::visUnlabelGraph()
+{
+    foreach(VisLabel* item_label, labeled_items){
+        item_label->setText("");
+    }
+    labeled_items.clear();
+    edited(LABELS);
+}
+
+bool VisGraphicsScene::isDraft(const QGraphicsItem* item)
+{
+    VisGraphicsScene* vis_scene = qobject_cast<VisGraphicsScene*>(item->scene());
+    return vis_scene != NULL and vis_scene->draft;
+}
+
+void VisGraphicsScene::visTrackHighlight(QGraphicsItem* item)
+{
+    highlighted_items.insert(item);
+    edited(COLORS);
+}
+
+void VisGraphicsScene::visTrackLabel(VisLabel* item_label)
+{
+    if(item_label->toPlainText() != "")
+        labeled_items.insert(item_label);
+    else
+        labeled_items.remove(item_label);
+    edited(LABELS);
+}
+
+void VisGraphicsScene::visUntrack(QGraphicsItem* item, VisLabel* item_label)
+{
+    highlighted_items.remove(item);
+    if(item_label != NULL){
+        highlighted_items.remove(item_label);
+        labeled_items.remove(item_label);
     }
 }
 
@@ -267,181 +350,221 @@ void VisGraphicsScene::visUnlabelGraph()
 void VisGraphicsScene::visPaintNode(int id, double x, double y)
 {
     node = new VisNode(id, x, y);
-    graph_nodes[id] = node;
+    graph_nodes.insert(id, node);
     addItem(node);
-    addItem(node->label);
-    update(sceneRect());
+    if(node->label != NULL)
+        addItem(node->label);
+    edited(TOPOLOGY);
+    if(!bulk_update)
+        update(sceneRect());
 }
 
 void VisGraphicsScene::visUnpaintNode(int id)
 {
-    node = graph_nodes[id];
+    node = graph_nodes.value(id);
     graph_nodes.remove(id);
-    node->label->setSelected(false);
+    visUntrack(node, node->label);
+    if(node->label != NULL)
+        node->label->setSelected(false);
     node->setSelected(false);
     delete node;
     node = NULL;
-    update(sceneRect());
+    edited(TOPOLOGY);
+    if(!bulk_update)
+        update(sceneRect());
 }
 
 void VisGraphicsScene::visPaintEdge(int aid, int bid, bool with_curves)
 {
-    node1 = graph_nodes[aid];
-    node2 = graph_nodes[bid];
+    node1 = graph_nodes.value(aid);
+    node2 = graph_nodes.value(bid);
     edge = new VisEdge(node1, node2);
-    edge->straight = !with_curves;
-    graph_edges[QPair<int,int>(aid,bid)] = edge;
-    graph_edges[QPair<int,int>(bid,aid)] = edge;
-    addItem(edge->label);
-    addItem(edge->ctrl1);
-    addItem(edge->ctrl2);
+    edge->setStraight(!with_curves);
+    graph_edges.insert(aid, bid, edge);
     addItem(edge);
+    if(edge->label != NULL)
+        addItem(edge->label);
     edge->update();
-    update(sceneRect());
+    edited(TOPOLOGY);
+    if(!bulk_update)
+        update(sceneRect());
 }
 
 void VisGraphicsScene::visUnpaintEdge(int aid, int bid)
 {
-    node1 = graph_nodes[aid];
-    node2 = graph_nodes[bid];
-    edge = graph_edges[QPair<int,int>(aid,bid)];
-    graph_edges.remove(QPair<int,int>(aid,bid));
-    graph_edges.remove(QPair<int,int>(bid,aid));
-    edge->label->setSelected(false);
-    edge->ctrl1->setSelected(false);
-    edge->ctrl2->setSelected(false);
+    node1 = graph_nodes.value(aid);
+    node2 = graph_nodes.value(bid);
+    edge = graph_edges.value(aid, bid);
+    graph_edges.remove(aid, bid);
+    visUntrack(edge, edge->label);
+    if(edge->label != NULL)
+        edge->label->setSelected(false);
+    edge->destroyCtrlPoints();
     edge->setSelected(false);
+    ctrl_shown.removeAll(edge);
     delete edge;
     edge = NULL;
-    update(sceneRect());
+    edited(TOPOLOGY);
+    if(!bulk_update)
+        update(sceneRect());
 }
 
 void VisGraphicsScene::visPaintArrow(int aid, int bid, bool with_curves)
 {
-    node1 = graph_nodes[aid];
-    node2 = graph_nodes[bid];
+    node1 = graph_nodes.value(aid);
+    node2 = graph_nodes.value(bid);
     arrow = new VisArrow(node1, node2);
-    arrow->straight = !with_curves;
-    graph_arrows[QPair<int,int>(aid,bid)] = arrow;
-    addItem(arrow->label);
-    addItem(arrow->ctrl1);
-    addItem(arrow->ctrl2);
+    arrow->setStraight(!with_curves);
+    graph_arrows.insert(aid, bid, arrow);
     addItem(arrow);
+    if(arrow->label != NULL)
+        addItem(arrow->label);
     arrow->update();
-    update(sceneRect());
+    edited(TOPOLOGY);
+    if(!bulk_update)
+        update(sceneRect());
 }
 
 void VisGraphicsScene::visUnpaintArrow(int aid, int bid)
 {
-    node1 = graph_nodes[aid];
-    node2 = graph_nodes[bid];
-    arrow = graph_arrows[QPair<int,int>(aid,bid)];
-    graph_arrows.remove(QPair<int,int>(aid,bid));
+    node1 = graph_nodes.value(aid);
+    node2 = graph_nodes.value(bid);
+    arrow = graph_arrows.value(aid, bid);
+    graph_arrows.remove(aid, bid);
+    visUntrack(arrow, arrow->label);
+    if(arrow->label != NULL)
+        arrow->label->setSelected(false);
+    arrow->destroyCtrlPoints();
+    arrow->setSelected(false);
+    ctrl_shown.removeAll(arrow);
     delete arrow;
     arrow = NULL;
-    update(sceneRect());
+    edited(TOPOLOGY);
+    if(!bulk_update)
+        update(sceneRect());
 }
 
 void VisGraphicsScene::visLabelNode(int id, QString label)
 {
-    node = graph_nodes[id];
-    node->label->setPlainText(label);
+    node = graph_nodes.value(id);
+    node->setLabelText(label);
+    if(node->label != NULL)
+        visTrackLabel(node->label);
 }
 
 void VisGraphicsScene::visLabelEdge(int aid, int bid, QString label)
 {
-    edge = graph_edges[QPair<int,int>(aid,bid)];
-    edge->label->setPlainText(label);
+    edge = graph_edges.value(aid, bid);
+    edge->setLabelText(label);
+    if(edge->label != NULL)
+        visTrackLabel(edge->label);
 }
 
 void VisGraphicsScene::visLabelArrow(int aid, int bid, QString label)
 {
-    arrow = graph_arrows[QPair<int,int>(aid,bid)];
-    arrow->label->setPlainText(label);
+    arrow = graph_arrows.value(aid, bid);
+    arrow->setLabelText(label);
+    if(arrow->label != NULL)
+        visTrackLabel(arrow->label);
 }
 
 void VisGraphicsScene::visColorNode(int id, int r, int g, int b, int a)
 {
-    node = graph_nodes[id];
+    node = graph_nodes.value(id);
     node->set_highlight(r,g,b,a);
     node->update();
+    visTrackHighlight(node);
 }
 
 void VisGraphicsScene::visUncolorNode(int id)
 {
-    node = graph_nodes[id];
+    node = graph_nodes.value(id);
     node->set_unhighlighted();
     node->update();
+    edited(COLORS);
 }
 
 void VisGraphicsScene::visColorEdge(int aid, int bid, int r, int g, int b, int a)
 {
-    edge = graph_edges[QPair<int,int>(aid, bid)];
+    edge = graph_edges.value(aid, bid);
     edge->set_highlight(r,g,b,a);
     edge->update();
+    visTrackHighlight(edge);
 }
 
 void VisGraphicsScene::visUncolorEdge(int aid, int bid)
 {
-    edge = graph_edges[QPair<int,int>(aid, bid)];
+    edge = graph_edges.value(aid, bid);
     edge->set_unhighlighted();
     edge->update();
+    edited(COLORS);
 }
 
 void VisGraphicsScene::visColorArrow(int aid, int bid, int r, int g, int b, int a)
 {
-    arrow = graph_arrows[QPair<int,int>(aid, bid)];
+    arrow = graph_arrows.value(aid, bid);
     arrow->set_highlight(r,g,b,a);
     arrow->update();
+    visTrackHighlight(arrow);
 }
 
 void VisGraphicsScene::visUncolorArrow(int aid, int bid)
 {
-    arrow = graph_arrows[QPair<int,int>(aid, bid)];
+    arrow = graph_arrows.value(aid, bid);
     arrow->set_unhighlighted();
     arrow->update();
+    edited(COLORS);
 }
 
 void VisGraphicsScene::visColorNodeLabel(int id, int r, int g, int b, int a)
 {
-    node = graph_nodes[id];
-    node->label->set_highlight(r,g,b,a);
+    node = graph_nodes.value(id);
+    node->ensureLabel()->set_highlight(r,g,b,a);
     node->label->update();
+    visTrackHighlight(node->label);
 }
 
 void VisGraphicsScene::visUncolorNodeLabel(int id)
 {
-    node = graph_nodes[id];
+    node = graph_nodes.value(id);
+    if(node->label == NULL) return;
     node->label->set_unhighlighted();
     node->label->update();
+    edited(COLORS);
 }
 
 void VisGraphicsScene::visColorEdgeLabel(int aid, int bid, int r, int g, int b, int a)
 {
-    edge = graph_edges[QPair<int,int>(aid, bid)];
-    edge->label->set_highlight(r,g,b,a);
+    edge = graph_edges.value(aid, bid);
+    edge->ensureLabel()->set_highlight(r,g,b,a);
     edge->label->update();
+    visTrackHighlight(edge->label);
 }
 
 void VisGraphicsScene::visUncolorEdgeLabel(int aid, int bid)
 {
-    edge = graph_edges[QPair<int,int>(aid, bid)];
+    edge = graph_edges.value(aid, bid);
+    if(edge->label == NULL) return;
     edge->label->set_unhighlighted();
     edge->label->update();
+    edited(COLORS);
 }
 
 void VisGraphicsScene::visColorArrowLabel(int aid, int bid, int r, int g, int b, int a)
 {
-    arrow = graph_arrows[QPair<int,int>(aid, bid)];
-    arrow->label->set_highlight(r,g,b,a);
+    arrow = graph_arrows.value(aid, bid);
+    arrow->ensureLabel()->set_highlight(r,g,b,a);
     arrow->label->update();
+    visTrackHighlight(arrow->label);
 }
 
 void VisGraphicsScene::visUncolorArrowLabel(int aid, int bid)
 {
-    arrow = graph_arrows[QPair<int,int>(aid, bid)];
+    arrow = graph_arrows.value(aid, bid);
+    if(arrow->label == NULL) return;
     arrow->label->set_unhighlighted();
     arrow->label->update();
+    edited(COLORS);
 }
 
 void VisGraphicsScene::visIncrementId()
@@ -452,37 +575,312 @@ void VisGraphicsScene::visIncrementId()
 void VisGraphicsScene::visResetId()
 {
     current_id = 0;
+    edited(TOPOLOGY);
+}
+
+void VisGraphicsScene::visApplyChanges(const VisChangeSet& changes)
+{
+    bulk_update = true;
+    foreach(const VisChange& change, changes){
+        const QColor& c = change.color;
+        switch(change.kind){
+        case VisChange::PAINT_NODE:
+            visPaintNode(change.aid, change.x, change.y);
+            visIncrementId();
+            break;
+        case VisChange::UNPAINT_NODE:
+            visUnpaintNode(change.aid);
+            break;
+        case VisChange::PAINT_EDGE:
+            visPaintEdge(change.aid, change.bid, change.with_curves);
+            break;
+        case VisChange::UNPAINT_EDGE:
+            visUnpaintEdge(change.aid, change.bid);
+            break;
+        case VisChange::PAINT_ARROW:
+            visPaintArrow(change.aid, change.bid, change.with_curves);
+            break;
+        case VisChange::UNPAINT_ARROW:
+            visUnpaintArrow(change.aid, change.bid);
+            break;
+        case VisChange::LABEL_NODE:
+            visLabelNode(change.aid, change.text);
+            break;
+        case VisChange::LABEL_EDGE:
+            visLabelEdge(change.aid, change.bid, change.text);
+            break;
+        case VisChange::LABEL_ARROW:
+            visLabelArrow(change.aid, change.bid, change.text);
+            break;
+        case VisChange::COLOR_NODE:
+            visColorNode(change.aid, c.red(), c.green(), c.blue(), c.alpha());
+            break;
+        case VisChange::UNCOLOR_NODE:
+            visUncolorNode(change.aid);
+            break;
+        case VisChange::COLOR_EDGE:
+            visColorEdge(change.aid, change.bid, c.red(), c.green(), c.blue(), c.alpha());
+            break;
+        case VisChange::UNCOLOR_EDGE:
+            visUncolorEdge(change.aid, change.bid);
+            break;
+        case VisChange::COLOR_ARROW:
+            visColorArrow(change.aid, change.bid, c.red(), c.green(), c.blue(), c.alpha());
+            break;
+        case VisChange::UNCOLOR_ARROW:
+            visUncolorArrow(change.aid, change.bid);
+            break;
+        case VisChange::COLOR_NODE_LABEL:
+            visColorNodeLabel(change.aid, c.red(), c.green(), c.blue(), c.alpha());
+            break;
+        case VisChange::UNCOLOR_NODE_LABEL:
+            visUncolorNodeLabel(change.aid);
+            break;
+        case VisChange::COLOR_EDGE_LABEL:
+            visColorEdgeLabel(change.aid, change.bid, c.red(), c.green(), c.blue(), c.alpha());
+            break;
+        case VisChange::UNCOLOR_EDGE_LABEL:
+            visUncolorEdgeLabel(change.aid, change.bid);
+            break;
+        case VisChange::COLOR_ARROW_LABEL:
+            visColorArrowLabel(change.aid, change.bid, c.red(), c.green(), c.blue(), c.alpha());
+            break;
+        case VisChange::UNCOLOR_ARROW_LABEL:
+            visUncolorArrowLabel(change.aid, change.bid);
+            break;
+        case VisChange::CLEAR_GRAPH:
+            visClearGraph();
+            break;
+        }
+    }
+    bulk_update = false;
+    edited(bulk_edits);
+    update(sceneRect());
+}
+
+void VisGraphicsScene::visClearGraph()
+{
+    // QGraphicsScene::clear() vacia el indice de una sola vez; antes se
+    // desligan los elementos para que sus destructores no se refieran a
+    // otros ya eliminados
+    foreach(VisEdge* edge, graph_edges.values()){
+        edge->forgetAttachments();
+    }
+    foreach(VisArrow* arrow, graph_arrows.values()){
+        arrow->forgetAttachments();
+    }
+    foreach(VisNode* node, graph_nodes.values()){
+        node->forgetAttachments();
+    }
+
+    graph_nodes.clear();
+    graph_edges.clear();
+    graph_arrows.clear();
+    highlighted_items.clear();
+    labeled_items.clear();
+    ctrl_shown.clear();
+    p1_selected.clear();
+    p2_selected.clear();
+    node = node1 = node2 = NULL;
+    edge = NULL;
+    arrow = NULL;
+    label = NULL;
+    line = NULL;
+
+    clear();
+
+    // Todos los elementos se eliminaron, sus bloques vuelven al sistema
+    VisItemPool<VisNode>::release();
+    VisItemPool<VisEdge>::release();
+    VisItemPool<VisArrow>::release();
+    VisItemPool<VisLabel>::release();
+    VisItemPool<VisPoint>::release();
+
+    edited(TOPOLOGY);
+}
+
+void VisGraphicsScene::visLoadDocument(const VisDocument& document)
+{
+    bulk_update = true;
+
+    quint32 n = document.nodeCount();
+    QVector<VisNode*> nodes(n);
+    for(quint32 i = 0; i < n; i++){
+        if(graph_nodes.contains(document.ids[i])){
+            nodes[i] = graph_nodes.value(document.ids[i]);
+            continue;
+        }
+        node = new VisNode(document.ids[i], document.positions[2*i], document.positions[2*i+1]);
+        nodes[i] = node;
+        graph_nodes.insert(node->id, node);
+        addItem(node);
+
+        quint8 flags = document.node_flags[i];
+        node->setLabelText(document.nodeLabel(i));
+        if(flags & VisDocument::HIGHLIGHTED){
+            QColor c = QColor::fromRgba(document.node_colors[i]);
+            node->set_highlight(c.red(), c.green(), c.blue(), c.alpha());
+            visTrackHighlight(node);
+        }
+        if(flags & VisDocument::LABEL_HIGHLIGHTED){
+            QColor c = QColor::fromRgba(document.node_label_colors[i]);
+            node->ensureLabel()->set_highlight(c.red(), c.green(), c.blue(), c.alpha());
+            visTrackHighlight(node->label);
+        }
+        if(node->label != NULL)
+            visTrackLabel(node->label);
+    }
+
+    VisBezierCurve* curve;
+    for(quint32 i = 0; i < n; i++){
+        for(quint32 e = document.rows[i]; e < document.rows[i+1] and e < document.edgeCount(); e++){
+            // Indices fuera de rango, lazos no dirigidos o curvas repetidas
+            // solo pueden venir de un archivo dañado
+            quint32 j = document.targets[e];
+            if(j >= n)
+                continue;
+            if(graph_type == DIRECTED ? graph_arrows.contains(nodes[i]->id, nodes[j]->id)
+                                      : i == j or graph_edges.contains(nodes[i]->id, nodes[j]->id))
+                continue;
+
+            quint8 flags = document.edge_flags[e];
+            if(graph_type == DIRECTED){
+                arrow = new VisArrow(nodes[i], nodes[j]);
+                graph_arrows.insert(arrow->a_id, arrow->b_id, arrow);
+                curve = arrow;
+            }else{
+                edge = new VisEdge(nodes[i], nodes[j]);
+                graph_edges.insert(edge->a_id, edge->b_id, edge);
+                curve = edge;
+            }
+            // Las curvas nacen curvas; las rectas rehacen su geometria con
+            // los puntos que calcula el constructor
+            if(flags & VisDocument::STRAIGHT)
+                curve->setStraight(true);
+            else
+                curve->setCtrlPositions(QPointF(document.ctrl_points[4*e],   document.ctrl_points[4*e+1]),
+                                        QPointF(document.ctrl_points[4*e+2], document.ctrl_points[4*e+3]));
+            addItem(curve);
+
+            curve->setLabelText(document.edgeLabel(e));
+            if(flags & VisDocument::HIGHLIGHTED){
+                QColor c = QColor::fromRgba(document.edge_colors[e]);
+                curve->set_highlight(c.red(), c.green(), c.blue(), c.alpha());
+                visTrackHighlight(curve);
+            }
+            if(flags & VisDocument::LABEL_HIGHLIGHTED){
+                QColor c = QColor::fromRgba(document.edge_label_colors[e]);
+                curve->ensureLabel()->set_highlight(c.red(), c.green(), c.blue(), c.alpha());
+                visTrackHighlight(curve->label);
+            }
+            if(curve->label != NULL)
+                visTrackLabel(curve->label);
+        }
+    }
+
+    current_id = document.nextId();
+
+    bulk_update = false;
+    edited(TOPOLOGY);
+    update(sceneRect());
+}
+
+QVector<int> VisGraphicsScene::graph_node_ids()
+{
+    QVector<int> ids = graph_nodes.keys().toVector();
+    qSort(ids);
+    return ids;
 }
 
 QPointF VisGraphicsScene::visPosNode(int id)
 {
-    node = graph_nodes[id];
-    return node->pos();
+    // Un vertice de un lote aun no aplicado no tiene nodo todavia
+    VisNode* pos_node = graph_nodes.value(id);
+    if(pos_node == NULL)
+        return QPointF(0, 0);
+    return pos_node->pos();
 }
 
 void VisGraphicsScene::visMoveNode(int id, double dx, double dy)
 {
-    node = graph_nodes[id];
+    // Los pasos del resorte pueden llegar despues de borrar el grafo
+    node = graph_nodes.value(id);
+    if(node == NULL)
+        return;
     double newx = node->pos().x()+dx;
     double newy = node->pos().y()+dy;
     if((newx > -2450 or newx < 2450) and
        (newy > -2450 or newy < 2450)){
         qDebug() << newx << " " << newy;
         node->moveBy(dx,dy);
-        node->update();
+        edited(GEOMETRY);
+        emit visInteraction();
     }
 }
 
 void VisGraphicsScene::setWithCurves(bool with_curves)
 {
     foreach(VisEdge* edge, graph_edges.values()){
-        edge->straight = !with_curves;
-        edge->setCtrlPoints(edge->ctrl1, edge->ctrl2);
-        edge->update();
+        edge->setStraight(!with_curves);
     }
     foreach(VisArrow* arrow, graph_arrows.values()){
-        arrow->straight = !with_curves;
-        arrow->setCtrlPoints(arrow->ctrl1, arrow->ctrl2);
-        arrow->update();
+        arrow->setStraight(!with_curves);
+    }
+    edited(GEOMETRY);
+}
+
+void VisGraphicsScene::edited(int edits)
+{
+    // Dentro de un lote se acumula y se avisa una vez al terminar
+    if(bulk_update){
+        bulk_edits |= edits;
+        return;
+    }
+    edits |= bulk_edits;
+    bulk_edits = 0;
+    if(edits != 0)
+        emit visEdited(edits);
+}
+
+void VisGraphicsScene::visSelectionChanged()
+{
+    // Se actualiza despues del evento que cambio la seleccion, el punto de
+    // control que lo recibe no puede eliminarse durante el mismo
+    if(ctrl_update_pending)
+        return;
+    ctrl_update_pending = true;
+    QTimer::singleShot(0, this, SLOT(visUpdateCtrlPoints()));
+}
+
+void VisGraphicsScene::visUpdateCtrlPoints()
+{
+    ctrl_update_pending = false;
+
+    // Los puntos de control solo existen mientras la curva o alguno de
+    // sus puntos este seleccionado
+    QList<VisBezierCurve*> shown;
+    foreach(QGraphicsItem* item, selectedItems()){
+        VisBezierCurve* curve = NULL;
+        switch(item->type()){
+        case VisEdge::Type:
+            curve = qgraphicsitem_cast<VisEdge*>(item);
+            break;
+        case VisArrow::Type:
+            curve = qgraphicsitem_cast<VisArrow*>(item);
+            break;
+        case VisPoint::Type:
+            curve = qgraphicsitem_cast<VisPoint*>(item)->curve;
+            break;
+        }
+        if(curve != NULL and !shown.contains(curve))
+            shown.append(curve);
+    }
+    foreach(VisBezierCurve* curve, ctrl_shown){
+        if(!shown.contains(curve))
+            curve->updateCtrlVisibility();
+    }
+    foreach(VisBezierCurve* curve, shown){
+        curve->updateCtrlVisibility();
     }
+    ctrl_shown = shown;
 }
@@ -5,10 +5,15 @@
 #include <QGraphicsScene>
 
 // Member classes
+#include <QSet>
 #include <VisNode.hpp>
 #include <VisEdge.hpp>
 #include <VisArrow.hpp>
 #include <VisLabel.hpp>
+#include <VisChangeSet.hpp>
+#include <VisItemTable.hpp>
+
+class VisDocument;
 
 class VisGraphicsScene : public QGraphicsScene
 {
@@ -17,29 +22,52 @@ class VisGraphicsScene : public QGraphicsScene
 public:
     enum MODE  {EDIT, INSERT_VERTEX, INSERT_EDGE, INSERT_ARROW, INSERT_LABEL} mode;
     enum GRAPH {UNDIRECTED, DIRECTED} graph_type;
+    // What an edit changed in the graph, given by visEdited
+    enum EDITS {TOPOLOGY = 1, GEOMETRY = 2, COLORS = 4, LABELS = 8};
 
     VisGraphicsScene(QObject* parent = 0);
+    ~VisGraphicsScene();
 
     void mousePressEvent(QGraphicsSceneMouseEvent*);
     void mouseMoveEvent(QGraphicsSceneMouseEvent*);
     void mouseReleaseEvent(QGraphicsSceneMouseEvent*);
 
-    void visRemoveSelected();
+    void visSelectedGraphItems(QList<int>& nodes,
+                               QList<QPair<int,int> >& edges,
+                               QList<QPair<int,int> >& arrows);
+    void visUnpaintItems(const QList<int>& nodes,
+                         const QList<QPair<int,int> >& edges,
+                         const QList<QPair<int,int> >& arrows);
     void visCleanGraph();
     void visUnlabelGraph();
 
     int id() { return current_id; }
 
+    // Set by the view while the user interacts; items then draw a cheaper
+    // approximation, whatever the render hints of the painter
+    bool draft;
+    static bool isDraft(const QGraphicsItem* item);
+
     QPointF visPosNode(int id);
 
-    QList<int> graph_node_ids() { return graph_nodes.keys(); }
+    // Sorted ids of the drawn vertices
+    QVector<int> graph_node_ids();
 
     void setWithCurves(bool with_curves);
 
-    QHash<int, VisNode*>             graph_nodes;
-    QHash<QPair<int,int>, VisEdge*>  graph_edges;
-    QHash<QPair<int,int>, VisArrow*> graph_arrows;
-    QHash<int, VisLabel*>            graph_labels;
+    // Creates every item of an opened document at once, the scene must be
+    // empty and of the document's graph type
+    void visLoadDocument(const VisDocument& document);
+
+    // Items that may be highlighted or labeled, the only ones visited by
+    // visCleanGraph and visUnlabelGraph
+    void visTrackHighlight(QGraphicsItem* item);
+    void visTrackLabel(VisLabel* item_label);
+    void visUntrack(QGraphicsItem* item, VisLabel* item_label);
+
+    VisIdTable<VisNode>     graph_nodes;
+    VisPairTable<VisEdge>   graph_edges;
+    VisPairTable<VisArrow>  graph_arrows;
 
 private:
     VisNode*              node;
@@ -59,6 +87,19 @@ private:
 
     int current_id;
 
+    // Curves whose control points currently exist
+    QList<VisBezierCurve*> ctrl_shown;
+    bool ctrl_update_pending;
+
+    // Set while applying a change set, the scene is repainted once at the end
+    bool bulk_update;
+    int  bulk_edits;
+
+    void edited(int edits);
+
+    QSet<QGraphicsItem*> highlighted_items;
+    QSet<VisLabel*>      labeled_items;
+
 signals:
     void visNodeAdded(double x, double y);
     void visNodeRemoved(int id);
@@ -67,6 +108,12 @@ signals:
     void visArrowAdded(int aid, int bid);
     void visArrowRemoved(int aid, int bid);
 
+    // Items are moving (layout steps), views may lower their quality
+    void visInteraction();
+
+    // The graph changed, not only its drawing; once per change set
+    void visEdited(int edits);
+
 public slots:
     void visPaintNode(int id, double x, double y);
     void visUnpaintNode(int id);
@@ -91,8 +138,14 @@ public slots:
     void visUncolorArrowLabel(int aid, int bid);
     void visIncrementId();
     void visResetId();
+    void visClearGraph();
+    void visApplyChanges(const VisChangeSet& changes);
 
     void visMoveNode(int id, double dx, double dy);
+
+private slots:
+    void visSelectionChanged();
+    void visUpdateCtrlPoints();
 };
 
 #endif // VISGRAPHICSSCENE_HPP
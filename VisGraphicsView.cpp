@@ -1,10 +1,11 @@
 #include "VisGraphicsView.hpp"
+#include "VisLabel.hpp"
 
 #include <QWheelEvent>
 #include <QMenu>
 
 VisGraphicsView::VisGraphicsView(VisGraphicsScene* vis_scene_, QWidget* parent)
-    : QGraphicsView(parent), vis_scene(vis_scene_)
+    : QGraphicsView(parent), draft(false), vis_scene(vis_scene_)
 {
     setScene(vis_scene);
     setSceneRect(-2500,-2500,5000,5000);
@@ -13,6 +14,15 @@ VisGraphicsView::VisGraphicsView(VisGraphicsScene* vis_scene_, QWidget* parent)
     setHorizontalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     setVerticalScrollBarPolicy(Qt::ScrollBarAlwaysOff);
     setViewportUpdateMode(QGraphicsView::FullViewportUpdate);
+
+    idle_timer = new QTimer(this);
+    idle_timer->setSingleShot(true);
+    idle_timer->setInterval(idle_interval);
+
+    connect(idle_timer, SIGNAL(timeout()),
+            this,       SLOT(visRefine()));
+    connect(vis_scene,  SIGNAL(visInteraction()),
+            this,       SLOT(visInteraction()));
 }
 
 void VisGraphicsView::mousePressEvent(QMouseEvent* event)
@@ -33,7 +43,36 @@ void VisGraphicsView::mousePressEvent(QMouseEvent* event)
     QGraphicsView::mousePressEvent(event);
 }
 
+void VisGraphicsView::mouseMoveEvent(QMouseEvent* event)
+{
+    // Arrastrar nodos o desplazar la vista
+    if(event->buttons() != Qt::NoButton)
+        visInteraction();
+    QGraphicsView::mouseMoveEvent(event);
+}
+
 void VisGraphicsView::wheelEvent(QWheelEvent* event)
 {
+    visInteraction();
     QGraphicsView::wheelEvent(new QWheelEvent(event->posF(), event->delta()/10, event->buttons(),event->modifiers(),event->orientation()));
 }
+
+void VisGraphicsView::visInteraction()
+{
+    // El borrador lo dibujan los elementos, el antialiasing es de la vista
+    if(!draft){
+        draft = true;
+        vis_scene->draft = true;
+        setRenderHint(QPainter::Antialiasing, false);
+    }
+    idle_timer->start();
+}
+
+void VisGraphicsView::visRefine()
+{
+    draft = false;
+    vis_scene->draft = false;
+    setRenderHint(QPainter::Antialiasing, true);
+    VisLabel::refineDraftPainted();
+    viewport()->update();
+}
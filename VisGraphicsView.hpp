@@ -5,19 +5,34 @@
 #include <QGraphicsView>
 
 // Member classes
+#include <QTimer>
 #include <VisGraphicsScene.hpp>
 
 class VisGraphicsView : public QGraphicsView
 {
+    Q_OBJECT
+
 public:
     VisGraphicsView(VisGraphicsScene* vis_scene_, QWidget* parent = 0);
 
     void mousePressEvent(QMouseEvent*);
+    void mouseMoveEvent(QMouseEvent*);
     void wheelEvent(QWheelEvent*);
 
+    // Time without interaction before refining to full quality (ms)
+    const static int idle_interval = 250;
+
+    bool draft;
 
 private:
     VisGraphicsScene* vis_scene;
+
+    QTimer* idle_timer;
+
+public slots:
+    // Render at reduced quality until the interaction stops
+    void visInteraction();
+    void visRefine();
 };
 
 #endif // VISGRAPHICSVIEW_HPP
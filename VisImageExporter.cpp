@@ -0,0 +1,549 @@
+#include "VisImageExporter.hpp"
+
+#include "VisDocument.hpp"
+#include "VisGraphicsScene.hpp"
+
+#include <QSaveFile>
+#include <QFileInfo>
+#include <QPainter>
+#include <QFontMetricsF>
+#include <QRunnable>
+#include <QThreadPool>
+#include <QSvgGenerator>
+#include <QtEndian>
+
+#include <cmath>
+#include <cstring>
+#include <zlib.h>
+
+static QPointF centerOf(const VisDocument& document, quint32 i)
+{
+    return QPointF(document.positions[2*i]+VisNode::w/2.0, document.positions[2*i+1]+VisNode::h/2.0);
+}
+
+static QRectF labelRect(const QFontMetricsF& metrics, const QString& text, const QPointF& anchor)
+{
+    // Como VisLabel::reanchor, centrada sobre el ancla
+    double lw = metrics.width(text)+2*VisLabel::margin;
+    double lh = metrics.height()+2*VisLabel::margin;
+    return QRectF(anchor.x()-lw/2.0, anchor.y()-lh-6, lw, lh);
+}
+
+class VisTileTask : public QRunnable
+{
+public:
+    VisTileTask(VisImageExporter* exporter, uchar* data, int stride, int x, int y, int width, int height)
+        : exporter(exporter), data(data), stride(stride), x(x), y(y), width(width), height(height) {}
+
+    void run() { exporter->renderTile(data, stride, x, y, width, height); }
+
+private:
+    VisImageExporter* exporter;
+    uchar* data;
+    int    stride;
+    int    x, y;
+    int    width, height;
+};
+
+// PNG written row by row: the rows, unfiltered, go through a single
+// deflate stream and leave as IDAT chunks of buffer_size bytes
+class VisPngWriter
+{
+public:
+    const static int buffer_size = 1 << 16;
+
+    VisPngWriter(QIODevice* out, int width, int height, bool alpha);
+    ~VisPngWriter() { deflateEnd(&stream); }
+
+    bool writeRows(const QImage& strip, int rows);
+    bool finish();
+
+private:
+    QIODevice* out;
+    int        width;
+    bool       alpha;
+    bool       ok;
+    z_stream   stream;
+    QByteArray row;
+    QByteArray buffer;
+    int        used;
+
+    bool chunk(const char* type, const QByteArray& data);
+    bool compress(const uchar* data, int size, int flush);
+};
+
+VisPngWriter::VisPngWriter(QIODevice* out_, int width_, int height, bool alpha_)
+    : out(out_), width(width_), alpha(alpha_), used(0)
+{
+    memset(&stream, 0, sizeof(stream));
+    ok = deflateInit(&stream, Z_DEFAULT_COMPRESSION) == Z_OK;
+    // El primer byte de cada fila es el tipo de filtro, 0 sin filtro
+    row.fill(0, 1+width*(alpha ? 4 : 3));
+    buffer.resize(buffer_size);
+
+    QByteArray header(13, 0);
+    qToBigEndian<quint32>(width,  (uchar*) header.data());
+    qToBigEndian<quint32>(height, (uchar*) header.data()+4);
+    header[8]  = 8;                 // bits por canal
+    header[9]  = alpha ? 6 : 2;     // RGBA o RGB
+    ok = ok and out->write("\x89PNG\r\n\x1a\n", 8) == 8 and chunk("IHDR", header);
+}
+
+bool VisPngWriter::chunk(const char* type, const QByteArray& data)
+{
+    uchar length[4];
+    qToBigEndian<quint32>(data.size(), length);
+    uLong crc = crc32(0, (const Bytef*) type, 4);
+    crc = crc32(crc, (const Bytef*) data.constData(), data.size());
+    uchar check[4];
+    qToBigEndian<quint32>(crc, check);
+    return out->write((const char*) length, 4) == 4 and out->write(type, 4) == 4 and
+           out->write(data) == data.size() and out->write((const char*) check, 4) == 4;
+}
+
+bool VisPngWriter::compress(const uchar* data, int size, int flush)
+{
+    stream.next_in  = (Bytef*) data;
+    stream.avail_in = size;
+    for(;;){
+        stream.next_out  = (Bytef*) buffer.data()+used;
+        stream.avail_out = buffer.size()-used;
+        int status = deflate(&stream, flush);
+        if(status == Z_STREAM_ERROR)
+            return false;
+        used = buffer.size()-stream.avail_out;
+        if(used == buffer.size()){
+            if(not chunk("IDAT", buffer))
+                return false;
+            used = 0;
+            continue;
+        }
+        if(flush == Z_FINISH ? status == Z_STREAM_END : stream.avail_in == 0)
+            return true;
+    }
+}
+
+bool VisPngWriter::writeRows(const QImage& strip, int rows)
+{
+    // Sin filtro; los pixeles vienen premultiplicados
+    uchar* out_row = (uchar*) row.data();
+    for(int y = 0; y < rows and ok; y++){
+        const QRgb* line = (const QRgb*) strip.constScanLine(y);
+        uchar* p = out_row+1;
+        for(int x = 0; x < width; x++){
+            QRgb pixel = alpha ? qUnpremultiply(line[x]) : line[x];
+            *p++ = qRed(pixel);
+            *p++ = qGreen(pixel);
+            *p++ = qBlue(pixel);
+            if(alpha)
+                *p++ = qAlpha(pixel);
+        }
+        ok = compress(out_row, row.size(), Z_NO_FLUSH);
+    }
+    return ok;
+}
+
+bool VisPngWriter::finish()
+{
+    ok = ok and compress(NULL, 0, Z_FINISH);
+    if(ok and used > 0)
+        ok = chunk("IDAT", buffer.left(used));
+    return ok and chunk("IEND", QByteArray());
+}
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Class procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+VisImageExporter::VisImageExporter(QObject* parent)
+    : QObject(parent), document(NULL), tile_columns(0), tile_height(tile_size)
+{
+}
+
+VisImageExporter::FORMAT VisImageExporter::formatOf(const QString& path)
+{
+    return QFileInfo(path).suffix().toLower() == "svg" ? SVG : PNG;
+}
+
+bool VisImageExporter::write(const QString& path, VisGraphicsScene* scene, const VisImageSettings& settings)
+{
+    VisDocument snapshot;
+    if(not snapshot.open(VisDocument::contentOf(scene))){
+        error = snapshot.errorString();
+        return false;
+    }
+    return write(path, snapshot, settings);
+}
+
+bool VisImageExporter::write(const QString& path, const VisDocument& document_, const VisImageSettings& settings_)
+{
+    document = &document_;
+    settings = settings_;
+    error    = "";
+    cancelled.store(0);
+
+    if(not (settings.scale > 0)){
+        error = "Invalid scale";
+        return false;
+    }
+    if(document->nodeCount() == 0){
+        error = "The graph is empty";
+        return false;
+    }
+
+    id_font    = QFont();
+    label_font = VisLabel::labelFont();
+    measure();
+
+    // Una fila RGBA de la franja tiene que caber en un int
+    QSize size = imageSize();
+    if(size.isEmpty() or size.width() > (1 << 28) or size.height() > (1 << 28)){
+        error = QString("The image would be %1 x %2 pixels, choose a smaller scale")
+                .arg(ceil(bounds.width()*settings.scale)).arg(ceil(bounds.height()*settings.scale));
+        return false;
+    }
+
+    bool ok = formatOf(path) == SVG ? writeSvg(path) : writePng(path);
+    document = NULL;
+    tiles.clear();
+    return ok;
+}
+
+QSize VisImageExporter::imageSize() const
+{
+    double width  = ceil(bounds.width()*settings.scale);
+    double height = ceil(bounds.height()*settings.scale);
+    if(width > 2147483647.0 or height > 2147483647.0)
+        return QSize();
+    return QSize(width, height);
+}
+
+void VisImageExporter::visCancel()
+{
+    cancelled.store(1);
+}
+
+void VisImageExporter::measure()
+{
+    quint32 n = document->nodeCount();
+    quint32 m = document->edgeCount();
+
+    sources.fill(n, m);
+    for(quint32 i = 0; i < n; i++)
+        for(quint32 e = document->rows[i]; e < document->rows[i+1] and e < m; e++)
+            sources[e] = i;
+
+    // Las etiquetas que no se dibujan no ocupan lugar
+    QFontMetricsF metrics(label_font);
+    bool labels = settings.detail == VisImageSettings::FULL and
+                  metrics.height()*settings.scale >= min_text_pixels;
+
+    node_rects.resize(n);
+    node_label_rects.fill(QRectF(), n);
+    bounds = QRectF();
+    for(quint32 i = 0; i < n; i++){
+        // El resaltado se extiende 5 unidades fuera del circulo
+        QPointF pos(document->positions[2*i], document->positions[2*i+1]);
+        node_rects[i] = QRectF(pos, QSizeF(VisNode::w, VisNode::h)).adjusted(-5, -5, 5, 5);
+        bounds |= node_rects[i];
+
+        QString text = labels ? document->nodeLabel(i) : QString();
+        if(not text.isEmpty()){
+            node_label_rects[i] = labelRect(metrics, text, pos+QPointF(VisNode::w/2.0, 0));
+            bounds |= node_label_rects[i];
+        }
+    }
+
+    edge_rects.fill(QRectF(), m);
+    edge_label_rects.fill(QRectF(), m);
+    bool directed = document->directed();
+    for(quint32 e = 0; e < m; e++){
+        // Los mismos arcos que VisGraphicsScene::visLoadDocument
+        quint32 i = sources[e];
+        quint32 j = document->targets[e];
+        if(i >= n or j >= n or (not directed and i == j))
+            continue;
+
+        QPolygonF points;
+        points << centerOf(*document, i) << centerOf(*document, j);
+        if(not (document->edge_flags[e] & VisDocument::STRAIGHT))
+            points << QPointF(document->ctrl_points[4*e],   document->ctrl_points[4*e+1])
+                   << QPointF(document->ctrl_points[4*e+2], document->ctrl_points[4*e+3]);
+        // Medio ancho del resaltado y el radio de la punta de flecha
+        edge_rects[e] = points.boundingRect().adjusted(-5, -5, 5, 5);
+        bounds |= edge_rects[e];
+
+        QString text = labels ? document->edgeLabel(e) : QString();
+        if(not text.isEmpty()){
+            edge_label_rects[e] = labelRect(metrics, text, curveOf(e).pointAtPercent(.5));
+            bounds |= edge_label_rects[e];
+        }
+    }
+    bounds.adjust(-margin, -margin, margin, margin);
+}
+
+QRect VisImageExporter::tilesOf(const QRectF& rect) const
+{
+    // Columnas y filas de baldosas que toca el rectangulo, inclusive
+    double s = settings.scale;
+    int rows = tiles.size()/tile_columns;
+    int left   = qMax(0, int(floor((rect.left()-bounds.left())*s/tile_size)));
+    int top    = qMax(0, int(floor((rect.top()-bounds.top())*s/tile_height)));
+    int right  = qMin(tile_columns-1, int(floor((rect.right()-bounds.left())*s/tile_size)));
+    int bottom = qMin(rows-1, int(floor((rect.bottom()-bounds.top())*s/tile_height)));
+    return QRect(QPoint(left, top), QPoint(right, bottom));
+}
+
+void VisImageExporter::sortIntoTiles(int height)
+{
+    QSize size = imageSize();
+    tile_height  = height;
+    tile_columns = (size.width()+tile_size-1)/tile_size;
+    tiles.clear();
+    tiles.resize(tile_columns*((size.height()+height-1)/height));
+
+    // Un elemento va a cada baldosa que toca su rectangulo; se recorren en
+    // orden, asi cada lista queda en el orden de los elementos
+    quint32 n = document->nodeCount();
+    quint32 m = document->edgeCount();
+    for(quint32 e = 0; e < m; e++){
+        if(edge_rects[e].isNull())
+            continue;
+        QRect r = tilesOf(edge_rects[e]);
+        for(int row = r.top(); row <= r.bottom(); row++)
+            for(int column = r.left(); column <= r.right(); column++)
+                tiles[row*tile_columns+column].edges.append(e);
+    }
+    for(quint32 i = 0; i < n; i++){
+        QRect r = tilesOf(node_rects[i]);
+        for(int row = r.top(); row <= r.bottom(); row++)
+            for(int column = r.left(); column <= r.right(); column++)
+                tiles[row*tile_columns+column].nodes.append(i);
+    }
+    for(quint32 i = 0; i < n; i++){
+        if(node_label_rects[i].isNull())
+            continue;
+        QRect r = tilesOf(node_label_rects[i]);
+        for(int row = r.top(); row <= r.bottom(); row++)
+            for(int column = r.left(); column <= r.right(); column++)
+                tiles[row*tile_columns+column].node_labels.append(i);
+    }
+    for(quint32 e = 0; e < m; e++){
+        if(edge_label_rects[e].isNull())
+            continue;
+        QRect r = tilesOf(edge_label_rects[e]);
+        for(int row = r.top(); row <= r.bottom(); row++)
+            for(int column = r.left(); column <= r.right(); column++)
+                tiles[row*tile_columns+column].edge_labels.append(e);
+    }
+}
+
+QPainterPath VisImageExporter::curveOf(quint32 e) const
+{
+    QPainterPath path(centerOf(*document, sources[e]));
+    QPointF end = centerOf(*document, document->targets[e]);
+    if(document->edge_flags[e] & VisDocument::STRAIGHT)
+        path.lineTo(end);
+    else
+        path.cubicTo(QPointF(document->ctrl_points[4*e],   document->ctrl_points[4*e+1]),
+                     QPointF(document->ctrl_points[4*e+2], document->ctrl_points[4*e+3]), end);
+    return path;
+}
+
+void VisImageExporter::paintLabel(QPainter* painter, const QRectF& rect, const QString& text,
+                                  bool highlighted, QRgb color) const
+{
+    painter->setPen(QPen(Qt::black, 1));
+    painter->setBrush(highlighted ? QColor::fromRgba(color) : QColor(255,255,255,150));
+    painter->drawRect(rect);
+    painter->setFont(label_font);
+    painter->drawText(rect.adjusted(VisLabel::margin, VisLabel::margin, -VisLabel::margin, -VisLabel::margin),
+                      Qt::AlignLeft | Qt::AlignTop, text);
+}
+
+void VisImageExporter::paintItems(QPainter* painter, const Tile& items) const
+{
+    bool directed = document->directed();
+    bool shapes   = VisNode::w*settings.scale >= min_shape_pixels;
+    bool ids      = settings.detail != VisImageSettings::SHAPES and
+                    QFontMetricsF(id_font).height()*settings.scale >= min_text_pixels;
+    QPen pen(Qt::black, 1);
+
+    // En el orden de la escena: curvas, vertices y etiquetas
+    foreach(quint32 e, items.edges){
+        QPainterPath path = curveOf(e);
+        if(document->edge_flags[e] & VisDocument::HIGHLIGHTED){
+            bool straight = document->edge_flags[e] & VisDocument::STRAIGHT;
+            painter->strokePath(path, QPen(QColor::fromRgba(document->edge_colors[e]), 10, Qt::SolidLine,
+                                           Qt::FlatCap, straight ? Qt::BevelJoin : Qt::MiterJoin));
+        }
+        painter->setPen(pen);
+        painter->setBrush(Qt::NoBrush);
+        painter->drawPath(path);
+        if(directed and shapes){
+            QPointF end = path.pointAtPercent(path.percentAtLength(path.length()-VisNode::w/2.0));
+            painter->setBrush(Qt::black);
+            painter->drawEllipse(end, 5, 5);
+        }
+    }
+
+    painter->setFont(id_font);
+    foreach(quint32 i, items.nodes){
+        QRectF rect(document->positions[2*i], document->positions[2*i+1], VisNode::w, VisNode::h);
+        bool highlighted = document->node_flags[i] & VisDocument::HIGHLIGHTED;
+        if(not shapes){
+            painter->fillRect(rect, highlighted ? QColor::fromRgba(document->node_colors[i]) : QColor(Qt::black));
+            continue;
+        }
+        if(highlighted){
+            QPainterPath path;
+            path.addEllipse(rect.center(), 2*VisNode::w/3, 2*VisNode::h/3);
+            painter->fillPath(path, QColor::fromRgba(document->node_colors[i]));
+        }
+        painter->setPen(pen);
+        painter->setBrush(Qt::white);
+        painter->drawEllipse(rect);
+        if(ids)
+            painter->drawText(rect, Qt::AlignCenter, QString::number(document->ids[i]));
+    }
+
+    foreach(quint32 i, items.node_labels){
+        paintLabel(painter, node_label_rects[i], document->nodeLabel(i),
+                   document->node_flags[i] & VisDocument::LABEL_HIGHLIGHTED, document->node_label_colors[i]);
+    }
+    foreach(quint32 e, items.edge_labels){
+        paintLabel(painter, edge_label_rects[e], document->edgeLabel(e),
+                   document->edge_flags[e] & VisDocument::LABEL_HIGHLIGHTED, document->edge_label_colors[e]);
+    }
+}
+
+void VisImageExporter::renderTile(uchar* data, int stride, int x, int y, int width, int height)
+{
+    if(wasCancelled())
+        return;
+
+    // La baldosa escribe sobre su columna de la franja, sin copiarla
+    QImage tile(data+4*x, width, height, stride, QImage::Format_ARGB32_Premultiplied);
+    tile.fill(settings.background);
+
+    QPainter painter(&tile);
+    painter.setRenderHint(QPainter::Antialiasing);
+    painter.setRenderHint(QPainter::TextAntialiasing);
+    painter.translate(-x, -y);
+    painter.scale(settings.scale, settings.scale);
+    painter.translate(-bounds.topLeft());
+
+    paintItems(&painter, tiles[(y/tile_height)*tile_columns + x/tile_size]);
+}
+
+bool VisImageExporter::writePng(const QString& path)
+{
+    QSize size = imageSize();
+    int width  = size.width();
+    int height = size.height();
+    int strip_height = qBound(qint64(1), max_strip_bytes/(4*qint64(width)), qint64(tile_size));
+    int strip_count  = (height+strip_height-1)/strip_height;
+    sortIntoTiles(strip_height);
+
+    // Mientras se comprime una franja se dibuja la otra
+    QImage strips[2];
+    for(int k = 0; k < 2; k++){
+        strips[k] = QImage(width, qMin(strip_height, height), QImage::Format_ARGB32_Premultiplied);
+        if(strips[k].isNull()){
+            error = "Not enough memory for an image strip";
+            return false;
+        }
+    }
+
+    QSaveFile file(path);
+    if(not file.open(QIODevice::WriteOnly)){
+        error = file.errorString();
+        return false;
+    }
+    VisPngWriter png(&file, width, height, settings.background.alpha() < 255);
+
+    QThreadPool pool;
+    bool ok = true;
+    for(int k = 0; k <= strip_count and ok; k++){
+        if(k > 0){
+            while(not pool.waitForDone(100))
+                emit visProgress(qint64(k-1)*strip_height*1000/height);
+        }
+        if(wasCancelled())
+            break;
+
+        // La franja k empieza a dibujarse antes de comprimir la anterior
+        if(k < strip_count){
+            QImage& strip = strips[k%2];
+            uchar* data = strip.bits();
+            int top  = k*strip_height;
+            int rows = qMin(strip_height, height-top);
+            for(int x = 0; x < width; x += tile_size)
+                pool.start(new VisTileTask(this, data, strip.bytesPerLine(), x, top,
+                                           qMin(int(tile_size), width-x), rows));
+        }
+        if(k > 0){
+            int rows = qMin(strip_height, height-(k-1)*strip_height);
+            ok = png.writeRows(strips[(k-1)%2], rows);
+        }
+    }
+    pool.waitForDone();
+
+    if(not ok or wasCancelled()){
+        file.cancelWriting();
+        if(not ok)
+            error = file.errorString().isEmpty() ? "Can not compress the image" : file.errorString();
+        return false;
+    }
+    if(not png.finish() or not file.commit()){
+        error = file.errorString();
+        return false;
+    }
+    emit visProgress(1000);
+    return true;
+}
+
+bool VisImageExporter::writeSvg(const QString& path)
+{
+    QSize size = imageSize();
+    QSvgGenerator generator;
+    generator.setFileName(path);
+    generator.setSize(size);
+    generator.setViewBox(QRect(QPoint(0, 0), size));
+    generator.setTitle(QFileInfo(path).completeBaseName());
+
+    QPainter painter;
+    if(not painter.begin(&generator)){
+        error = "Can not write " + path;
+        return false;
+    }
+    painter.fillRect(QRect(QPoint(0, 0), size), settings.background);
+    painter.scale(settings.scale, settings.scale);
+    painter.translate(-bounds.topLeft());
+
+    // Todo el dibujo es una sola baldosa
+    Tile items;
+    quint32 n = document->nodeCount();
+    quint32 m = document->edgeCount();
+    for(quint32 e = 0; e < m; e++){
+        if(not edge_rects[e].isNull())
+            items.edges.append(e);
+        if(not edge_label_rects[e].isNull())
+            items.edge_labels.append(e);
+    }
+    for(quint32 i = 0; i < n; i++){
+        items.nodes.append(i);
+        if(not node_label_rects[i].isNull())
+            items.node_labels.append(i);
+    }
+    paintItems(&painter, items);
+    if(not painter.end()){
+        error = "Can not write " + path;
+        return false;
+    }
+    emit visProgress(1000);
+    return true;
+}
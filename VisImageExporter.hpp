@@ -0,0 +1,124 @@
+#ifndef VISIMAGEEXPORTER_HPP
+#define VISIMAGEEXPORTER_HPP
+
+// Parent class
+#include <QObject>
+
+// Member classes
+#include <QFont>
+#include <QColor>
+#include <QRect>
+#include <QRectF>
+#include <QSize>
+#include <QPainterPath>
+#include <QString>
+#include <QVector>
+#include <QAtomicInt>
+
+class QPainter;
+class VisDocument;
+class VisGraphicsScene;
+
+// How an image is drawn. scale is the size in pixels of a scene unit, the
+// view at 100% is 1. Below FULL the labels, and then the vertex ids, are
+// left out; whatever the detail, text smaller than min_text_pixels is not
+// drawn and vertices smaller than min_shape_pixels become squares.
+struct VisImageSettings
+{
+    enum DETAIL {FULL, NO_LABELS, SHAPES};
+
+    double  scale;
+    QColor  background;
+    DETAIL  detail;
+
+    VisImageSettings() : scale(1), background(Qt::white), detail(FULL) {}
+};
+
+// Draws a graph document as PNG or SVG without building a scene; items
+// are drawn as the scene draws them, without selection.
+//
+// A PNG is rendered in strips of at most max_strip_bytes, each split in
+// tiles of tile_size pixels that pool threads draw at once into the strip.
+// The items are sorted into the tiles they cover once, before drawing, so
+// a tile only visits its own.
+// While the next strip is drawn the calling thread compresses the current
+// one into the file, so memory stays at two strips whatever the size. An
+// SVG is written item by item by QSvgGenerator.
+class VisImageExporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum FORMAT {PNG, SVG};
+
+    const static int    tile_size        = 1024;
+    const static qint64 max_strip_bytes  = 64 << 20;
+    const static int    margin           = 20;
+    const static int    min_text_pixels  = 6;
+    const static int    min_shape_pixels = 3;
+
+    VisImageExporter(QObject* parent = 0);
+
+    // SVG when the suffix is .svg, PNG otherwise
+    static FORMAT formatOf(const QString& path);
+
+    // The scene is copied into a document first
+    bool write(const QString& path, VisGraphicsScene* scene, const VisImageSettings& settings);
+    bool write(const QString& path, const VisDocument& document, const VisImageSettings& settings);
+    QString errorString() const { return error; }
+    bool wasCancelled() const { return cancelled.load() != 0; }
+
+    // Size of the image the settings give, once write() measured the graph
+    QSize imageSize() const;
+
+    // Called by the pool threads, data is the first row of the strip
+    void renderTile(uchar* data, int stride, int x, int y, int width, int height);
+
+signals:
+    void visProgress(int permille);
+
+public slots:
+    void visCancel();
+
+private:
+    const VisDocument* document;
+    VisImageSettings   settings;
+    QAtomicInt         cancelled;
+    QString            error;
+
+    QFont   id_font;
+    QFont   label_font;
+    QRectF  bounds;
+
+    // Source vertex of each edge, and the scene rectangle each item and
+    // label covers; labels that are not drawn have an empty rectangle
+    QVector<quint32> sources;
+    QVector<QRectF>  node_rects;
+    QVector<QRectF>  edge_rects;
+    QVector<QRectF>  node_label_rects;
+    QVector<QRectF>  edge_label_rects;
+
+    // Items drawn by a tile, each list in item order
+    struct Tile
+    {
+        QVector<quint32> edges;
+        QVector<quint32> nodes;
+        QVector<quint32> node_labels;
+        QVector<quint32> edge_labels;
+    };
+    QVector<Tile> tiles;
+    int           tile_columns;
+    int           tile_height;
+
+    void measure();
+    void sortIntoTiles(int height);
+    QRect tilesOf(const QRectF& rect) const;
+    bool writePng(const QString& path);
+    bool writeSvg(const QString& path);
+    void paintItems(QPainter* painter, const Tile& items) const;
+    void paintLabel(QPainter* painter, const QRectF& rect, const QString& text,
+                    bool highlighted, QRgb color) const;
+    QPainterPath curveOf(quint32 e) const;
+};
+
+#endif // VISIMAGEEXPORTER_HPP
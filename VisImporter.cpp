@@ -0,0 +1,823 @@
+#include "VisImporter.hpp"
+
+#include <QFile>
+#include <QFileInfo>
+#include <QThreadPool>
+#include <QRunnable>
+#include <QXmlStreamReader>
+#include <QHash>
+#include <QSet>
+#include <QtNumeric>
+#include <QtAlgorithms>
+
+#include <cstring>
+#include <cstdlib>
+#include <cmath>
+
+static bool isSeparator(char c)
+{
+    return c == ' ' or c == '\t' or c == '\r' or c == ',';
+}
+
+bool VisToken::is(const char* word) const
+{
+    int length = strlen(word);
+    return size() == length and qstrnicmp(begin, word, length) == 0;
+}
+
+bool VisToken::toInt(qint32* value) const
+{
+    const char* c = begin;
+    bool negative = c < end and *c == '-';
+    if(c < end and (*c == '-' or *c == '+'))
+        c++;
+    if(c == end)
+        return false;
+
+    qint64 n = 0;
+    for(; c < end; c++){
+        if(*c < '0' or *c > '9')
+            return false;
+        n = 10*n + (*c-'0');
+        if(n > 2147483647)
+            return false;
+    }
+    *value = negative ? -n : n;
+    return true;
+}
+
+bool VisToken::toDouble(double* value) const
+{
+    // strtod necesita el final de la cadena
+    char number[64];
+    if(size() == 0 or size() >= (int) sizeof(number))
+        return false;
+    memcpy(number, begin, size());
+    number[size()] = '\0';
+
+    char* number_end;
+    *value = strtod(number, &number_end);
+    return number_end == number+size();
+}
+
+// GraphML key or GEXF attribute declaration
+struct VisXmlKey
+{
+    QString name;
+    QString type;
+};
+
+// Vertices of an XML file while it is read. Ids that are numbers, alone or
+// after an "n", keep their value; the rest get ids after the largest one
+// once the whole file has been read.
+class VisXmlNodes
+{
+public:
+    VisXmlNodes() : max_id(-1) {}
+
+    int index(const QString& id)
+    {
+        QHash<QString, int>::const_iterator it = indices.constFind(id);
+        if(it != indices.constEnd())
+            return it.value();
+
+        int i = numeric.size();
+        indices.insert(id, i);
+
+        bool ok;
+        qint32 value = (id.startsWith('n') ? id.mid(1) : id).toInt(&ok);
+        if(not ok or value < 0 or used.contains(value)){
+            value = -1;
+        }else{
+            used.insert(value);
+            max_id = qMax(max_id, value);
+        }
+        numeric.append(value);
+        positions.append(qQNaN());
+        positions.append(qQNaN());
+        labels.append(QByteArray());
+        return i;
+    }
+
+    QVector<qint32> finish()
+    {
+        QVector<qint32> ids = numeric;
+        for(int i = 0; i < ids.size(); i++){
+            if(ids[i] < 0)
+                ids[i] = ++max_id;
+        }
+        indices.clear();
+        used.clear();
+        return ids;
+    }
+
+    QVector<qint32>     numeric;
+    QVector<double>     positions;
+    QVector<QByteArray> labels;
+
+private:
+    QHash<QString, int> indices;
+    QSet<qint32>        used;
+    qint32              max_id;
+};
+
+static QVariant typedValue(const QString& text, const QString& type)
+{
+    bool ok;
+    if(type == "boolean")
+        return QVariant(text.trimmed() == "true" or text.trimmed() == "1");
+    if(type == "int" or type == "long" or type == "integer"){
+        qlonglong value = text.toLongLong(&ok);
+        if(ok)
+            return QVariant(value);
+    }
+    if(type == "float" or type == "double"){
+        double value = text.toDouble(&ok);
+        if(ok)
+            return QVariant(value);
+    }
+    return QVariant(text);
+}
+
+// Label of an XML edge from its data, in the formats the algorithms parse
+static QByteArray edgeLabel(const QHash<QString, QString>& values)
+{
+    if(values.contains("label"))
+        return values.value("label").toUtf8();
+
+    QString q = values.value("q-max", values.value("capacity"));
+    QString r = values.value("q-min", values.value("lower"));
+    QString c = values.value("cost");
+    if(not q.isEmpty()){
+        QString label = (r.isEmpty() or r == "0") ? q : r + "," + q;
+        if(not c.isEmpty())
+            label += ",$" + c;
+        return label.toUtf8();
+    }
+    if(values.contains("weight"))
+        return values.value("weight").toUtf8();
+    return values.value("distance").toUtf8();
+}
+
+// Parses one part of a mapped file in a pool thread
+class VisImportTask : public QRunnable
+{
+public:
+    VisImportTask(VisImporter* importer, VisImportChunk* chunk, const char* begin, const char* end)
+        : importer(importer), chunk(chunk), begin(begin), end(end) {}
+
+    void run() { importer->parseRange(chunk, begin, end); }
+
+private:
+    VisImporter*    importer;
+    VisImportChunk* chunk;
+    const char*     begin;
+    const char*     end;
+};
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Class procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+VisImporter::VisImporter(QObject* parent)
+    : QObject(parent)
+{
+    flow = 0;
+    cancelled.store(0);
+    kbytes_done.store(0);
+}
+
+VisImporter::FORMAT VisImporter::formatOf(const QString& path)
+{
+    QString suffix = QFileInfo(path).suffix().toLower();
+    if(suffix == "max" or suffix == "min" or suffix == "dimacs" or suffix == "inp")
+        return DIMACS;
+    if(suffix == "mtx")
+        return MATRIX_MARKET;
+    if(suffix == "graphml")
+        return GRAPHML;
+    if(suffix == "gexf")
+        return GEXF;
+    return EDGE_LIST;
+}
+
+bool VisImporter::import(const QString& path, FORMAT format, bool directed, VisDocumentContent* content)
+{
+    this->format   = format;
+    this->directed = format == DIMACS ? true : directed;
+    error          = "";
+    declared_nodes = -1;
+    header_read    = false;
+    min_cost       = false;
+    flow           = 0;
+    sources.clear();
+    sinks.clear();
+    attributes.clear();
+    node_ids.clear();
+    cancelled.store(0);
+    kbytes_done.store(0);
+
+    QFile file(path);
+    if(not file.open(QIODevice::ReadOnly)){
+        error = file.errorString();
+        return false;
+    }
+
+    QList<VisImportChunk*> chunks;
+    uchar* data = NULL;
+    if(format == GRAPHML or format == GEXF){
+        chunks.append(new VisImportChunk);
+        importXml(file, chunks.first());
+    }else if(file.size() > 0 and (data = file.map(0, file.size())) != NULL){
+        importMapped(data, file.size(), chunks);
+        file.unmap(data);
+    }else{
+        chunks.append(new VisImportChunk);
+        importStreamed(file, chunks.first());
+    }
+
+    // El primer error en el orden del archivo, las partes anteriores se
+    // leyeron completas
+    qint64 line = 0;
+    foreach(VisImportChunk* chunk, chunks){
+        if(not chunk->error.isEmpty()){
+            error = QString("Line %1: %2").arg(line+chunk->lines).arg(chunk->error);
+            break;
+        }
+        line += chunk->lines;
+    }
+    if(cancelled.load())
+        error = "Import cancelled";
+    else if(error.isEmpty() and format == DIMACS and not header_read)
+        error = "Missing problem line";
+    else if(error.isEmpty() and format == MATRIX_MARKET and declared_nodes < 0)
+        error = "Missing matrix size";
+
+    if(error.isEmpty()){
+        build(chunks, content);
+        emit visProgress(1000);
+    }
+    qDeleteAll(chunks);
+    return error.isEmpty();
+}
+
+void VisImporter::visCancel()
+{
+    cancelled.store(1);
+}
+
+bool VisImporter::headerComplete() const
+{
+    switch(format){
+    case EDGE_LIST:
+        return true;
+    case DIMACS:
+        return header_read;
+    case MATRIX_MARKET:
+        return declared_nodes >= 0;
+    default:
+        return true;
+    }
+}
+
+void VisImporter::importMapped(const uchar* data, qint64 size, QList<VisImportChunk*>& chunks)
+{
+    const char* begin = (const char*) data;
+    const char* end   = begin+size;
+
+    // La cabecera se lee en este hilo; las partes solo consultan su estado
+    VisImportChunk* header = new VisImportChunk;
+    chunks.append(header);
+    const char* line = begin;
+    while(line < end and not headerComplete()){
+        const char* newline  = (const char*) memchr(line, '\n', end-line);
+        const char* line_end = newline != NULL ? newline : end;
+        header->lines++;
+        if(not parseLine(header, line, line_end))
+            return;
+        line = newline != NULL ? newline+1 : end;
+    }
+    if(line == end)
+        return;
+
+    // Las partes empiezan despues de un salto de linea, cada una se lee en
+    // su propio bloque y se unen en el orden del archivo
+    QThreadPool pool;
+    qint64 rest  = end-line;
+    qint64 parts = qBound(qint64(1), rest/min_part_size,
+                          qint64(pool.maxThreadCount())*parts_per_thread);
+    const char* part_begin = line;
+    for(qint64 i = 1; i <= parts and part_begin < end; i++){
+        const char* part_end = end;
+        if(i < parts){
+            part_end = qMax(part_begin, line+rest*i/parts);
+            const char* newline = (const char*) memchr(part_end, '\n', end-part_end);
+            part_end = newline != NULL ? newline+1 : end;
+        }
+        VisImportChunk* chunk = new VisImportChunk;
+        chunks.append(chunk);
+        pool.start(new VisImportTask(this, chunk, part_begin, part_end));
+        part_begin = part_end;
+    }
+
+    while(not pool.waitForDone(100))
+        emit visProgress(qMin(qint64(1000), 1024*qint64(kbytes_done.load())*1000/size));
+}
+
+void VisImporter::importStreamed(QFile& file, VisImportChunk* chunk)
+{
+    // Las lineas se leen dentro del bloque; la ultima, si esta incompleta,
+    // pasa al principio del siguiente
+    qint64 total = qMax(file.size(), qint64(1));
+    qint64 done  = 0;
+    int    carry = 0;
+    QByteArray buffer;
+    for(;;){
+        buffer.resize(carry+chunk_size);
+        qint64 read = file.read(buffer.data()+carry, chunk_size);
+        if(read < 0){
+            fail(chunk, file.errorString());
+            return;
+        }
+        done += read;
+
+        const char* line = buffer.constData();
+        const char* end  = line+carry+read;
+        const char* newline;
+        while((newline = (const char*) memchr(line, '\n', end-line)) != NULL){
+            chunk->lines++;
+            if(not parseLine(chunk, line, newline))
+                return;
+            line = newline+1;
+        }
+
+        if(read == 0 or file.atEnd()){
+            if(line < end){
+                chunk->lines++;
+                parseLine(chunk, line, end);
+            }
+            return;
+        }
+
+        carry = end-line;
+        memmove(buffer.data(), line, carry);
+
+        emit visProgress(1000*done/total);
+        if(cancelled.load())
+            return;
+    }
+}
+
+void VisImporter::importXml(QFile& file, VisImportChunk* chunk)
+{
+    // GraphML y GEXF no comparten nombres de elementos, un solo recorrido
+    // sirve para los dos
+    QXmlStreamReader xml(&file);
+    VisXmlNodes nodes;
+    QHash<QString, VisXmlKey> node_keys;
+    QHash<QString, VisXmlKey> edge_keys;
+    QHash<QString, QString>   edge_values;
+    bool edge_class = false;
+    bool in_edge    = false;
+    int  node       = -1;
+    int  source     = -1;
+    int  target     = -1;
+    qint64 total    = qMax(file.size(), qint64(1));
+    qint64 elements = 0;
+
+    while(not xml.atEnd()){
+        xml.readNext();
+        if(xml.isStartElement()){
+            QString name = xml.name().toString();
+            QXmlStreamAttributes attrs = xml.attributes();
+
+            if(name == "graph"){
+                directed = attrs.value("edgedefault") == "directed" or
+                           attrs.value("defaultedgetype") == "directed";
+            }else if(name == "key"){
+                VisXmlKey key;
+                key.name = attrs.value("attr.name").toString();
+                key.type = attrs.value("attr.type").toString();
+                if(key.name.isEmpty())
+                    key.name = attrs.value("id").toString();
+                QStringRef domain = attrs.value("for");
+                if(domain == "node" or domain == "all")
+                    node_keys.insert(attrs.value("id").toString(), key);
+                if(domain == "edge" or domain == "all")
+                    edge_keys.insert(attrs.value("id").toString(), key);
+            }else if(name == "attributes"){
+                edge_class = attrs.value("class") == "edge";
+            }else if(name == "attribute"){
+                VisXmlKey key;
+                key.name = attrs.value("title").toString();
+                key.type = attrs.value("type").toString();
+                if(key.name.isEmpty())
+                    key.name = attrs.value("id").toString();
+                (edge_class ? edge_keys : node_keys).insert(attrs.value("id").toString(), key);
+            }else if(name == "node"){
+                node = nodes.index(attrs.value("id").toString());
+                if(attrs.hasAttribute("label"))
+                    nodes.labels[node] = attrs.value("label").toString().toUtf8();
+            }else if(name == "edge"){
+                in_edge = true;
+                source  = nodes.index(attrs.value("source").toString());
+                target  = nodes.index(attrs.value("target").toString());
+                edge_values.clear();
+                if(attrs.hasAttribute("label"))
+                    edge_values.insert("label", attrs.value("label").toString());
+                if(attrs.hasAttribute("weight")){
+                    edge_values.insert("weight", attrs.value("weight").toString());
+                    attributes.append(VisAttribute(source, target, "weight",
+                                                   typedValue(attrs.value("weight").toString(), "double")));
+                }
+            }else if(name == "position" and node >= 0){
+                nodes.positions[2*node]   = attrs.value("x").toString().toDouble();
+                nodes.positions[2*node+1] = attrs.value("y").toString().toDouble();
+            }else if(name == "data" or name == "attvalue"){
+                QString id = attrs.value(name == "data" ? "key" : "for").toString();
+                VisXmlKey key = (in_edge ? edge_keys : node_keys).value(id);
+                if(key.name.isEmpty())
+                    key.name = id;
+                QString text = name == "data" ? xml.readElementText() : attrs.value("value").toString();
+                QString lower = key.name.toLower();
+
+                if(in_edge){
+                    edge_values.insert(lower, text);
+                    if(lower != "label")
+                        attributes.append(VisAttribute(source, target, key.name.toUtf8(),
+                                                       typedValue(text, key.type)));
+                }else if(node >= 0){
+                    if(lower == "x")
+                        nodes.positions[2*node] = text.toDouble();
+                    else if(lower == "y")
+                        nodes.positions[2*node+1] = text.toDouble();
+                    else if(lower == "label")
+                        nodes.labels[node] = text.toUtf8();
+                    else
+                        attributes.append(VisAttribute(node, -1, key.name.toUtf8(),
+                                                       typedValue(text, key.type)));
+                }
+            }
+        }else if(xml.isEndElement()){
+            if(xml.name() == "node"){
+                node = -1;
+            }else if(xml.name() == "edge"){
+                in_edge = false;
+                chunk->edge_sources.append(source);
+                chunk->edge_targets.append(target);
+                chunk->labels.append(edgeLabel(edge_values));
+                chunk->label_ends.append(chunk->labels.size());
+            }
+        }
+
+        if(++elements % xml_report_step == 0){
+            emit visProgress(1000*file.pos()/total);
+            if(cancelled.load())
+                return;
+        }
+    }
+    if(xml.hasError()){
+        chunk->lines = xml.lineNumber();
+        fail(chunk, xml.errorString());
+        return;
+    }
+
+    // Los extremos y los atributos usaban la posicion de cada vertice en
+    // el archivo, ahora tienen su id
+    QVector<qint32> ids = nodes.finish();
+    for(int e = 0; e < chunk->edge_sources.size(); e++){
+        chunk->edge_sources[e] = ids[chunk->edge_sources[e]];
+        chunk->edge_targets[e] = ids[chunk->edge_targets[e]];
+    }
+    for(int k = 0; k < attributes.size(); k++){
+        VisAttribute& attribute = attributes[k];
+        attribute.aid = ids[attribute.aid];
+        if(attribute.bid >= 0)
+            attribute.bid = ids[attribute.bid];
+    }
+
+    chunk->node_ids       = ids;
+    chunk->node_positions = nodes.positions;
+    chunk->node_label_ends.reserve(ids.size());
+    for(int k = 0; k < ids.size(); k++){
+        chunk->node_labels.append(nodes.labels[k]);
+        chunk->node_label_ends.append(chunk->node_labels.size());
+    }
+}
+
+void VisImporter::parseRange(VisImportChunk* chunk, const char* begin, const char* end)
+{
+    const char* line     = begin;
+    const char* reported = begin;
+    while(line < end){
+        const char* newline  = (const char*) memchr(line, '\n', end-line);
+        const char* line_end = newline != NULL ? newline : end;
+        chunk->lines++;
+        if(not parseLine(chunk, line, line_end))
+            return;
+        line = newline != NULL ? newline+1 : end;
+
+        if(line-reported >= min_part_size){
+            kbytes_done.fetchAndAddRelaxed((line-reported) >> 10);
+            reported = line;
+            if(cancelled.load())
+                return;
+        }
+    }
+}
+
+bool VisImporter::parseLine(VisImportChunk* chunk, const char* begin, const char* end)
+{
+    VisToken tokens[max_tokens];
+    int count = 0;
+    const char* c = begin;
+    while(count < max_tokens){
+        while(c < end and isSeparator(*c))
+            c++;
+        if(c == end)
+            break;
+        tokens[count].begin = c;
+        while(c < end and not isSeparator(*c))
+            c++;
+        tokens[count].end = c;
+        count++;
+    }
+
+    switch(format){
+    case EDGE_LIST:
+        return edgeListLine(chunk, tokens, count);
+    case DIMACS:
+        return dimacsLine(chunk, tokens, count);
+    case MATRIX_MARKET:
+        return matrixMarketLine(chunk, tokens, count);
+    default:
+        return false;
+    }
+}
+
+bool VisImporter::edgeListLine(VisImportChunk* chunk, const VisToken* tokens, int count)
+{
+    if(count == 0 or *tokens[0].begin == '#' or *tokens[0].begin == '%')
+        return true;
+    if(count < 2)
+        return fail(chunk, "Expected two vertices");
+
+    if(not addEdge(chunk, tokens[0], tokens[1]))
+        return false;
+    if(count > 2)
+        chunk->labels.append(tokens[2].begin, tokens[2].size());
+    chunk->label_ends.append(chunk->labels.size());
+    return true;
+}
+
+bool VisImporter::dimacsLine(VisImportChunk* chunk, const VisToken* tokens, int count)
+{
+    if(count == 0 or tokens[0].is("c"))
+        return true;
+
+    if(tokens[0].is("p")){
+        qint32 arcs;
+        if(header_read)
+            return fail(chunk, "Repeated problem line");
+        if(count < 4)
+            return fail(chunk, "Incomplete problem line");
+        min_cost = tokens[1].is("min");
+        if(not min_cost and not tokens[1].is("max"))
+            return fail(chunk, "Only max and min problems can be imported");
+        if(not tokens[2].toInt(&declared_nodes) or declared_nodes < 0 or
+           not tokens[3].toInt(&arcs) or arcs < 0){
+            declared_nodes = -1;
+            return fail(chunk, "Invalid problem size");
+        }
+        header_read = true;
+        return true;
+    }
+
+    if(not header_read)
+        return fail(chunk, "Missing problem line");
+
+    if(tokens[0].is("n")){
+        qint32 id;
+        if(count < 3)
+            return fail(chunk, "Incomplete node line");
+        if(not tokens[1].toInt(&id) or id < 1 or id > declared_nodes)
+            return fail(chunk, "Vertex out of range");
+        if(min_cost){
+            double supply;
+            if(not tokens[2].toDouble(&supply))
+                return fail(chunk, "Invalid supply");
+            if(supply > 0){
+                chunk->sources.append(id);
+                chunk->flow += supply;
+            }else if(supply < 0){
+                chunk->sinks.append(id);
+            }
+        }else if(tokens[2].is("s")){
+            chunk->sources.append(id);
+        }else if(tokens[2].is("t")){
+            chunk->sinks.append(id);
+        }else{
+            return fail(chunk, "Node must be s or t");
+        }
+        return true;
+    }
+
+    if(tokens[0].is("a")){
+        if(count < (min_cost ? 6 : 4))
+            return fail(chunk, "Incomplete arc line");
+        if(not addEdge(chunk, tokens[1], tokens[2]))
+            return false;
+        if(min_cost){
+            // "r,q,$c", la cota inferior se omite cuando es cero
+            if(not tokens[3].is("0")){
+                chunk->labels.append(tokens[3].begin, tokens[3].size());
+                chunk->labels.append(',');
+            }
+            chunk->labels.append(tokens[4].begin, tokens[4].size());
+            chunk->labels.append(",$");
+            chunk->labels.append(tokens[5].begin, tokens[5].size());
+        }else{
+            chunk->labels.append(tokens[3].begin, tokens[3].size());
+        }
+        chunk->label_ends.append(chunk->labels.size());
+        return true;
+    }
+
+    return fail(chunk, "Unknown line");
+}
+
+bool VisImporter::matrixMarketLine(VisImportChunk* chunk, const VisToken* tokens, int count)
+{
+    if(not header_read){
+        if(count < 5 or not tokens[0].is("%%MatrixMarket") or not tokens[1].is("matrix"))
+            return fail(chunk, "Missing %%MatrixMarket banner");
+        if(not tokens[2].is("coordinate"))
+            return fail(chunk, "Only coordinate matrices can be imported");
+        if(tokens[3].is("complex"))
+            return fail(chunk, "Complex matrices can not be imported");
+        directed    = tokens[4].is("general");
+        header_read = true;
+        return true;
+    }
+
+    if(count == 0 or *tokens[0].begin == '%')
+        return true;
+
+    if(declared_nodes < 0){
+        qint32 rows, columns, entries;
+        if(count < 3 or not tokens[0].toInt(&rows) or not tokens[1].toInt(&columns) or
+           not tokens[2].toInt(&entries) or rows < 0 or columns < 0 or entries < 0)
+            return fail(chunk, "Invalid matrix size");
+        declared_nodes = qMax(rows, columns);
+        return true;
+    }
+
+    if(count < 2)
+        return fail(chunk, "Expected a row and a column");
+    if(not addEdge(chunk, tokens[0], tokens[1]))
+        return false;
+    if(count > 2)
+        chunk->labels.append(tokens[2].begin, tokens[2].size());
+    chunk->label_ends.append(chunk->labels.size());
+    return true;
+}
+
+bool VisImporter::addEdge(VisImportChunk* chunk, const VisToken& u, const VisToken& v)
+{
+    qint32 uid, vid;
+    if(not u.toInt(&uid) or not v.toInt(&vid) or uid < 0 or vid < 0)
+        return fail(chunk, "Invalid vertex");
+    if(declared_nodes >= 0 and (uid < 1 or uid > declared_nodes or vid < 1 or vid > declared_nodes))
+        return fail(chunk, "Vertex out of range");
+    chunk->edge_sources.append(uid);
+    chunk->edge_targets.append(vid);
+    return true;
+}
+
+bool VisImporter::fail(VisImportChunk* chunk, const QString& message)
+{
+    chunk->error = message;
+    return false;
+}
+
+quint32 VisImporter::indexOf(qint32 id) const
+{
+    if(declared_nodes >= 0)
+        return id-1;
+    return qLowerBound(node_ids.constBegin(), node_ids.constEnd(), id)-node_ids.constBegin();
+}
+
+void VisImporter::build(const QList<VisImportChunk*>& chunks, VisDocumentContent* content)
+{
+    quint32 m = 0;
+    foreach(VisImportChunk* chunk, chunks){
+        m += chunk->edge_sources.size();
+        sources.append(chunk->sources);
+        sinks.append(chunk->sinks);
+        flow += chunk->flow;
+    }
+
+    // Sin declaracion los vertices son los extremos y los que el archivo
+    // nombra, ordenados y sin repetir
+    if(declared_nodes >= 0){
+        node_ids.resize(declared_nodes);
+        for(int i = 0; i < declared_nodes; i++)
+            node_ids[i] = i+1;
+    }else{
+        node_ids.reserve(2*m);
+        foreach(VisImportChunk* chunk, chunks){
+            node_ids += chunk->node_ids;
+            node_ids += chunk->edge_sources;
+            node_ids += chunk->edge_targets;
+        }
+        qSort(node_ids);
+        int unique = 0;
+        for(int i = 0; i < node_ids.size(); i++){
+            if(unique == 0 or node_ids[i] != node_ids[unique-1])
+                node_ids[unique++] = node_ids[i];
+        }
+        node_ids.resize(unique);
+    }
+    quint32 n = node_ids.size();
+
+    content->directed = directed;
+    content->next_id  = n > 0 ? node_ids.last()+1 : 0;
+    content->resize(n, m);
+    memcpy(content->ids.data(), node_ids.constData(), n*sizeof(qint32));
+
+    int columns = qMax(1, (int) ceil(sqrt((double) n)));
+    for(quint32 i = 0; i < n; i++){
+        content->positions[2*i]   = (i % columns)*grid_spacing;
+        content->positions[2*i+1] = (i / columns)*grid_spacing;
+    }
+
+    // Las etiquetas de los vertices van primero y las de las aristas
+    // despues; aqui se guarda el largo de cada una
+    QVector<quint32>& label_offsets = content->label_offsets;
+    label_offsets.fill(0, n+m+1);
+    foreach(VisImportChunk* chunk, chunks){
+        for(int k = 0; k < chunk->node_ids.size(); k++){
+            quint32 i     = indexOf(chunk->node_ids[k]);
+            quint32 begin = k > 0 ? chunk->node_label_ends[k-1] : 0;
+            if(not qIsNaN(chunk->node_positions[2*k])){
+                content->positions[2*i]   = chunk->node_positions[2*k];
+                content->positions[2*i+1] = chunk->node_positions[2*k+1];
+            }
+            label_offsets[i+1] = chunk->node_label_ends[k]-begin;
+        }
+    }
+
+    foreach(VisImportChunk* chunk, chunks){
+        for(int e = 0; e < chunk->edge_sources.size(); e++)
+            content->rows[indexOf(chunk->edge_sources[e])+1]++;
+    }
+    for(quint32 i = 0; i < n; i++)
+        content->rows[i+1] += content->rows[i];
+
+    // Las partes se recorren en el orden del archivo, asi cada arista ocupa
+    // el mismo lugar que en una lectura secuencial
+    QVector<quint32> next = content->rows;
+    QVector<quint32> edge_slots(m);
+    quint32 g = 0;
+    foreach(VisImportChunk* chunk, chunks){
+        for(int e = 0; e < chunk->edge_sources.size(); e++, g++){
+            quint32 slot = next[indexOf(chunk->edge_sources[e])]++;
+            quint32 begin = e > 0 ? chunk->label_ends[e-1] : 0;
+            content->targets[slot]    = indexOf(chunk->edge_targets[e]);
+            content->edge_flags[slot] = VisDocument::STRAIGHT;
+            label_offsets[n+slot+1]   = chunk->label_ends[e]-begin;
+            edge_slots[g] = slot;
+        }
+        chunk->edge_sources.clear();
+        chunk->edge_targets.clear();
+    }
+    for(quint32 i = 0; i < n+m; i++)
+        label_offsets[i+1] += label_offsets[i];
+
+    content->label_data.resize(label_offsets[n+m]);
+    foreach(VisImportChunk* chunk, chunks){
+        for(int k = 0; k < chunk->node_ids.size(); k++){
+            quint32 begin = k > 0 ? chunk->node_label_ends[k-1] : 0;
+            memcpy(content->label_data.data()+label_offsets[indexOf(chunk->node_ids[k])],
+                   chunk->node_labels.constData()+begin, chunk->node_label_ends[k]-begin);
+        }
+        chunk->node_ids.clear();
+        chunk->node_positions.clear();
+        chunk->node_label_ends.clear();
+        chunk->node_labels.clear();
+    }
+    g = 0;
+    foreach(VisImportChunk* chunk, chunks){
+        for(int e = 0; e < chunk->label_ends.size(); e++, g++){
+            quint32 begin = e > 0 ? chunk->label_ends[e-1] : 0;
+            memcpy(content->label_data.data()+label_offsets[n+edge_slots[g]],
+                   chunk->labels.constData()+begin, chunk->label_ends[e]-begin);
+        }
+        chunk->label_ends.clear();
+        chunk->labels.clear();
+    }
+    node_ids.clear();
+}
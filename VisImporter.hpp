@@ -0,0 +1,154 @@
+#ifndef VISIMPORTER_HPP
+#define VISIMPORTER_HPP
+
+// Parent class
+#include <QObject>
+
+// Member classes
+#include <QList>
+#include <QVector>
+#include <QByteArray>
+#include <QAtomicInt>
+#include <QVariant>
+#include <VisDocument.hpp>
+
+class QFile;
+
+// Token of a line, points into the file or the chunk being read
+struct VisToken
+{
+    const char* begin;
+    const char* end;
+
+    int  size() const { return end-begin; }
+    bool is(const char* word) const;
+    bool toInt(qint32* value) const;
+    bool toDouble(double* value) const;
+};
+
+// Edges and flow designations read from one part of a file, each part is
+// read by a single thread and the parts are merged in file order
+struct VisImportChunk
+{
+    QVector<qint32>  edge_sources;
+    QVector<qint32>  edge_targets;
+    QVector<quint32> label_ends;
+    QByteArray       labels;
+
+    QList<int> sources;
+    QList<int> sinks;
+    double     flow;
+
+    // Vertices the file declares, with their position (NaN when it has
+    // none) and label; only the XML formats fill these
+    QVector<qint32>  node_ids;
+    QVector<double>  node_positions;
+    QVector<quint32> node_label_ends;
+    QByteArray       node_labels;
+
+    // Lines read, up to the failing one when error is set
+    qint64  lines;
+    QString error;
+
+    VisImportChunk() : flow(0), lines(0) {}
+};
+
+// Typed value of a vertex (bid < 0) or an edge read from an XML file, set in
+// G with add-atribute! once the graph is loaded
+struct VisAttribute
+{
+    qint32     aid;
+    qint32     bid;
+    QByteArray name;
+    QVariant   value;
+
+    VisAttribute(qint32 aid_ = -1, qint32 bid_ = -1, const QByteArray& name_ = QByteArray(),
+                 const QVariant& value_ = QVariant())
+        : aid(aid_), bid(bid_), name(name_), value(value_) {}
+};
+
+// Reads edge lists, DIMACS flow problems, Matrix Market coordinate files,
+// GraphML and GEXF. Text files are mapped and, once their header has been
+// read, the rest is split at line boundaries and parsed by a thread pool;
+// XML files are read element by element with QXmlStreamReader. Capacities,
+// lower bounds and costs become labels in the formats the flow algorithms
+// parse ("q", "r,q,$c" or "q,$c"), numbers are copied as they are written.
+class VisImporter : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum FORMAT {EDGE_LIST, DIMACS, MATRIX_MARKET, GRAPHML, GEXF};
+
+    VisImporter(QObject* parent = 0);
+
+    // Guessed from the suffix, edge list when unknown
+    static FORMAT formatOf(const QString& path);
+
+    // directed only applies to edge lists, the other formats say it
+    bool import(const QString& path, FORMAT format, bool directed, VisDocumentContent* content);
+    QString errorString() const { return error; }
+    bool wasCancelled() const { return cancelled.load() != 0; }
+
+    // Flow problem of a DIMACS file: designated or supplying vertices and
+    // the total supply
+    QList<int> sources;
+    QList<int> sinks;
+    double     flow;
+
+    // Data keys of XML files other than positions and labels
+    QList<VisAttribute> attributes;
+
+    // Files that can not be mapped are read sequentially in chunks
+    const static qint64 chunk_size       = 4 << 20;
+    // Smallest part given to a thread, and parts per thread for balance
+    const static qint64 min_part_size    = 1 << 20;
+    const static int    parts_per_thread = 4;
+    const static int    max_tokens       = 8;
+    const static int    grid_spacing     = 60;
+    // XML elements read between progress reports
+    const static int    xml_report_step  = 4096;
+
+    // Called by the pool threads
+    void parseRange(VisImportChunk* chunk, const char* begin, const char* end);
+
+signals:
+    void visProgress(int permille);
+
+public slots:
+    void visCancel();
+
+private:
+    FORMAT     format;
+    bool       directed;
+    QAtomicInt cancelled;
+    QAtomicInt kbytes_done;
+    QString    error;
+
+    // Set while reading the header, only read once the parts are parsed in
+    // parallel. Vertices are 1..declared_nodes when the format declares
+    // them, otherwise those seen in the edges.
+    qint32  declared_nodes;
+    bool    header_read;
+    bool    min_cost;
+
+    QVector<qint32> node_ids;
+
+    bool headerComplete() const;
+    void importMapped(const uchar* data, qint64 size, QList<VisImportChunk*>& chunks);
+    void importStreamed(QFile& file, VisImportChunk* chunk);
+    void importXml(QFile& file, VisImportChunk* chunk);
+
+    bool parseLine(VisImportChunk* chunk, const char* begin, const char* end);
+    bool edgeListLine(VisImportChunk* chunk, const VisToken* tokens, int count);
+    bool dimacsLine(VisImportChunk* chunk, const VisToken* tokens, int count);
+    bool matrixMarketLine(VisImportChunk* chunk, const VisToken* tokens, int count);
+
+    bool addEdge(VisImportChunk* chunk, const VisToken& u, const VisToken& v);
+    bool fail(VisImportChunk* chunk, const QString& message);
+
+    quint32 indexOf(qint32 id) const;
+    void build(const QList<VisImportChunk*>& chunks, VisDocumentContent* content);
+};
+
+#endif // VISIMPORTER_HPP
@@ -0,0 +1,118 @@
+#ifndef VISITEMPOOL_HPP
+#define VISITEMPOOL_HPP
+
+#include <QList>
+#include <QMutex>
+#include <new>
+
+// Fixed size allocator for one item class. Items are carved out of blocks of
+// block_size slots and freed slots are reused, so building and erasing large
+// graphs does not go through the general heap for every item.
+//
+// Frame export builds scenes in worker threads, the free list is guarded
+// by a mutex that is never contended while only the GUI thread draws.
+template <class T>
+class VisItemPool
+{
+public:
+    static void* allocate(size_t size)
+    {
+        // Subclasses without their own pool
+        if(size != sizeof(T))
+            return ::operator new(size);
+
+        QMutexLocker locker(&mutex);
+        if(free_list == NULL)
+            grow();
+        Slot* slot = free_list;
+        free_list = slot->next;
+        live++;
+        return slot;
+    }
+
+    static void deallocate(void* p, size_t size)
+    {
+        if(p == NULL)
+            return;
+        if(size != sizeof(T)){
+            ::operator delete(p);
+            return;
+        }
+        QMutexLocker locker(&mutex);
+        Slot* slot = static_cast<Slot*>(p);
+        slot->next = free_list;
+        free_list = slot;
+        live--;
+    }
+
+    // Returns every block to the system, only once no item is alive
+    static void release()
+    {
+        QMutexLocker locker(&mutex);
+        if(live != 0)
+            return;
+        foreach(Slot* block, blocks){
+            ::operator delete(block);
+        }
+        blocks.clear();
+        free_list = NULL;
+    }
+
+    static int liveCount()
+    {
+        QMutexLocker locker(&mutex);
+        return live;
+    }
+
+    const static int block_size = 512;
+
+private:
+    union Slot
+    {
+        Slot*  next;
+        char   data[sizeof(T)];
+        double align_double;
+        void*  align_pointer;
+    };
+
+    static void grow()
+    {
+        Slot* block = static_cast<Slot*>(::operator new(sizeof(Slot)*block_size));
+        blocks.append(block);
+        for(int i = block_size-1; i >= 0; i--){
+            block[i].next = free_list;
+            free_list = &block[i];
+        }
+    }
+
+    static QList<Slot*> blocks;
+    static Slot*        free_list;
+    static int          live;
+    static QMutex       mutex;
+};
+
+template <class T>
+QList<typename VisItemPool<T>::Slot*> VisItemPool<T>::blocks;
+
+template <class T>
+typename VisItemPool<T>::Slot* VisItemPool<T>::free_list = NULL;
+
+template <class T>
+int VisItemPool<T>::live = 0;
+
+template <class T>
+QMutex VisItemPool<T>::mutex;
+
+// Declares the class allocation functions that use VisItemPool
+#define VIS_POOL_ALLOCATED \
+    static void* operator new(size_t size); \
+    static void operator delete(void* p, size_t size);
+
+// Defines them, in the translation unit of the class
+#define VIS_POOL_ALLOCATED_IMPL(CLASS) \
+    void* CLASS::operator new(size_t size) \
+    { return VisItemPool<CLASS>::allocate(size); } \
+    void CLASS::operator delete(void* p, size_t size) \
+    { VisItemPool<CLASS>::deallocate(p, size); }
+
+#endif // VISITEMPOOL_HPP
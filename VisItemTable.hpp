@@ -0,0 +1,244 @@
+#ifndef VISITEMTABLE_HPP
+#define VISITEMTABLE_HPP
+
+#include <QVector>
+#include <QHash>
+#include <QList>
+
+// Vertex id -> item table. The ids handed out by the scene are small and
+// consecutive, so they index a vector directly; any other id goes to a hash.
+template <class T>
+class VisIdTable
+{
+public:
+    VisIdTable() : count(0) {}
+
+    T* value(int id) const
+    {
+        if(id >= 0 and id < max_dense)
+            return id < dense.size() ? dense[id] : NULL;
+        return sparse.value(id, NULL);
+    }
+
+    bool contains(int id) const { return value(id) != NULL; }
+
+    void insert(int id, T* item)
+    {
+        if(id >= 0 and id < max_dense){
+            if(id >= dense.size())
+                dense.resize(qMin(int(max_dense), qMax(id+1, 2*dense.size())));
+            if(dense[id] == NULL)
+                count++;
+            dense[id] = item;
+        }else{
+            if(!sparse.contains(id))
+                count++;
+            sparse.insert(id, item);
+        }
+    }
+
+    void remove(int id)
+    {
+        if(id >= 0 and id < max_dense){
+            if(id < dense.size() and dense[id] != NULL){
+                count--;
+                dense[id] = NULL;
+            }
+        }else if(sparse.remove(id) > 0){
+            count--;
+        }
+    }
+
+    void clear()
+    {
+        dense.clear();
+        sparse.clear();
+        count = 0;
+    }
+
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+
+    QList<int> keys() const
+    {
+        QList<int> ids;
+        ids.reserve(count);
+        for(int id = 0; id < dense.size(); id++){
+            if(dense[id] != NULL)
+                ids.append(id);
+        }
+        ids.append(sparse.keys());
+        return ids;
+    }
+
+    QList<T*> values() const
+    {
+        QList<T*> items;
+        items.reserve(count);
+        for(int id = 0; id < dense.size(); id++){
+            if(dense[id] != NULL)
+                items.append(dense[id]);
+        }
+        items.append(sparse.values());
+        return items;
+    }
+
+    const static int max_dense = 1 << 22;
+
+private:
+    QVector<T*>     dense;
+    QHash<int, T*>  sparse;
+    int             count;
+};
+
+// (aid, bid) -> item table for edges and arrows, stored once per item.
+// Symmetric tables find edges by either orientation.
+//
+// Flat open addressing with linear probing: each slot holds the packed
+// 64-bit key next to the item, so a lookup usually touches one cache line.
+// Removal shifts the following entries back instead of leaving tombstones.
+template <class T>
+class VisPairTable
+{
+public:
+    explicit VisPairTable(bool symmetric_)
+        : symmetric(symmetric_), count(0), mask(-1) {}
+
+    T* value(int aid, int bid) const
+    {
+        int i = find(key(aid, bid));
+        return i < 0 ? NULL : entries[i].item;
+    }
+
+    bool contains(int aid, int bid) const { return find(key(aid, bid)) >= 0; }
+
+    void insert(int aid, int bid, T* item)
+    {
+        if(4*(count+1) > 3*entries.size())
+            rehash(entries.isEmpty() ? min_capacity : 2*entries.size());
+
+        quint64 k = key(aid, bid);
+        int i = hash(k) & mask;
+        while(entries[i].item != NULL){
+            if(entries[i].key == k){
+                entries[i].item = item;
+                return;
+            }
+            i = (i+1) & mask;
+        }
+        entries[i].key = k;
+        entries[i].item = item;
+        count++;
+    }
+
+    void remove(int aid, int bid)
+    {
+        int i = find(key(aid, bid));
+        if(i < 0)
+            return;
+
+        // Backward shift: move up every entry of the run that would no
+        // longer be reachable from its home slot
+        int j = i;
+        for(;;){
+            j = (j+1) & mask;
+            if(entries[j].item == NULL)
+                break;
+            int home = hash(entries[j].key) & mask;
+            bool reachable = (i <= j) ? (i < home and home <= j)
+                                      : (i < home or home <= j);
+            if(!reachable){
+                entries[i] = entries[j];
+                i = j;
+            }
+        }
+        entries[i].key = 0;
+        entries[i].item = NULL;
+        count--;
+    }
+
+    void clear()
+    {
+        entries.clear();
+        count = 0;
+        mask = -1;
+    }
+
+    int size() const { return count; }
+    bool isEmpty() const { return count == 0; }
+
+    QList<T*> values() const
+    {
+        QList<T*> items;
+        items.reserve(count);
+        for(int i = 0; i < entries.size(); i++){
+            if(entries[i].item != NULL)
+                items.append(entries[i].item);
+        }
+        return items;
+    }
+
+    const static int min_capacity = 64;
+
+private:
+    struct Slot
+    {
+        quint64 key;
+        T*      item;
+        Slot() : key(0), item(NULL) {}
+    };
+
+    quint64 key(int aid, int bid) const
+    {
+        if(symmetric and bid < aid)
+            qSwap(aid, bid);
+        return (quint64(quint32(aid)) << 32) | quint64(quint32(bid));
+    }
+
+    static uint hash(quint64 k)
+    {
+        // 64-bit finalizer from MurmurHash3, ids are consecutive integers
+        k ^= k >> 33;
+        k *= Q_UINT64_C(0xff51afd7ed558ccd);
+        k ^= k >> 33;
+        k *= Q_UINT64_C(0xc4ceb9fe1a85ec53);
+        k ^= k >> 33;
+        return uint(k);
+    }
+
+    int find(quint64 k) const
+    {
+        if(count == 0)
+            return -1;
+        int i = hash(k) & mask;
+        while(entries[i].item != NULL){
+            if(entries[i].key == k)
+                return i;
+            i = (i+1) & mask;
+        }
+        return -1;
+    }
+
+    void rehash(int capacity)
+    {
+        QVector<Slot> old_entries = entries;
+        entries = QVector<Slot>(capacity);
+        mask = capacity-1;
+        for(int i = 0; i < old_entries.size(); i++){
+            const Slot& slot = old_entries[i];
+            if(slot.item == NULL)
+                continue;
+            int j = hash(slot.key) & mask;
+            while(entries[j].item != NULL)
+                j = (j+1) & mask;
+            entries[j] = slot;
+        }
+    }
+
+    bool          symmetric;
+    QVector<Slot> entries;
+    int           count;
+    int           mask;
+};
+
+#endif // VISITEMTABLE_HPP
@@ -1,18 +1,83 @@
 #include "VisLabel.hpp"
+#include "VisTextCache.hpp"
+#include "VisGraphicsScene.hpp"
 
 #include <QTextCursor>
+#include <QTextDocument>
 #include <QGraphicsSceneMouseEvent>
 #include <QPainter>
 #include <QStyleOptionGraphicsItem>
+#include <QFontMetricsF>
+#include <QCoreApplication>
+#include <QThread>
+
+VIS_POOL_ALLOCATED_IMPL(VisLabel)
+
+// Las escenas que se dibujan en otros hilos, al exportar fotogramas, no
+// usan el cache de pixmaps ni la lista de etiquetas en borrador
+static bool inGuiThread()
+{
+    return QThread::currentThread() == QCoreApplication::instance()->thread();
+}
+
+VisLabelEditor::VisLabelEditor(VisLabel* label_)
+    : QGraphicsTextItem(label_->toPlainText(), label_), label(label_)
+{
+    setFont(VisLabel::labelFont());
+    setTextInteractionFlags(Qt::TextEditorInteraction);
+}
+
+void VisLabelEditor::focusOutEvent(QFocusEvent *event)
+{
+    QGraphicsTextItem::focusOutEvent(event);
+    label->setTextInteraction(false);
+}
 
 VisLabel::VisLabel(QString text, QGraphicsItem* parent)
-    : QGraphicsTextItem(text, parent)
+    : QGraphicsItem(parent), is_highlighted(false), highlight_color(QColor(255,255,255)), editor(NULL)
 {
     setFlags(ItemIsSelectable | ItemIsMovable | ItemIsFocusable);
-    setTextInteractionFlags(Qt::NoTextInteraction);
     setZValue(30);
 
-    setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+    if(inGuiThread())
+        setCacheMode(QGraphicsItem::DeviceCoordinateCache);
+
+    setPlainText(text);
+}
+
+QSet<VisLabel*> VisLabel::draft_painted;
+
+VisLabel::~VisLabel()
+{
+    if(inGuiThread())
+        draft_painted.remove(this);
+    delete editor;
+}
+
+void VisLabel::refineDraftPainted()
+{
+    foreach(VisLabel* label, draft_painted){
+        label->update();
+    }
+    draft_painted.clear();
+}
+
+QFont VisLabel::labelFont()
+{
+    static QFont label_font;
+    return label_font;
+}
+
+void VisLabel::setPlainText(const QString& text_)
+{
+    prepareGeometryChange();
+    text = text_;
+    static_text = VisTextCache::text(text);
+
+    QFontMetricsF metrics(labelFont());
+    double tw = text.isEmpty() ? 0 : metrics.width(text);
+    rect = QRectF(0, 0, tw+2*margin, metrics.height()+2*margin);
+    update();
 }
 
 void VisLabel::set_highlight(int r,int g,int b,int a)
@@ -26,9 +91,39 @@ void VisLabel::set_unhighlighted()
     is_highlighted = false;
 }
 
-void VisLabel::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget)
+void VisLabel::setText(const QString& text)
 {
-    if(toPlainText() != ""){
+    setPlainText(text);
+    reanchor();
+}
+
+void VisLabel::setAnchor(const QPointF& point)
+{
+    anchor = point;
+    reanchor();
+}
+
+void VisLabel::reanchor()
+{
+    double lh = boundingRect().height()+6;
+    double lw = boundingRect().width()/2.0;
+    setPos(anchor.x()-lw, anchor.y()-lh);
+}
+
+QRectF VisLabel::boundingRect() const
+{
+    return rect;
+}
+
+void VisLabel::paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *)
+{
+    // En calidad de borrador no hay fondo
+    bool draft = VisGraphicsScene::isDraft(this);
+    if(draft and inGuiThread()){
+        draft_painted.insert(this);
+    }
+
+    if(text != "" && !draft){
         if(is_highlighted){
             painter->setBrush(QBrush(highlight_color));
             painter->drawRect(boundingRect());
@@ -37,49 +132,62 @@ void VisLabel::paint(QPainter *painter, const QStyleOptionGraphicsItem *option,
             painter->drawRect(boundingRect());
         }
     }
-    QGraphicsTextItem::paint(painter, option, widget);
+    // Mientras se edita el texto lo dibuja el editor
+    if(editor == NULL){
+        painter->setFont(labelFont());
+        painter->drawStaticText(QPointF(margin, margin), static_text);
+    }
+    if(option->state & QStyle::State_Selected){
+        painter->setPen(QPen(QColor(127,127,127), 0, Qt::DashLine));
+        painter->setBrush(Qt::NoBrush);
+        painter->drawRect(boundingRect());
+    }
 }
 
 void VisLabel::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *evt)
 {
-    if(textInteractionFlags() == Qt::TextEditorInteraction)
+    if(editor != NULL)
     {
-        QGraphicsTextItem::mouseDoubleClickEvent(evt);
+        QGraphicsItem::mouseDoubleClickEvent(evt);
         return;
     }
-    setTextInteraction(true);
-    QGraphicsSceneMouseEvent *click = new QGraphicsSceneMouseEvent(QEvent::GraphicsSceneMousePress);
-    click->setButton(evt->button());
-    click->setPos(evt->pos());
-    QGraphicsTextItem::mousePressEvent(click);
-    delete click;
+    setTextInteraction(true, true);
 }
 
 void VisLabel::setTextInteraction(bool on, bool selectAll)
 {
-    if(on && textInteractionFlags() == Qt::NoTextInteraction){
-        setTextInteractionFlags(Qt::TextEditorInteraction);
-        setFocus(Qt::MouseFocusReason);
+    if(on && editor == NULL){
+        editor = new VisLabelEditor(this);
+        editor->setPos(margin-editor->document()->documentMargin(),
+                       margin-editor->document()->documentMargin());
+        editor->setFocus(Qt::MouseFocusReason);
         setSelected(true);
         if(selectAll){
-            QTextCursor c = textCursor();
+            QTextCursor c = editor->textCursor();
             c.select(QTextCursor::Document);
-            setTextCursor(c);
+            editor->setTextCursor(c);
         }
+        update();
     }
-    else if(!on && textInteractionFlags() == Qt::TextEditorInteraction){
-        setTextInteractionFlags(Qt::NoTextInteraction);
-        QTextCursor c = this->textCursor();
-        c.clearSelection();
-        this->setTextCursor(c);
-        clearFocus();
+    else if(!on && editor != NULL){
+        // El editor se elimina despues de procesar el evento que lo cerro
+        VisLabelEditor* old_editor = editor;
+        editor = NULL;
+        old_editor->setTextInteractionFlags(Qt::NoTextInteraction);
+        old_editor->hide();
+        setText(old_editor->toPlainText());
+        old_editor->deleteLater();
+
+        VisGraphicsScene* vis_scene = dynamic_cast<VisGraphicsScene*>(scene());
+        if(vis_scene != NULL)
+            vis_scene->visTrackLabel(this);
     }
 }
 
 QVariant VisLabel::itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant &value)
 {
-    if(change == QGraphicsItem::ItemSelectedChange && textInteractionFlags() != Qt::NoTextInteraction && !value.toBool()){
+    if(change == QGraphicsItem::ItemSelectedChange && editor != NULL && !value.toBool()){
         setTextInteraction(false); // leave editor mode
     }
-    return QGraphicsTextItem::itemChange(change, value);
+    return QGraphicsItem::itemChange(change, value);
 }
@@ -2,19 +2,42 @@
 #define VISLABE_HPP
 
 // Parent class
+#include <QGraphicsItem>
+
+// Member classes
 #include <QGraphicsTextItem>
+#include <QStaticText>
+#include <QFont>
+#include <QSet>
+#include "VisItemPool.hpp"
+
+class VisLabel;
+
+// Text editor created only while a label is being edited
+class VisLabelEditor : public QGraphicsTextItem
+{
+public:
+    VisLabelEditor(VisLabel* label);
 
+    void focusOutEvent(QFocusEvent *event);
 
+    VisLabel* label;
+};
 
-class VisLabel : public QGraphicsTextItem
+class VisLabel : public QGraphicsItem
 {
 public:
     enum {Type = 104};
 
     VisLabel(QString text = "etiqueta", QGraphicsItem* parent = 0);
+    ~VisLabel();
 
     int type() const {return Type;}
 
+    // Allocated from VisItemPool
+    VIS_POOL_ALLOCATED
+
+    QRectF boundingRect() const;
     void paint(QPainter *painter, const QStyleOptionGraphicsItem *option, QWidget *widget);
 
     void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *evt);
@@ -23,11 +46,37 @@ public:
 
     void setTextInteraction(bool on, bool selectAll = false);
 
+    void setPlainText(const QString& text);
+    QString toPlainText() const { return text; }
+
+    void setText(const QString& text);
+    void setAnchor(const QPointF& point);
+    void reanchor();
+
     void set_highlight(int,int,int,int);
     void set_unhighlighted();
 
     bool is_highlighted;
     QColor highlight_color;
+
+    // Point the label is centered above (scene coordinates)
+    QPointF anchor;
+
+    const static int margin = 4;
+
+    static QFont labelFont();
+
+    // Repaint the labels whose cache was filled while drawing in draft quality
+    static void refineDraftPainted();
+
+private:
+    QString     text;
+    QStaticText static_text;
+    QRectF      rect;
+
+    VisLabelEditor* editor;
+
+    static QSet<VisLabel*> draft_painted;
 };
 
 #endif // VISLABE_HPP
@@ -2,6 +2,13 @@
 
 #include <QStatusBar>
 #include <QMessageBox>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QProgressDialog>
+#include <QTimer>
+#include <QInputDialog>
+
+#include "VisImporter.hpp"
 
 ///////////////////////////////////////////////////////////////////
 ///////////////////////////////////////////////////////////////////
@@ -110,10 +117,49 @@ VisMainWindow::VisMainWindow(QWidget *parent)
         ui_toolbar->addSeparator();
         ui_toolbar->addWidget(ui_toolbar_button_step);
         ui_toolbar->addWidget(ui_toolbar_checkbox_step);
+
+        ui_replay_button_back    = new QPushButton("<");
+        ui_replay_button_play    = new QPushButton("play");
+        ui_replay_button_forward = new QPushButton(">");
+        ui_replay_slider_step    = new QSlider(Qt::Horizontal);
+        ui_replay_label_speed    = new QLabel("steps/s:");
+        ui_replay_spinbox_speed  = new QSpinBox;
+        ui_replay_spinbox_speed->setRange(1, 1000);
+        ui_replay_spinbox_speed->setValue(2);
+        ui_replay_button_close   = new QPushButton("close");
+
+        ui_replay_toolbar = addToolBar("Replay");
+        ui_replay_toolbar->addWidget(ui_replay_button_back);
+        ui_replay_toolbar->addWidget(ui_replay_button_play);
+        ui_replay_toolbar->addWidget(ui_replay_button_forward);
+        ui_replay_toolbar->addWidget(ui_replay_slider_step);
+        ui_replay_toolbar->addSeparator();
+        ui_replay_toolbar->addWidget(ui_replay_label_speed);
+        ui_replay_toolbar->addWidget(ui_replay_spinbox_speed);
+        ui_replay_toolbar->addSeparator();
+        ui_replay_toolbar->addWidget(ui_replay_button_close);
+        ui_replay_toolbar->hide();
     }
 
     // Actions initialization
     {
+        ui_action_open = new QAction("Open...", this);
+        init_action(ui_action_open, "Ctrl+O", ui_menu_file);
+
+        ui_action_save = new QAction("Save as...", this);
+        init_action(ui_action_save, "Ctrl+S", ui_menu_file);
+
+        ui_action_import = new QAction("Import...", this);
+        init_action(ui_action_import, "Ctrl+I", ui_menu_file);
+
+        ui_action_export = new QAction("Export...", this);
+        init_action(ui_action_export, "Ctrl+Shift+E", ui_menu_file);
+
+        ui_action_render_image = new QAction("Render image...", this);
+        init_action(ui_action_render_image, "Ctrl+Shift+R", ui_menu_file);
+
+        ui_menu_file->addSeparator();
+
         ui_action_exit = new QAction("Exit", this);
         init_action(ui_action_exit, "Ctrl+Q", ui_menu_file);
 
@@ -159,6 +205,35 @@ VisMainWindow::VisMainWindow(QWidget *parent)
         ui_action_run_min_cost_shortests_paths = new QAction("Run Minimum Cost Constant Flow algorithm", this);
         init_action(ui_action_run_min_cost_shortests_paths, "F12", ui_menu_algorithms, false);
 
+        ui_menu_algorithms->addSeparator();
+
+        ui_action_stop_algorithm = new QAction("Stop algorithm", this);
+        init_action(ui_action_stop_algorithm, "Esc", ui_menu_algorithms, false);
+
+        ui_menu_algorithms->addSeparator();
+
+        ui_action_record_traces = new QAction("Record traces", this);
+        ui_action_record_traces->setCheckable(true);
+        ui_action_record_traces->setChecked(false);
+        init_action(ui_action_record_traces, "Ctrl+R", ui_menu_algorithms);
+
+        ui_action_replay_trace = new QAction("Replay trace", this);
+        init_action(ui_action_replay_trace, "Ctrl+P", ui_menu_algorithms, false);
+
+        ui_action_open_trace = new QAction("Open trace...", this);
+        init_action(ui_action_open_trace, "Ctrl+Shift+O", ui_menu_algorithms);
+
+        ui_action_save_trace = new QAction("Save trace...", this);
+        init_action(ui_action_save_trace, "Ctrl+Shift+S", ui_menu_algorithms, false);
+
+        ui_action_export_frames = new QAction("Export frames...", this);
+        init_action(ui_action_export_frames, "Ctrl+Shift+F", ui_menu_algorithms, false);
+
+        ui_action_write_results = new QAction("Write results...", this);
+        ui_action_write_results->setCheckable(true);
+        ui_action_write_results->setChecked(false);
+        init_action(ui_action_write_results, "Ctrl+Shift+W", ui_menu_algorithms);
+
         ui_action_help = new QAction("Help", this);
         init_action(ui_action_help, "Ctrl+H", ui_menu_about);
 
@@ -187,6 +262,16 @@ VisMainWindow::VisMainWindow(QWidget *parent)
                 this,                   SLOT(visStepDone()));
         connect(environment, SIGNAL(visStepWait(QString)),
                 this,        SLOT(visStepWait(QString)));
+        connect(ui_action_open, SIGNAL(triggered()),
+                this,           SLOT(visOpenDocument()));
+        connect(ui_action_save, SIGNAL(triggered()),
+                this,           SLOT(visSaveDocument()));
+        connect(ui_action_import, SIGNAL(triggered()),
+                this,             SLOT(visImportGraph()));
+        connect(ui_action_export, SIGNAL(triggered()),
+                this,             SLOT(visExportGraph()));
+        connect(ui_action_render_image, SIGNAL(triggered()),
+                this,                   SLOT(visRenderImage()));
         connect(ui_action_exit, SIGNAL(triggered()),
                 this,           SLOT(visExitApplication()));
         connect(ui_action_delete_selection, SIGNAL(triggered()),
@@ -217,6 +302,44 @@ VisMainWindow::VisMainWindow(QWidget *parent)
                 environment,                            SLOT(visRunMinimumCostConstantFlowNC()));
         connect(ui_action_run_min_cost_shortests_paths, SIGNAL(triggered()),
                 environment,                            SLOT(visRunMinimumCostConstantFlowSP()));
+        connect(ui_action_stop_algorithm, SIGNAL(triggered()),
+                environment,              SLOT(visStopAlgorithms()));
+        connect(environment, SIGNAL(visAlgorithmStarted(int)),
+                this,        SLOT(visAlgorithmStarted(int)));
+        connect(environment, SIGNAL(visAlgorithmFinished(int,int)),
+                this,        SLOT(visAlgorithmFinished(int,int)));
+        connect(ui_action_record_traces, SIGNAL(toggled(bool)),
+                environment,             SLOT(visRecordTraces(bool)));
+        connect(environment, SIGNAL(visTraceRecorded()),
+                this,        SLOT(visTraceRecorded()));
+        connect(ui_action_replay_trace, SIGNAL(triggered()),
+                this,                   SLOT(visReplayTrace()));
+        connect(ui_action_open_trace, SIGNAL(triggered()),
+                this,                 SLOT(visOpenTrace()));
+        connect(ui_action_save_trace, SIGNAL(triggered()),
+                this,                 SLOT(visSaveTrace()));
+        connect(ui_action_export_frames, SIGNAL(triggered()),
+                this,                    SLOT(visExportFrames()));
+        connect(ui_action_write_results, SIGNAL(toggled(bool)),
+                this,                    SLOT(visWriteResults(bool)));
+
+        VisTracePlayer* player = environment->tracePlayer();
+        connect(ui_replay_button_back, SIGNAL(clicked()),
+                player,                SLOT(visStepBackward()));
+        connect(ui_replay_button_forward, SIGNAL(clicked()),
+                player,                   SLOT(visStepForward()));
+        connect(ui_replay_button_play, SIGNAL(clicked()),
+                this,                  SLOT(visReplayPlay()));
+        connect(ui_replay_slider_step, SIGNAL(valueChanged(int)),
+                player,                SLOT(visSeek(int)));
+        connect(ui_replay_spinbox_speed, SIGNAL(valueChanged(int)),
+                player,                  SLOT(visSetSpeed(int)));
+        connect(ui_replay_button_close, SIGNAL(clicked()),
+                this,                   SLOT(visReplayClose()));
+        connect(player, SIGNAL(visStepChanged(int,QString)),
+                this,   SLOT(visReplayStep(int,QString)));
+        connect(player, SIGNAL(visPlaybackFinished()),
+                this,   SLOT(visReplayFinished()));
         connect(ui_action_help, SIGNAL(triggered()),
                 this,           SLOT(visShowHelp()));
         connect(ui_action_info, SIGNAL(triggered()),
@@ -227,6 +350,9 @@ VisMainWindow::VisMainWindow(QWidget *parent)
         connect(ui_action_toggle_curves, SIGNAL(toggled(bool)),
                 environment,             SLOT(visCurves(bool)));
     }
+
+    // La pregunta se hace con la ventana ya visible
+    QTimer::singleShot(0, this, SLOT(visRestoreSession()));
 }
 
 VisMainWindow::~VisMainWindow()
@@ -242,7 +368,19 @@ VisMainWindow::~VisMainWindow()
     delete ui_toolbar_combobox_graph_type;
     delete ui_toolbar_button_step;
     delete ui_toolbar_checkbox_step;
-
+    delete ui_replay_button_back;
+    delete ui_replay_button_play;
+    delete ui_replay_button_forward;
+    delete ui_replay_slider_step;
+    delete ui_replay_label_speed;
+    delete ui_replay_spinbox_speed;
+    delete ui_replay_button_close;
+
+    delete ui_action_open;
+    delete ui_action_save;
+    delete ui_action_import;
+    delete ui_action_export;
+    delete ui_action_render_image;
     delete ui_action_exit;
     delete ui_action_delete_selection;
     delete ui_action_clean_graph;
@@ -258,6 +396,13 @@ VisMainWindow::~VisMainWindow()
     delete ui_action_run_ford_fulkerson;
     delete ui_action_run_min_cost_negative_cycles;
     delete ui_action_run_min_cost_shortests_paths;
+    delete ui_action_stop_algorithm;
+    delete ui_action_record_traces;
+    delete ui_action_replay_trace;
+    delete ui_action_open_trace;
+    delete ui_action_save_trace;
+    delete ui_action_export_frames;
+    delete ui_action_write_results;
     delete ui_action_help;
     delete ui_action_info;
 }
@@ -309,6 +454,185 @@ void VisMainWindow::visSetGraphType(int type)
     }
 }
 
+void VisMainWindow::visOpenDocument()
+{
+    QString path = QFileDialog::getOpenFileName(this, "Open graph", QString(),
+                                                "Graph documents (*.sgv)");
+    if(path.isEmpty())
+        return;
+
+    VisDocument document;
+    if(not document.open(path)){
+        QMessageBox::warning(this, "Open graph", document.errorString());
+        return;
+    }
+
+    // Los menus se ajustan mientras el entorno conserva el tipo anterior
+    int type = document.directed() ? 1 : 0;
+    ui_toolbar_combobox_graph_type->setCurrentIndex(type);
+    visSetGraphType(type);
+    environment->loadDocument(document);
+    setWindowFilePath(path);
+}
+
+void VisMainWindow::visRestoreSession()
+{
+    VisAutosave* autosave = environment->autosaver();
+    if(autosave->hasJournal()){
+        int answer = QMessageBox::question(this, "Restore session",
+                                           "The previous session did not end normally.\n"
+                                           "Restore its last autosaved graph?",
+                                           QMessageBox::Yes | QMessageBox::No, QMessageBox::Yes);
+        if(answer == QMessageBox::Yes){
+            VisDocumentContent content;
+            VisDocument document;
+            QString error;
+            if(not autosave->restore(&content, &error) or not document.open(content)){
+                QMessageBox::warning(this, "Restore session",
+                                     error.isEmpty() ? document.errorString() : error);
+            }else{
+                int type = document.directed() ? 1 : 0;
+                ui_toolbar_combobox_graph_type->setCurrentIndex(type);
+                visSetGraphType(type);
+                environment->loadDocument(document);
+            }
+        }
+    }
+    // El primer checkpoint reemplaza el journal anterior
+    autosave->start();
+}
+
+void VisMainWindow::visSaveDocument()
+{
+    QString path = QFileDialog::getSaveFileName(this, "Save graph", windowFilePath(),
+                                                "Graph documents (*.sgv)");
+    if(path.isEmpty())
+        return;
+    if(QFileInfo(path).suffix().isEmpty())
+        path += ".sgv";
+
+    QString error;
+    if(not environment->saveDocument(path, &error)){
+        QMessageBox::warning(this, "Save graph", error);
+        return;
+    }
+    setWindowFilePath(path);
+}
+
+void VisMainWindow::visImportGraph()
+{
+    QString path = QFileDialog::getOpenFileName(this, "Import graph", QString(),
+                                                "Edge lists (*.txt *.edges *.el);;"
+                                                "DIMACS flow problems (*.max *.min *.dimacs *.inp);;"
+                                                "Matrix Market (*.mtx);;"
+                                                "GraphML (*.graphml);;"
+                                                "GEXF (*.gexf);;"
+                                                "All files (*)");
+    if(path.isEmpty())
+        return;
+
+    VisImporter importer;
+    QProgressDialog progress("Importing " + QFileInfo(path).fileName(), "Cancel", 0, 1000, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    connect(&importer, SIGNAL(visProgress(int)),
+            &progress, SLOT(setValue(int)));
+    connect(&progress, SIGNAL(canceled()),
+            &importer, SLOT(visCancel()));
+
+    VisDocument document;
+    {
+        // El contenido se libera en cuanto el documento tiene su copia
+        VisDocumentContent content;
+        bool directed = environment->graphType() == VisGraphicsScene::DIRECTED;
+        if(not importer.import(path, VisImporter::formatOf(path), directed, &content)){
+            progress.reset();
+            if(not importer.wasCancelled())
+                QMessageBox::warning(this, "Import graph", importer.errorString());
+            return;
+        }
+        if(not document.open(content)){
+            progress.reset();
+            QMessageBox::warning(this, "Import graph", document.errorString());
+            return;
+        }
+    }
+
+    int type = document.directed() ? 1 : 0;
+    ui_toolbar_combobox_graph_type->setCurrentIndex(type);
+    visSetGraphType(type);
+    environment->loadDocument(document);
+    environment->loadAttributes(importer.attributes);
+    progress.reset();
+    setWindowFilePath("");
+
+    if(not importer.sources.isEmpty() or not importer.sinks.isEmpty()){
+        QStringList sources, sinks;
+        foreach(int id, importer.sources)
+            sources.append(QString::number(id));
+        foreach(int id, importer.sinks)
+            sinks.append(QString::number(id));
+        QString message = "Sources: " + sources.join(" ") + "  Sinks: " + sinks.join(" ");
+        if(importer.flow > 0)
+            message += "  Flow: " + QString::number(importer.flow);
+        statusBar()->show();
+        statusBar()->showMessage(message);
+    }
+}
+
+void VisMainWindow::visExportGraph()
+{
+    QString filter;
+    QString path = QFileDialog::getSaveFileName(this, "Export graph", QString(),
+                                                "GraphML (*.graphml);;GEXF (*.gexf)", &filter);
+    if(path.isEmpty())
+        return;
+    if(QFileInfo(path).suffix().isEmpty())
+        path += filter.startsWith("GEXF") ? ".gexf" : ".graphml";
+
+    QString error;
+    if(not environment->exportGraph(path, &error))
+        QMessageBox::warning(this, "Export graph", error);
+}
+
+void VisMainWindow::visRenderImage()
+{
+    QString filter;
+    QString path = QFileDialog::getSaveFileName(this, "Render image", QString(),
+                                                "PNG images (*.png);;SVG drawings (*.svg)", &filter);
+    if(path.isEmpty())
+        return;
+    if(QFileInfo(path).suffix().isEmpty())
+        path += filter.startsWith("SVG") ? ".svg" : ".png";
+
+    bool ok;
+    VisImageSettings settings;
+    settings.scale = QInputDialog::getDouble(this, "Render image", "Scale (1 is the view at 100%):",
+                                             1, 0.01, 100, 2, &ok);
+    if(not ok)
+        return;
+    QStringList details;
+    details << "Everything" << "Without labels" << "Only vertices and edges";
+    QString detail = QInputDialog::getItem(this, "Render image", "Detail:", details, 0, false, &ok);
+    if(not ok)
+        return;
+    settings.detail = (VisImageSettings::DETAIL) details.indexOf(detail);
+
+    VisImageExporter exporter;
+    QProgressDialog progress("Rendering " + QFileInfo(path).fileName(), "Cancel", 0, 1000, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    connect(&exporter, SIGNAL(visProgress(int)),
+            &progress, SLOT(setValue(int)));
+    connect(&progress, SIGNAL(canceled()),
+            &exporter, SLOT(visCancel()));
+
+    bool done = environment->renderImage(exporter, path, settings);
+    progress.reset();
+    if(not done and not exporter.wasCancelled())
+        QMessageBox::warning(this, "Render image", exporter.errorString());
+}
+
 void VisMainWindow::visExitApplication()
 {
     close();
@@ -355,3 +679,205 @@ void VisMainWindow::visShowMessage(QString message)
     dialog->exec();
     visStepDone();
 }
+
+void VisMainWindow::visAlgorithmStarted(int)
+{
+    // El algoritmo dibuja sobre la escena, la reproduccion termina
+    if(ui_replay_toolbar->isVisible())
+        visReplayClose();
+    ui_action_stop_algorithm->setEnabled(true);
+}
+
+void VisMainWindow::visAlgorithmFinished(int, int status)
+{
+    if(environment->algorithmsRunning())
+        return;
+
+    ui_action_stop_algorithm->setEnabled(false);
+    visStepDone();
+    if(status == VisSchemeExecutor::CANCELLED){
+        statusBar()->show();
+        statusBar()->showMessage("Algorithm stopped");
+    }else if(status == VisSchemeExecutor::FAILED){
+        statusBar()->show();
+        statusBar()->showMessage("Algorithm failed, see the console output");
+    }
+}
+
+void VisMainWindow::visTraceRecorded()
+{
+    ui_action_replay_trace->setEnabled(environment->hasTrace());
+    ui_action_save_trace->setEnabled(environment->hasTrace());
+    ui_action_export_frames->setEnabled(environment->hasTrace());
+}
+
+void VisMainWindow::visReplayTrace()
+{
+    if(environment->algorithmsRunning() or not environment->hasTrace())
+        return;
+
+    // Los menus se ajustan mientras el entorno conserva el tipo anterior
+    int type = environment->traceDirected() ? 1 : 0;
+    ui_toolbar_combobox_graph_type->setCurrentIndex(type);
+    visSetGraphType(type);
+    environment->replayTrace();
+
+    VisTracePlayer* player = environment->tracePlayer();
+    ui_replay_slider_step->blockSignals(true);
+    ui_replay_slider_step->setRange(0, player->stepCount()-1);
+    ui_replay_slider_step->setValue(0);
+    ui_replay_slider_step->blockSignals(false);
+    player->visSetSpeed(ui_replay_spinbox_speed->value());
+    ui_replay_button_play->setText("play");
+    ui_replay_toolbar->show();
+    visReplayStep(0, "");
+}
+
+void VisMainWindow::visOpenTrace()
+{
+    QString path = QFileDialog::getOpenFileName(this, "Open trace", QString(),
+                                                "Algorithm traces (*.sgt)");
+    if(path.isEmpty())
+        return;
+
+    visReplayClose();
+    QString error;
+    if(not environment->openTrace(path, &error)){
+        QMessageBox::warning(this, "Open trace", error);
+        return;
+    }
+    visTraceRecorded();
+    visReplayTrace();
+}
+
+void VisMainWindow::visSaveTrace()
+{
+    QString path = QFileDialog::getSaveFileName(this, "Save trace", QString(),
+                                                "Algorithm traces (*.sgt)");
+    if(path.isEmpty())
+        return;
+    if(QFileInfo(path).suffix().isEmpty())
+        path += ".sgt";
+
+    QString error;
+    if(not environment->saveTrace(path, &error))
+        QMessageBox::warning(this, "Save trace", error);
+}
+
+void VisMainWindow::visExportFrames()
+{
+    if(not environment->hasTrace())
+        return;
+
+    QString filter;
+    QString path = QFileDialog::getSaveFileName(this, "Export frames", QString(),
+                                                "PNG sequence (*.png);;"
+                                                "Video through ffmpeg (*.mp4 *.webm *.mkv)", &filter);
+    if(path.isEmpty())
+        return;
+    bool video = filter.startsWith("Video");
+    if(QFileInfo(path).suffix().isEmpty())
+        path += video ? ".mp4" : ".png";
+
+    QStringList sizes;
+    sizes << "1280x720" << "1920x1080" << "3840x2160";
+    bool ok;
+    QString size = QInputDialog::getItem(this, "Export frames", "Frame size:", sizes, 0, true, &ok);
+    if(not ok)
+        return;
+    QStringList wh = size.split('x');
+    VisFrameSettings settings;
+    if(wh.size() == 2)
+        settings.size = QSize(wh[0].trimmed().toInt(), wh[1].trimmed().toInt());
+    if(settings.size.isEmpty()){
+        QMessageBox::warning(this, "Export frames", "Invalid frame size: " + size);
+        return;
+    }
+
+    // Un PNG por paso junto al archivo elegido, o los fotogramas crudos a
+    // la entrada de ffmpeg, a la velocidad de la reproduccion
+    QFileInfo info(path);
+    if(video){
+        // yuv420p necesita lados pares
+        settings.size = QSize(settings.size.width() & ~1, settings.size.height() & ~1);
+        settings.encoder = "ffmpeg";
+        settings.encoder_arguments << "-y" << "-loglevel" << "error"
+                                   << "-f" << "rawvideo" << "-pix_fmt" << "rgba"
+                                   << "-s" << QString("%1x%2").arg(settings.size.width()).arg(settings.size.height())
+                                   << "-r" << QString::number(ui_replay_spinbox_speed->value())
+                                   << "-i" << "-"
+                                   << "-pix_fmt" << "yuv420p" << path;
+    }else{
+        settings.directory = info.path();
+        settings.prefix    = info.completeBaseName() + "_";
+    }
+
+    VisFrameExporter exporter;
+    QProgressDialog progress("Exporting " + info.fileName(), "Cancel", 0, 1000, this);
+    progress.setWindowModality(Qt::WindowModal);
+    progress.setMinimumDuration(500);
+    connect(&exporter, SIGNAL(visProgress(int)),
+            &progress, SLOT(setValue(int)));
+    connect(&progress, SIGNAL(canceled()),
+            &exporter, SLOT(visCancel()));
+
+    bool done = environment->exportFrames(exporter, settings);
+    progress.reset();
+    if(not done and not exporter.wasCancelled())
+        QMessageBox::warning(this, "Export frames", exporter.errorString());
+}
+
+void VisMainWindow::visWriteResults(bool write)
+{
+    if(not write){
+        environment->setResultsFile("");
+        return;
+    }
+
+    // Cada algoritmo que se ejecute reescribe el archivo
+    QString path = QFileDialog::getSaveFileName(this, "Write results", QString(),
+                                                "CSV tables (*.csv);;"
+                                                "Columnar results (*.sgr)");
+    if(path.isEmpty()){
+        ui_action_write_results->setChecked(false);
+        return;
+    }
+    if(QFileInfo(path).suffix().isEmpty())
+        path += ".csv";
+    environment->setResultsFile(path);
+}
+
+void VisMainWindow::visReplayPlay()
+{
+    VisTracePlayer* player = environment->tracePlayer();
+    if(player->isPlaying()){
+        player->visPause();
+        ui_replay_button_play->setText("play");
+    }else{
+        player->visPlay();
+        ui_replay_button_play->setText("pause");
+    }
+}
+
+void VisMainWindow::visReplayStep(int step, QString message)
+{
+    // El deslizador sigue al reproductor sin volver a buscar el paso
+    ui_replay_slider_step->blockSignals(true);
+    ui_replay_slider_step->setValue(step);
+    ui_replay_slider_step->blockSignals(false);
+
+    statusBar()->show();
+    statusBar()->showMessage(QString("Step %1/%2  ").arg(step).arg(ui_replay_slider_step->maximum()) + message);
+}
+
+void VisMainWindow::visReplayFinished()
+{
+    ui_replay_button_play->setText("play");
+}
+
+void VisMainWindow::visReplayClose()
+{
+    environment->tracePlayer()->close();
+    ui_replay_toolbar->hide();
+    statusBar()->hide();
+}
@@ -16,6 +16,7 @@
 #include <QMessageBox>
 #include <QPushButton>
 #include <QCheckBox>
+#include <QSpinBox>
 #include <Environment.hpp>
 
 class VisMainWindow : public QMainWindow
@@ -47,7 +48,22 @@ private:
     QPushButton*  ui_toolbar_button_step;
     QCheckBox*    ui_toolbar_checkbox_step;
 
+    // Trace replay toolbar, shown while a trace is replayed
+    QToolBar*     ui_replay_toolbar;
+    QPushButton*  ui_replay_button_back;
+    QPushButton*  ui_replay_button_play;
+    QPushButton*  ui_replay_button_forward;
+    QSlider*      ui_replay_slider_step;
+    QLabel*       ui_replay_label_speed;
+    QSpinBox*     ui_replay_spinbox_speed;
+    QPushButton*  ui_replay_button_close;
+
     // Actions
+    QAction* ui_action_open;
+    QAction* ui_action_save;
+    QAction* ui_action_import;
+    QAction* ui_action_export;
+    QAction* ui_action_render_image;
     QAction* ui_action_exit;
     QAction* ui_action_delete_selection;
     QAction* ui_action_clean_graph;
@@ -63,6 +79,13 @@ private:
     QAction* ui_action_run_ford_fulkerson;
     QAction* ui_action_run_min_cost_negative_cycles;
     QAction* ui_action_run_min_cost_shortests_paths;
+    QAction* ui_action_stop_algorithm;
+    QAction* ui_action_record_traces;
+    QAction* ui_action_replay_trace;
+    QAction* ui_action_open_trace;
+    QAction* ui_action_save_trace;
+    QAction* ui_action_export_frames;
+    QAction* ui_action_write_results;
     QAction* ui_action_help;
     QAction* ui_action_info;
 
@@ -73,12 +96,30 @@ private:
 
 public slots:
     void visSetGraphType(int);
+    void visOpenDocument();
+    void visSaveDocument();
+    void visImportGraph();
+    void visExportGraph();
+    void visRenderImage();
     void visExitApplication();
     void visShowHelp();
     void visShowInfo();
     void visStepDone();
     void visStepWait(QString);
     void visShowMessage(QString);
+    void visAlgorithmStarted(int);
+    void visAlgorithmFinished(int, int);
+    void visTraceRecorded();
+    void visReplayTrace();
+    void visOpenTrace();
+    void visSaveTrace();
+    void visExportFrames();
+    void visWriteResults(bool);
+    void visRestoreSession();
+    void visReplayPlay();
+    void visReplayStep(int, QString);
+    void visReplayFinished();
+    void visReplayClose();
 };
 
 #endif // VISMAINWINDOW_HPP
@@ -1,7 +1,7 @@
 #include "VisMinimumCostConstantFlowNC.hpp"
 #include <QHBoxLayout>
 
-VisMinimumCostConstantFlowNC::VisMinimumCostConstantFlowNC(QList<int> ids, QWidget *parent)
+VisMinimumCostConstantFlowNC::VisMinimumCostConstantFlowNC(const QVector<int>& ids, QWidget *parent)
     : QDialog(parent)
 {
     setWindowTitle("Floyd Warshall");
@@ -11,22 +11,17 @@ VisMinimumCostConstantFlowNC::VisMinimumCostConstantFlowNC(QList<int> ids, QWidg
     ui_description->setText("Obtain the desired flow for the network with minimum cost detecting negative cycles.");
 
     ui_sources_label = new QLabel("Sources:");
-    ui_sources = new QListWidget;
+    ui_sources = new VisVertexPicker(ids, true);
     ui_sources_layout = new QVBoxLayout;
     ui_sources_layout->addWidget(ui_sources_label);
     ui_sources_layout->addWidget(ui_sources);
 
     ui_sinks_label = new QLabel("Sinks:");
-    ui_sinks = new QListWidget;
+    ui_sinks = new VisVertexPicker(ids, true);
     ui_sinks_layout = new QVBoxLayout;
     ui_sinks_layout->addWidget(ui_sinks_label);
     ui_sinks_layout->addWidget(ui_sinks);
 
-    foreach(int id, ids){
-        ui_sources->addItem(QString::number(id));
-        ui_sinks->addItem(QString::number(id));
-    }
-
     ui_options_layout = new QHBoxLayout;
     ui_options_layout->addLayout(ui_sources_layout);
     ui_options_layout->addLayout(ui_sinks_layout);
@@ -46,6 +41,13 @@ VisMinimumCostConstantFlowNC::VisMinimumCostConstantFlowNC(QList<int> ids, QWidg
     connect(ui_buttons, SIGNAL(accepted()), this, SLOT(accept()));
     connect(ui_buttons, SIGNAL(rejected()), this, SLOT(reject()));
 
+    // Sin fuentes o sumideros elegidos no hay con que ejecutar el algoritmo
+    connect(ui_sources, SIGNAL(visSelectionChanged()),
+            this, SLOT(visUpdateButtons()));
+    connect(ui_sinks, SIGNAL(visSelectionChanged()),
+            this, SLOT(visUpdateButtons()));
+    visUpdateButtons();
+
     ui_layout = new QVBoxLayout;
     ui_layout->addWidget(ui_description);
     ui_layout->addStretch();
@@ -67,16 +69,17 @@ int VisMinimumCostConstantFlowNC::exec()
 {
     int response = QDialog::exec();
 
-    foreach(QListWidgetItem* li, ui_sources->selectedItems()){
-        sources.append(li->text().toInt());
-    }
-
-    foreach(QListWidgetItem* li, ui_sinks->selectedItems()){
-        sinks.append(li->text().toInt());
-    }
+    sources = ui_sources->selectedIds();
+    sinks   = ui_sinks->selectedIds();
 
     constant = ui_constant->value();
 
 
     return response;
 }
+
+void VisMinimumCostConstantFlowNC::visUpdateButtons()
+{
+    ui_buttons->button(QDialogButtonBox::Ok)->setEnabled(ui_sources->hasSelection() and
+                                                        ui_sinks->hasSelection());
+}
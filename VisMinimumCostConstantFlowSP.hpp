@@ -10,7 +10,7 @@
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QDialogButtonBox>
-#include <QListWidget>
+#include <VisVertexPicker.hpp>
 #include <QDoubleSpinBox>
 #include <QCheckBox>
 
@@ -19,7 +19,7 @@ class VisMinimumCostConstantFlowSP : public QDialog
     Q_OBJECT
 
 public:
-    VisMinimumCostConstantFlowSP(QList<int> ids, QWidget* parent = 0);
+    VisMinimumCostConstantFlowSP(const QVector<int>& ids, QWidget* parent = 0);
     ~VisMinimumCostConstantFlowSP();
 
     int exec();
@@ -38,9 +38,9 @@ private:
     QLabel* ui_sinks_label;
     QLabel* ui_constant_label;
 
-    QListWidget*    ui_sources;
-    QListWidget*    ui_sinks;
-    QDoubleSpinBox* ui_constant;
+    VisVertexPicker* ui_sources;
+    VisVertexPicker* ui_sinks;
+    QDoubleSpinBox*  ui_constant;
 
     QVBoxLayout* ui_sources_layout;
     QVBoxLayout* ui_sinks_layout;
@@ -50,6 +50,9 @@ private:
     QList<int> sources;
     QList<int> sinks;
     double constant;
+
+private slots:
+    void visUpdateButtons();
 };
 
 #endif // VISMinimumCostConstantFlowSP_HPP
@@ -1,4 +1,7 @@
 #include "VisNode.hpp"
+#include "VisBezierCurve.hpp"
+#include "VisTextCache.hpp"
+#include "VisGraphicsScene.hpp"
 
 #include <QBrush>
 #include <QPainter>
@@ -6,18 +9,25 @@
 #include <QStyleOptionGraphicsItem>
 #include <QGraphicsSceneContextMenuEvent>
 #include <QMenu>
+#include <QGraphicsScene>
+
+VIS_POOL_ALLOCATED_IMPL(VisNode)
 
 VisNode::VisNode(int id_, double x, double y, QString label_text, QGraphicsItem* parent)
-    : QGraphicsEllipseItem(parent), is_highlighted(false), highlight_color(QColor(255,255,255))
+    : QGraphicsEllipseItem(parent), label(NULL), is_highlighted(false), highlight_color(QColor(255,255,255))
 {
     setFlag(QGraphicsItem::ItemIsMovable, true);
     setFlag(QGraphicsItem::ItemIsSelectable, true);
+    setFlag(QGraphicsItem::ItemSendsGeometryChanges, true);
     setRect(0,0,w,h);
     setZValue(20);
     setBrush(QBrush(QColor(255,255,255)));
     id = id_;
+    id_text = VisTextCache::number(id);
+    if(label_text != "")
+        label = new VisLabel(label_text);
     setPos(x, y);
-    label = new VisLabel(label_text);
+    updateAttachments();
 }
 
 VisNode::~VisNode()
@@ -48,11 +58,76 @@ void VisNode::set_unhighlighted()
     is_highlighted = false;
 }
 
-void VisNode::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+void VisNode::attach(VisBezierCurve* curve)
+{
+    curves.append(curve);
+}
+
+void VisNode::detach(VisBezierCurve* curve)
+{
+    curves.removeOne(curve);
+}
+
+void VisNode::forgetAttachments()
+{
+    label = NULL;
+    curves.clear();
+}
+
+VisLabel* VisNode::ensureLabel()
+{
+    if(label == NULL){
+        label = new VisLabel("");
+        if(scene() != NULL)
+            scene()->addItem(label);
+        label->setAnchor(QPointF(pos().x()+w/2.0, pos().y()));
+    }
+    return label;
+}
+
+void VisNode::setLabelText(const QString& text)
+{
+    if(label == NULL and text == "")
+        return;
+    ensureLabel()->setText(text);
+}
+
+QString VisNode::labelText() const
 {
-    if(isSelected()){
-        label->setSelected(true);
+    if(label == NULL)
+        return QString("");
+    return label->toPlainText();
+}
+
+void VisNode::updateAttachments()
+{
+    if(label != NULL){
+        label->setAnchor(QPointF(pos().x()+w/2.0, pos().y()));
+    }
+    foreach(VisBezierCurve* curve, curves){
+        curve->nodeMoved(this);
     }
+}
+
+QVariant VisNode::itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant &value)
+{
+    switch(change){
+    case QGraphicsItem::ItemPositionHasChanged:
+        updateAttachments();
+        break;
+    case QGraphicsItem::ItemSelectedHasChanged:
+        if(value.toBool() and label != NULL){
+            label->setSelected(true);
+        }
+        break;
+    default:
+        break;
+    }
+    return QGraphicsEllipseItem::itemChange(change, value);
+}
+
+void VisNode::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, QWidget* widget)
+{
     if(is_highlighted == true){
         QPainterPath path;
         path.addEllipse(QPointF(w/2.0, h/2.0), 2*w/3, 2*h/3);
@@ -61,7 +136,8 @@ void VisNode::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, Q
     painter->setPen(this->pen());
     painter->setBrush(this->brush());
     painter->drawEllipse(rect());
-    painter->drawText(boundingRect(),QString::number(id),QTextOption(Qt::AlignCenter));
+    QSizeF text_size = id_text.size();
+    painter->drawStaticText(QPointF((w-text_size.width())/2.0, (h-text_size.height())/2.0), id_text);
     if (option->state & QStyle::State_Selected){
         painter->setPen(QPen(QColor(127,127,127), 0, Qt::DashLine));
         painter->setBrush(Qt::NoBrush);
@@ -69,15 +145,14 @@ void VisNode::paint(QPainter* painter, const QStyleOptionGraphicsItem* option, Q
 
         path.addEllipse(QPointF(w/2.0, h/2.0), 2*w/3, 2*h/3);
         painter->drawPath(path);
-        label->setSelected(true);
-    }
-    if(label != NULL){
-        double lh = label->boundingRect().height()+6;
-        double lw = label->boundingRect().width()/2.0;
-        label->setPos(pos().x()-lw+w/2.0, pos().y()-lh);
     }
 }
 
+void VisNode::mouseDoubleClickEvent(QGraphicsSceneMouseEvent *)
+{
+    ensureLabel()->setTextInteraction(true, true);
+}
+
 void VisNode::contextMenuEvent(QGraphicsSceneContextMenuEvent *event)
 {
     QMenu menu;
@@ -108,4 +183,8 @@ void VisNode::contextMenuEvent(QGraphicsSceneContextMenuEvent *event)
 
     }
     update();
+
+    VisGraphicsScene* vis_scene = dynamic_cast<VisGraphicsScene*>(scene());
+    if(vis_scene != NULL)
+        vis_scene->visTrackHighlight(this);
 }
@@ -5,7 +5,11 @@
 #include <QGraphicsEllipseItem>
 
 // Member
+#include <QStaticText>
 #include "VisLabel.hpp"
+#include "VisItemPool.hpp"
+
+class VisBezierCurve;
 
 class VisNode : public QGraphicsEllipseItem
 {
@@ -17,22 +21,43 @@ public:
 
     int type() const {return Type;}
 
+    // Allocated from VisItemPool
+    VIS_POOL_ALLOCATED
+
     QRectF boundingRect() const;
     QPainterPath shape() const;
     void paint(QPainter*, const QStyleOptionGraphicsItem*, QWidget*);
 
     void contextMenuEvent(QGraphicsSceneContextMenuEvent *);
+    void mouseDoubleClickEvent(QGraphicsSceneMouseEvent *);
+
+    QVariant itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant &value);
+
+    // Curves that follow this node when it moves
+    void attach(VisBezierCurve* curve);
+    void detach(VisBezierCurve* curve);
+    // Drop references to other items, used before the scene deletes them all
+    void forgetAttachments();
+    void updateAttachments();
+
+    // The label is created the first time it gets some text
+    VisLabel* ensureLabel();
+    void setLabelText(const QString& text);
+    QString labelText() const;
 
     const static int w = 30;
     const static int h = 30;
 
     VisLabel* label;
 
+    QList<VisBezierCurve*> curves;
+
     void set_highlight(int,int,int,int);
     void set_unhighlighted();
 
     // external id
     int id;
+    QStaticText id_text;
     bool is_highlighted;
     QColor highlight_color;
 };
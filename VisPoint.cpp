@@ -1,11 +1,16 @@
 #include "VisPoint.hpp"
+#include "VisBezierCurve.hpp"
 
 #include <QBrush>
 
+VIS_POOL_ALLOCATED_IMPL(VisPoint)
+
 VisPoint::VisPoint(double x, double y, QGraphicsItem* parent)
+    : QGraphicsEllipseItem(parent), curve(NULL)
 {
     setFlag(QGraphicsItem::ItemIsMovable, true);
     setFlag(QGraphicsItem::ItemIsSelectable, true);
+    setFlag(QGraphicsItem::ItemSendsGeometryChanges, true);
     setRect(x,y,w,h);
     setZValue(30);
     setBrush(QBrush(QColor(0,127,0,127)));
@@ -15,3 +20,11 @@ QPointF VisPoint::vis_pos()
 {
     return (pos()+QPointF(w/2.0, h/2.0));
 }
+
+QVariant VisPoint::itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant &value)
+{
+    if(change == QGraphicsItem::ItemPositionHasChanged and curve != NULL){
+        curve->ctrlMoved();
+    }
+    return QGraphicsEllipseItem::itemChange(change, value);
+}
@@ -3,6 +3,10 @@
 
 #include <QGraphicsEllipseItem>
 
+#include "VisItemPool.hpp"
+
+class VisBezierCurve;
+
 class VisPoint : public QGraphicsEllipseItem
 {
 public:
@@ -10,10 +14,20 @@ public:
 
     VisPoint(double x, double y, QGraphicsItem* parent = 0);
 
+    int type() const {return Type;}
+
+    // Allocated from VisItemPool
+    VIS_POOL_ALLOCATED
+
     QPointF vis_pos();
 
+    QVariant itemChange(QGraphicsItem::GraphicsItemChange change, const QVariant &value);
+
     const static int w = 10;
     const static int h = 10;
+
+    // Curve notified when the point is dragged
+    VisBezierCurve* curve;
 };
 
 #endif // VISPOINT_HPP
@@ -6,17 +6,17 @@
 
 // Member classes
 #include <QLabel>
-#include <QComboBox>
 #include <QVBoxLayout>
 #include <QHBoxLayout>
 #include <QDialogButtonBox>
+#include <VisVertexPicker.hpp>
 
 class VisPrim : public QDialog
 {
     Q_OBJECT
 
 public:
-    VisPrim(QList<int> ids, QWidget* parent = 0);
+    VisPrim(const QVector<int>& ids, QWidget* parent = 0);
     ~VisPrim();
 
     int exec();
@@ -25,7 +25,7 @@ public:
 
 private:
     QVBoxLayout* ui_layout;
-    QComboBox* ui_select;
+    VisVertexPicker* ui_select;
     QLabel* ui_description;
     QDialogButtonBox* ui_buttons;
 
@@ -33,6 +33,9 @@ private:
     QHBoxLayout* ui_select_layout;
 
     int root_vertex;
+
+private slots:
+    void visUpdateButtons();
 };
 
 #endif // VISPRIM_HPP
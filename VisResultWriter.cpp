@@ -0,0 +1,417 @@
+#include "VisResultWriter.hpp"
+
+#include <QFileInfo>
+#include <QtNumeric>
+
+#include <cstring>
+#include <cstdlib>
+
+// Foreign language includes
+#include <libguile.h>
+
+#define SCM_DEFUNC(NAME, ARGS, PROC) scm_c_define_gsubr(NAME, ARGS, 0, 0, ((scm_t_subr) PROC ))
+
+static const char result_magic[4] = {'S', 'G', 'V', 'R'};
+
+static quint64 aligned(quint64 offset)
+{
+    return (offset+7) & ~quint64(7);
+}
+
+static int sizeOf(VisResultWriter::TYPE type)
+{
+    return type == VisResultWriter::DOUBLE ? sizeof(double) : sizeof(qint32);
+}
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Class procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+VisResultWriter::VisResultWriter()
+    : format(CSV), rows(0), column(0), row(0), data(NULL)
+{
+}
+
+VisResultWriter::~VisResultWriter()
+{
+    close();
+}
+
+VisResultWriter::FORMAT VisResultWriter::formatOf(const QString& path)
+{
+    return QFileInfo(path).suffix().toLower() == "sgr" ? COLUMNS : CSV;
+}
+
+bool VisResultWriter::open(const QString& path, const QList<Column>& columns, quint64 rows, bool mapped)
+{
+    close();
+
+    this->format  = formatOf(path);
+    this->columns = columns;
+    this->rows    = rows;
+    column = 0;
+    row    = 0;
+    error  = "";
+
+    file.setFileName(path);
+    if(not file.open(QIODevice::ReadWrite | QIODevice::Truncate)){
+        error = file.errorString();
+        return false;
+    }
+
+    if(format == CSV){
+        QList<QByteArray> names;
+        foreach(const Column& c, columns)
+            names.append(c.name);
+        buffer = names.join(',') + '\n';
+        return true;
+    }
+
+    // Las columnas quedan una tras otra, cada una alineada a 8 bytes
+    quint64 offset = aligned(sizeof(VisResultHeader) + columns.size()*sizeof(VisResultColumnHeader));
+    QByteArray header(offset, 0);
+    VisResultHeader* h = (VisResultHeader*) header.data();
+    memcpy(h->magic, result_magic, sizeof(result_magic));
+    h->byte_order   = byte_order;
+    h->version      = version;
+    h->column_count = columns.size();
+    h->row_count    = rows;
+
+    column_offsets.resize(columns.size());
+    column_buffers.resize(columns.size());
+    for(int i = 0; i < columns.size(); i++){
+        VisResultColumnHeader* c = ((VisResultColumnHeader*) (h+1)) + i;
+        strncpy(c->name, columns[i].name.constData(), sizeof(c->name)-1);
+        c->type   = columns[i].type;
+        c->offset = offset;
+        column_offsets[i] = offset;
+        column_buffers[i].reserve(buffer_size);
+        offset = aligned(offset + rows*sizeOf(columns[i].type));
+    }
+
+    if(not file.resize(offset) or file.write(header) != header.size()){
+        error = file.errorString();
+        file.close();
+        return false;
+    }
+    // Si no se puede mapear se sigue con los buffers
+    if(mapped and offset > 0)
+        data = file.map(0, offset);
+    return true;
+}
+
+void VisResultWriter::writeInt(qint32 value)
+{
+    if(format == CSV){
+        QByteArray text = QByteArray::number(value);
+        cell(text.constData(), text.size());
+    }else if(columns[column].type == DOUBLE){
+        writeDouble(value);
+    }else{
+        cell((const char*) &value, sizeof(value));
+    }
+}
+
+void VisResultWriter::writeDouble(double value)
+{
+    if(format == CSV){
+        // 17 digitos bastan para leer de vuelta el mismo double
+        QByteArray text = QByteArray::number(value, 'g', 17);
+        cell(text.constData(), text.size());
+    }else if(columns[column].type == INT32){
+        writeInt((qint32) value);
+    }else{
+        cell((const char*) &value, sizeof(value));
+    }
+}
+
+void VisResultWriter::cell(const char* bytes, int size)
+{
+    if(not file.isOpen() or (format == COLUMNS and row >= rows))
+        return;
+
+    if(format == CSV){
+        if(column > 0)
+            buffer.append(',');
+        buffer.append(bytes, size);
+        if(column == columns.size()-1)
+            buffer.append('\n');
+        if(buffer.size() >= buffer_size){
+            if(file.write(buffer) != buffer.size() and error.isEmpty())
+                error = file.errorString();
+            buffer.clear();
+        }
+    }else if(data != NULL){
+        memcpy(data + column_offsets[column] + row*size, bytes, size);
+    }else{
+        column_buffers[column].append(bytes, size);
+        if(column_buffers[column].size() >= buffer_size)
+            flush(column);
+    }
+
+    if(++column == columns.size()){
+        column = 0;
+        row++;
+    }
+}
+
+bool VisResultWriter::flush(int index)
+{
+    QByteArray& pending = column_buffers[index];
+    if(pending.isEmpty())
+        return true;
+    bool ok = file.seek(column_offsets[index]) and file.write(pending) == pending.size();
+    if(not ok and error.isEmpty())
+        error = file.errorString();
+    column_offsets[index] += pending.size();
+    pending.clear();
+    return ok;
+}
+
+bool VisResultWriter::close()
+{
+    if(not file.isOpen())
+        return error.isEmpty();
+
+    if(format == CSV){
+        if(file.write(buffer) != buffer.size() and error.isEmpty())
+            error = file.errorString();
+    }else if(data != NULL){
+        file.unmap(data);
+    }else{
+        for(int i = 0; i < column_buffers.size(); i++)
+            flush(i);
+    }
+    file.close();
+
+    buffer.clear();
+    column_buffers.clear();
+    column_offsets.clear();
+    data = NULL;
+    return error.isEmpty();
+}
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Foreign language procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+
+// Los vertices sin numero, como los auxiliares de los algoritmos, y los
+// predecesores vacios se escriben como -1
+static qint32 vertexOf(SCM v)
+{
+    return scm_is_signed_integer(v, -2147483647, 2147483647) ? scm_to_int32(v) : -1;
+}
+
+static double valueOf(SCM x)
+{
+    return scm_is_real(x) ? scm_to_double(x) : qQNaN();
+}
+
+static QString pathOf(SCM path)
+{
+    char* text = scm_to_utf8_string(path);
+    QString result = QString::fromUtf8(text);
+    free(text);
+    return result;
+}
+
+static SCM failureOf(const VisResultWriter& writer)
+{
+    return scm_from_utf8_string(writer.errorString().toUtf8().constData());
+}
+
+// Lo que se lanzo mientras se escribian las filas
+struct VisResultThrow
+{
+    SCM key;
+    SCM args;
+};
+
+static SCM rowsThrown(void* data, SCM key, SCM args)
+{
+    VisResultThrow* thrown = (VisResultThrow*) data;
+    thrown->key  = key;
+    thrown->args = args;
+    return SCM_UNSPECIFIED;
+}
+
+// Las filas llaman a Scheme con el escritor abierto; un error o la
+// cancelacion del trabajo se atrapan aqui para no saltar sus destructores
+static void writeRows(scm_t_catch_body body, void* rows, VisResultThrow* thrown)
+{
+    scm_internal_catch(SCM_BOOL_T, body, rows, rowsThrown, thrown);
+}
+
+// Se lanza de nuevo lo atrapado, o el error del escritor, cuando este ya
+// cerro su archivo y no queda ningun objeto de C++ que el salto se salte;
+// el archivo a medias de una escritura interrumpida se elimina
+static void throwIfFailed(const char* name, const VisResultThrow& thrown, SCM failure)
+{
+    if(scm_is_true(thrown.key))
+        scm_throw(thrown.key, thrown.args);
+    if(scm_is_true(failure))
+        scm_misc_error(name, "~A", scm_list_1(failure));
+}
+
+struct VisMatrixRows
+{
+    VisResultWriter* writer;
+    size_t n;
+    SCM ids;
+    SCM distances;
+    SCM predecessors;
+};
+
+static SCM matrixRows(void* data)
+{
+    VisMatrixRows* rows = (VisMatrixRows*) data;
+    for(size_t i = 0; i < rows->n; i++){
+        qint32 source = vertexOf(scm_c_vector_ref(rows->ids, i));
+        SCM distance_row    = scm_c_vector_ref(rows->distances, i);
+        SCM predecessor_row = scm_c_vector_ref(rows->predecessors, i);
+        for(size_t j = 0; j < rows->n; j++){
+            rows->writer->writeInt(source);
+            rows->writer->writeInt(vertexOf(scm_c_vector_ref(rows->ids, j)));
+            rows->writer->writeDouble(valueOf(scm_c_vector_ref(distance_row, j)));
+            rows->writer->writeInt(vertexOf(scm_c_vector_ref(predecessor_row, j)));
+        }
+    }
+    return SCM_UNSPECIFIED;
+}
+
+static SCM scmWriteMatrices(SCM path, SCM ids, SCM distances, SCM predecessors, SCM mapped)
+{
+    VisResultThrow thrown = {SCM_BOOL_F, SCM_EOL};
+    SCM failure = SCM_BOOL_F;
+    size_t n = scm_c_vector_length(ids);
+    {
+        QString file = pathOf(path);
+        QList<VisResultWriter::Column> columns;
+        columns << VisResultWriter::Column("source",      VisResultWriter::INT32)
+                << VisResultWriter::Column("target",      VisResultWriter::INT32)
+                << VisResultWriter::Column("distance",    VisResultWriter::DOUBLE)
+                << VisResultWriter::Column("predecessor", VisResultWriter::INT32);
+
+        VisResultWriter writer;
+        if(writer.open(file, columns, quint64(n)*n, scm_is_true(mapped))){
+            VisMatrixRows rows = {&writer, n, ids, distances, predecessors};
+            writeRows(matrixRows, &rows, &thrown);
+        }
+        if(not writer.close())
+            failure = failureOf(writer);
+        if(scm_is_true(thrown.key))
+            QFile::remove(file);
+    }
+    throwIfFailed("cpp-write-matrices!", thrown, failure);
+    return SCM_UNSPECIFIED;
+}
+
+struct VisTreeRows
+{
+    VisResultWriter* writer;
+    SCM vertices;
+    SCM predecessor;
+    SCM distance;
+};
+
+static SCM treeRows(void* data)
+{
+    VisTreeRows* rows = (VisTreeRows*) data;
+    for(SCM rest = rows->vertices; scm_is_pair(rest); rest = scm_cdr(rest)){
+        SCM v = scm_car(rest);
+        rows->writer->writeInt(vertexOf(v));
+        rows->writer->writeInt(vertexOf(scm_call_1(rows->predecessor, v)));
+        rows->writer->writeDouble(valueOf(scm_call_1(rows->distance, v)));
+    }
+    return SCM_UNSPECIFIED;
+}
+
+static SCM scmWriteTree(SCM path, SCM vertices, SCM predecessor, SCM distance, SCM mapped)
+{
+    VisResultThrow thrown = {SCM_BOOL_F, SCM_EOL};
+    SCM failure = SCM_BOOL_F;
+    {
+        QString file = pathOf(path);
+        QList<VisResultWriter::Column> columns;
+        columns << VisResultWriter::Column("vertex",      VisResultWriter::INT32)
+                << VisResultWriter::Column("predecessor", VisResultWriter::INT32)
+                << VisResultWriter::Column("distance",    VisResultWriter::DOUBLE);
+
+        VisResultWriter writer;
+        if(writer.open(file, columns, scm_ilength(vertices), scm_is_true(mapped))){
+            VisTreeRows rows = {&writer, vertices, predecessor, distance};
+            writeRows(treeRows, &rows, &thrown);
+        }
+        if(not writer.close())
+            failure = failureOf(writer);
+        if(scm_is_true(thrown.key))
+            QFile::remove(file);
+    }
+    throwIfFailed("cpp-write-tree!", thrown, failure);
+    return SCM_UNSPECIFIED;
+}
+
+struct VisFlowRows
+{
+    VisResultWriter* writer;
+    SCM items;
+    SCM flow;
+    SCM cost;
+};
+
+static SCM flowRows(void* data)
+{
+    VisFlowRows* rows = (VisFlowRows*) data;
+    for(SCM rest = rows->items; scm_is_pair(rest); rest = scm_cdr(rest)){
+        // Un arco (u v) o un par (arco . flujo)
+        SCM item = scm_car(rest);
+        SCM arc  = scm_is_pair(scm_car(item)) ? scm_car(item) : item;
+        rows->writer->writeInt(vertexOf(scm_car(arc)));
+        rows->writer->writeInt(vertexOf(scm_cadr(arc)));
+        rows->writer->writeDouble(valueOf(scm_call_1(rows->flow, item)));
+        if(scm_is_true(rows->cost))
+            rows->writer->writeDouble(valueOf(scm_call_1(rows->cost, item)));
+    }
+    return SCM_UNSPECIFIED;
+}
+
+static SCM scmWriteFlows(SCM path, SCM items, SCM flow, SCM cost, SCM mapped)
+{
+    VisResultThrow thrown = {SCM_BOOL_F, SCM_EOL};
+    SCM failure = SCM_BOOL_F;
+    {
+        QString file = pathOf(path);
+        QList<VisResultWriter::Column> columns;
+        columns << VisResultWriter::Column("source", VisResultWriter::INT32)
+                << VisResultWriter::Column("target", VisResultWriter::INT32)
+                << VisResultWriter::Column("flow",   VisResultWriter::DOUBLE);
+        if(scm_is_true(cost))
+            columns << VisResultWriter::Column("cost", VisResultWriter::DOUBLE);
+
+        VisResultWriter writer;
+        if(writer.open(file, columns, scm_ilength(items), scm_is_true(mapped))){
+            VisFlowRows rows = {&writer, items, flow, cost};
+            writeRows(flowRows, &rows, &thrown);
+        }
+        if(not writer.close())
+            failure = failureOf(writer);
+        if(scm_is_true(thrown.key))
+            QFile::remove(file);
+    }
+    throwIfFailed("cpp-write-flows!", thrown, failure);
+    return SCM_UNSPECIFIED;
+}
+
+void VisResultWriter::defineProcedures()
+{
+    SCM_DEFUNC("cpp-write-matrices!", 5, scmWriteMatrices);
+    SCM_DEFUNC("cpp-write-tree!", 5,     scmWriteTree);
+    SCM_DEFUNC("cpp-write-flows!", 5,    scmWriteFlows);
+}
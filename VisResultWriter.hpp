@@ -0,0 +1,93 @@
+#ifndef VISRESULTWRITER_HPP
+#define VISRESULTWRITER_HPP
+
+#include <QFile>
+#include <QList>
+#include <QVector>
+#include <QString>
+#include <QByteArray>
+
+// Fixed size header of a columnar result file, followed by column_count
+// descriptors. Each column is an array of row_count values starting at an
+// 8 byte boundary, written in native byte order like the documents.
+struct VisResultHeader
+{
+    char    magic[4];
+    quint32 byte_order;
+    quint32 version;
+    quint32 column_count;
+    quint64 row_count;
+};
+
+struct VisResultColumnHeader
+{
+    char    name[16];
+    quint32 type;
+    quint32 reserved;
+    quint64 offset;
+};
+
+// Writes the tables of an algorithm run cell by cell, in row order, while
+// the algorithm walks its own vectors and attributes; no Scheme list of
+// rows is built. CSV goes through a buffer flushed every buffer_size bytes.
+// The columnar format (.sgr) knows its size from the row count, each column
+// is either buffered and written at its offset or, when mapped, stored
+// straight into the mapped file.
+class VisResultWriter
+{
+public:
+    enum FORMAT {CSV, COLUMNS};
+    enum TYPE {INT32, DOUBLE};
+
+    struct Column
+    {
+        QByteArray name;
+        TYPE       type;
+
+        Column(const QByteArray& name_ = QByteArray(), TYPE type_ = INT32)
+            : name(name_), type(type_) {}
+    };
+
+    const static quint32 version     = 1;
+    const static quint32 byte_order  = 0x01020304;
+    const static int     buffer_size = 1 << 16;
+
+    VisResultWriter();
+    ~VisResultWriter();
+
+    // .sgr is columnar, anything else CSV
+    static FORMAT formatOf(const QString& path);
+
+    // The columnar format needs the row count up front, CSV ignores it
+    bool open(const QString& path, const QList<Column>& columns, quint64 rows, bool mapped);
+    void writeInt(qint32 value);
+    void writeDouble(double value);
+    bool close();
+    QString errorString() const { return error; }
+
+    // cpp-write-matrices!, cpp-write-tree! and cpp-write-flows!, shared by
+    // the environment and batch mode
+    static void defineProcedures();
+
+private:
+    QFile         file;
+    FORMAT        format;
+    QList<Column> columns;
+    quint64       rows;
+    QString       error;
+
+    // Cell about to be written
+    int     column;
+    quint64 row;
+
+    // CSV text, or the pending values and file offset of each column
+    QByteArray          buffer;
+    QVector<QByteArray> column_buffers;
+    QVector<quint64>    column_offsets;
+    uchar*              data;
+
+    void cell(const char* bytes, int size);
+    bool flush(int index);
+};
+
+#endif // VISRESULTWRITER_HPP
@@ -0,0 +1,272 @@
+#include "VisSchemeExecutor.hpp"
+
+#include <QtDebug>
+
+static SCM cancel_key   = SCM_BOOL_F;
+static SCM cancel_async = SCM_BOOL_F;
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Foreign language procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+
+static QString scmDescribe(SCM obj)
+{
+    char* str = scm_to_locale_string(scm_object_to_string(obj, SCM_UNDEFINED));
+    QString description(str);
+    free(str);
+    return description;
+}
+
+static VisSchemeWorker* currentWorker()
+{
+    return dynamic_cast<VisSchemeWorker*>(QThread::currentThread());
+}
+
+// Async marked in a worker when its job is cancelled
+static SCM scmCancelPoint()
+{
+    VisSchemeExecutor::throwIfCancelled();
+    return SCM_UNSPECIFIED;
+}
+
+static void* workerEntry(void* data)
+{
+    ((VisSchemeWorker*) data)->loop();
+    return NULL;
+}
+
+// Se bloquea fuera del modo Guile para no detener al recolector
+static void* waitForJob(void* data)
+{
+    return ((VisSchemeWorker*) data)->takeJob();
+}
+
+static SCM evalJob(void* data)
+{
+    // Sin temporales: un throw sale de aqui con longjmp
+    VisSchemeJob* job = (VisSchemeJob*) data;
+    return scm_c_eval_string(job->code.constData());
+}
+
+static SCM jobThrown(void* data, SCM key, SCM args)
+{
+    int* status = (int*) data;
+    if(scm_is_eq(key, cancel_key)){
+        *status = VisSchemeExecutor::CANCELLED;
+    }else{
+        *status = VisSchemeExecutor::FAILED;
+        qWarning() << "Scheme job failed:" << scmDescribe(scm_cons(key, args));
+    }
+    return SCM_UNSPECIFIED;
+}
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Worker
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+VisSchemeWorker::VisSchemeWorker(VisSchemeExecutor* executor)
+    : executor(executor), job(NULL), thread(SCM_BOOL_F)
+{
+}
+
+void VisSchemeWorker::run()
+{
+    scm_with_guile(workerEntry, this);
+}
+
+VisSchemeJob* VisSchemeWorker::takeJob()
+{
+    return executor->takeJob(this);
+}
+
+void VisSchemeWorker::loop()
+{
+    scm_set_current_module(executor->module);
+
+    executor->mutex.lock();
+    thread = scm_current_thread();
+    executor->mutex.unlock();
+
+    VisSchemeJob* next;
+    while((next = (VisSchemeJob*) scm_without_guile(waitForJob, this))){
+        int id     = next->id;
+        int status = VisSchemeExecutor::FINISHED;
+
+        emit executor->visJobStarted(id);
+        scm_internal_catch(SCM_BOOL_T, evalJob, next, jobThrown, &status);
+        executor->finishJob(this);
+        emit executor->visJobFinished(id, status);
+    }
+}
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Executor
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+VisSchemeExecutor::VisSchemeExecutor(SCM module, int count, QObject* parent)
+    : QObject(parent)
+{
+    this->module  = scm_gc_protect_object(module);
+    shutting_down = false;
+    next_id       = 0;
+
+    if(scm_is_false(cancel_key)){
+        cancel_key   = scm_permanent_object(scm_from_locale_symbol("vis-job-cancelled"));
+        cancel_async = scm_permanent_object(scm_c_make_gsubr("vis-job-cancel-point", 0, 0, 0,
+                                                             (scm_t_subr) scmCancelPoint));
+    }
+
+    for(int i = 0; i < count; i++){
+        VisSchemeWorker* worker = new VisSchemeWorker(this);
+        workers.append(worker);
+        worker->start();
+    }
+}
+
+VisSchemeExecutor::~VisSchemeExecutor()
+{
+    mutex.lock();
+    shutting_down = true;
+    qDeleteAll(jobs);
+    jobs.clear();
+    foreach(VisSchemeWorker* worker, workers){
+        if(worker->job){
+            worker->job->cancelled.store(1);
+            interrupt(worker);
+        }
+    }
+    job_available.wakeAll();
+    mutex.unlock();
+
+    foreach(VisSchemeWorker* worker, workers){
+        if(not worker->wait(shutdown_timeout)){
+            qWarning() << "Scheme worker did not stop, terminating it";
+            worker->terminate();
+            worker->wait();
+        }
+        delete worker;
+    }
+
+    scm_gc_unprotect_object(module);
+}
+
+int VisSchemeExecutor::submit(QString code)
+{
+    VisSchemeJob* job = new VisSchemeJob;
+    job->code = code.toUtf8();
+    job->cancelled.store(0);
+
+    QMutexLocker locker(&mutex);
+    job->id = next_id++;
+    jobs.enqueue(job);
+    job_available.wakeOne();
+    return job->id;
+}
+
+void VisSchemeExecutor::cancel(int id)
+{
+    bool dequeued = false;
+
+    mutex.lock();
+    for(int i = 0; i < jobs.size(); i++){
+        if(jobs[i]->id == id){
+            delete jobs.takeAt(i);
+            dequeued = true;
+            break;
+        }
+    }
+    foreach(VisSchemeWorker* worker, workers){
+        if(worker->job and worker->job->id == id){
+            worker->job->cancelled.store(1);
+            interrupt(worker);
+        }
+    }
+    mutex.unlock();
+
+    // Los trabajos en ejecucion avisan ellos mismos al terminar
+    if(dequeued)
+        emit visJobFinished(id, CANCELLED);
+}
+
+void VisSchemeExecutor::cancelAll()
+{
+    QList<int> dequeued;
+
+    mutex.lock();
+    while(not jobs.isEmpty()){
+        VisSchemeJob* job = jobs.dequeue();
+        dequeued.append(job->id);
+        delete job;
+    }
+    foreach(VisSchemeWorker* worker, workers){
+        if(worker->job){
+            worker->job->cancelled.store(1);
+            interrupt(worker);
+        }
+    }
+    mutex.unlock();
+
+    foreach(int id, dequeued)
+        emit visJobFinished(id, CANCELLED);
+}
+
+int VisSchemeExecutor::pendingJobs()
+{
+    QMutexLocker locker(&mutex);
+    int pending = jobs.size();
+    foreach(VisSchemeWorker* worker, workers){
+        if(worker->job)
+            pending++;
+    }
+    return pending;
+}
+
+bool VisSchemeExecutor::cancelRequested()
+{
+    // El trabajo de un hilo solo lo cambia ese mismo hilo
+    VisSchemeWorker* worker = currentWorker();
+    return worker and worker->job and worker->job->cancelled.load();
+}
+
+void VisSchemeExecutor::throwIfCancelled()
+{
+    if(cancelRequested())
+        scm_throw(cancel_key, SCM_EOL);
+}
+
+VisSchemeJob* VisSchemeExecutor::takeJob(VisSchemeWorker* worker)
+{
+    QMutexLocker locker(&mutex);
+    while(jobs.isEmpty() and not shutting_down)
+        job_available.wait(&mutex);
+
+    if(shutting_down)
+        return NULL;
+
+    worker->job = jobs.dequeue();
+    return worker->job;
+}
+
+void VisSchemeExecutor::finishJob(VisSchemeWorker* worker)
+{
+    QMutexLocker locker(&mutex);
+    delete worker->job;
+    worker->job = NULL;
+}
+
+void VisSchemeExecutor::interrupt(VisSchemeWorker* worker)
+{
+    // Interrumpe tambien el codigo que nunca llama a cpp-wait!
+    if(scm_is_true(worker->thread))
+        scm_system_async_mark_for_thread(cancel_async, worker->thread);
+}
@@ -0,0 +1,91 @@
+#ifndef VISSCHEMEEXECUTOR_HPP
+#define VISSCHEMEEXECUTOR_HPP
+
+// Parent class
+#include <QObject>
+#include <QThread>
+
+// Member classes
+#include <QList>
+#include <QQueue>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+// Foreign language includes
+#include <libguile.h>
+
+class VisSchemeExecutor;
+
+// Scheme code waiting for or being evaluated by a worker
+struct VisSchemeJob
+{
+    int        id;
+    QByteArray code;
+    QAtomicInt cancelled;
+};
+
+// Thread registered in Guile once, evaluates the jobs of its executor one
+// after another until the executor is destroyed
+class VisSchemeWorker : public QThread
+{
+public:
+    VisSchemeWorker(VisSchemeExecutor* executor);
+
+    void run();
+    void loop();
+    VisSchemeJob* takeJob();
+
+    VisSchemeExecutor* executor;
+    VisSchemeJob*      job;
+    SCM                thread;
+};
+
+// Queue of Scheme jobs evaluated by a fixed set of worker threads. A job is
+// cancelled at its next cpp-wait! call or, if it never waits, at the next
+// point where Guile runs asyncs in its worker.
+class VisSchemeExecutor : public QObject
+{
+    Q_OBJECT
+
+public:
+    enum STATUS {FINISHED, CANCELLED, FAILED};
+
+    VisSchemeExecutor(SCM module, int count = 1, QObject* parent = 0);
+    ~VisSchemeExecutor();
+
+    int  submit(QString code);
+    void cancel(int id);
+    void cancelAll();
+
+    // Queued plus running jobs
+    int pendingJobs();
+
+    // True inside a worker whose job has been cancelled
+    static bool cancelRequested();
+    static void throwIfCancelled();
+
+    const static unsigned long shutdown_timeout = 2000;
+
+signals:
+    void visJobStarted(int id);
+    void visJobFinished(int id, int status);
+
+private:
+    friend class VisSchemeWorker;
+
+    SCM module;
+
+    QList<VisSchemeWorker*> workers;
+    QQueue<VisSchemeJob*>   jobs;
+    QMutex                  mutex;
+    QWaitCondition          job_available;
+    bool                    shutting_down;
+    int                     next_id;
+
+    VisSchemeJob* takeJob(VisSchemeWorker* worker);
+    void finishJob(VisSchemeWorker* worker);
+    void interrupt(VisSchemeWorker* worker);
+};
+
+#endif // VISSCHEMEEXECUTOR_HPP
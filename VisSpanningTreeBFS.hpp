@@ -6,16 +6,16 @@
 
 // Member classes
 #include <QLabel>
-#include <QComboBox>
 #include <QVBoxLayout>
 #include <QDialogButtonBox>
+#include <VisVertexPicker.hpp>
 
 class VisSpanningTreeBFS : public QDialog
 {
     Q_OBJECT
 
 public:
-    VisSpanningTreeBFS(QList<int> ids, QWidget* parent = 0);
+    VisSpanningTreeBFS(const QVector<int>& ids, QWidget* parent = 0);
     ~VisSpanningTreeBFS();
 
     int exec();
@@ -24,11 +24,14 @@ public:
 
 private:
     QVBoxLayout* ui_layout;
-    QComboBox* ui_select;
+    VisVertexPicker* ui_select;
     QLabel* ui_description;
     QDialogButtonBox* ui_buttons;
 
     int root_vertex;
+
+private slots:
+    void visUpdateButtons();
 };
 
 #endif // VISSPANNINGTREEBFS_HPP
@@ -1,7 +1,7 @@
 #include "VisSpanningTreeDFS.hpp"
 #include <QHBoxLayout>
 
-VisSpanningTreeDFS::VisSpanningTreeDFS(QList<int> ids, QWidget *parent)
+VisSpanningTreeDFS::VisSpanningTreeDFS(const QVector<int>& ids, QWidget *parent)
     : QDialog(parent)
 {
     setWindowTitle("Spanning Tree DFS");
@@ -10,13 +10,10 @@ VisSpanningTreeDFS::VisSpanningTreeDFS(QList<int> ids, QWidget *parent)
     ui_description->setWordWrap(true);
     ui_description->setText("Obtain a Spanning Tree using a Depth First Search.");
 
-    ui_select = new QComboBox;
-    foreach(int id, ids){
-        ui_select->addItem(QString::number(id));
-    }
+    ui_select = new VisVertexPicker(ids, false);
 
     QLabel* ui_select_label = new QLabel("Root vertex:");
-    ui_select_label->setAlignment(Qt::AlignVCenter | Qt::AlignRight);
+    ui_select_label->setAlignment(Qt::AlignTop | Qt::AlignRight);
 
     QHBoxLayout* ui_select_layout = new QHBoxLayout;
     ui_select_layout->addWidget(ui_select_label);
@@ -29,6 +26,11 @@ VisSpanningTreeDFS::VisSpanningTreeDFS(QList<int> ids, QWidget *parent)
     connect(ui_buttons, SIGNAL(accepted()), this, SLOT(accept()));
     connect(ui_buttons, SIGNAL(rejected()), this, SLOT(reject()));
 
+    // Sin vertice elegido no hay con que ejecutar el algoritmo
+    connect(ui_select, SIGNAL(visSelectionChanged()),
+            this, SLOT(visUpdateButtons()));
+    visUpdateButtons();
+
     ui_layout = new QVBoxLayout;
     ui_layout->addWidget(ui_description);
     ui_layout->addStretch();
@@ -48,7 +50,12 @@ VisSpanningTreeDFS::~VisSpanningTreeDFS()
 int VisSpanningTreeDFS::exec()
 {
     int response = QDialog::exec();
-    root_vertex = ui_select->currentText().toInt();
+    root_vertex = ui_select->selectedId();
 
     return response;
 }
+
+void VisSpanningTreeDFS::visUpdateButtons()
+{
+    ui_buttons->button(QDialogButtonBox::Ok)->setEnabled(ui_select->hasSelection());
+}
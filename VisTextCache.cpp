@@ -0,0 +1,51 @@
+#include "VisTextCache.hpp"
+
+QThreadStorage<VisTextCache::Cache*> VisTextCache::caches;
+
+VisTextCache::Cache& VisTextCache::cache()
+{
+    // QThreadStorage elimina el cache cuando termina su hilo
+    if(not caches.hasLocalData())
+        caches.setLocalData(new Cache);
+    return *caches.localData();
+}
+
+QStaticText VisTextCache::layout(const QString& str)
+{
+    QStaticText static_text(str);
+    static_text.setTextFormat(Qt::PlainText);
+    return static_text;
+}
+
+QStaticText VisTextCache::text(const QString& str)
+{
+    // El menos usado recientemente sale cuando el cache esta lleno
+    QCache<QString, QStaticText>& texts = cache().texts;
+    QStaticText* cached = texts.object(str);
+    if(cached != NULL)
+        return *cached;
+
+    QStaticText static_text = layout(str);
+    texts.insert(str, new QStaticText(static_text));
+    return static_text;
+}
+
+QStaticText VisTextCache::number(int n)
+{
+    if(n < 0 or n >= max_numbers)
+        return layout(QString::number(n));
+
+    // Un texto nulo es un id que aun no se vio
+    QVector<QStaticText>& numbers = cache().numbers;
+    if(n >= numbers.size())
+        numbers.resize(qMin(int(max_numbers), qMax(n+1, 2*numbers.size())));
+    if(numbers[n].text().isEmpty())
+        numbers[n] = layout(QString::number(n));
+    return numbers[n];
+}
+
+void VisTextCache::clear()
+{
+    cache().texts.clear();
+    cache().numbers.clear();
+}
@@ -0,0 +1,43 @@
+#ifndef VISTEXTCACHE_HPP
+#define VISTEXTCACHE_HPP
+
+#include <QCache>
+#include <QVector>
+#include <QString>
+#include <QStaticText>
+#include <QThreadStorage>
+
+// Cache of laid out strings. Node ids and labels are short strings that
+// repeat a lot, so their glyph layout is computed only once. Each thread
+// has its own cache: a QStaticText updates its layout when drawn and can
+// not be shared by scenes rendered in different threads.
+//
+// Labels are kept in an LRU of max_entries strings. Ids are unique, so they
+// do not go through it: ids below max_numbers, the usual ones since they
+// are given in order, are kept by value and never evicted.
+class VisTextCache
+{
+public:
+    static QStaticText text(const QString& str);
+    static QStaticText number(int n);
+
+    static void clear();
+
+    const static int max_entries = 4096;
+    const static int max_numbers = 1 << 16;
+
+private:
+    struct Cache
+    {
+        QCache<QString, QStaticText> texts;
+        QVector<QStaticText>         numbers;
+
+        Cache() : texts(max_entries) {}
+    };
+
+    static QThreadStorage<Cache*> caches;
+    static Cache& cache();
+    static QStaticText layout(const QString& str);
+};
+
+#endif // VISTEXTCACHE_HPP
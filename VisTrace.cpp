@@ -0,0 +1,619 @@
+#include "VisTrace.hpp"
+
+#include <QSaveFile>
+#include <QFile>
+#include <QBuffer>
+#include <QDataStream>
+#include <QHash>
+#include <QtEndian>
+
+#include <cstring>
+
+#include "VisGraphicsScene.hpp"
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Encoding procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+static void putVarint(QByteArray& out, quint32 value)
+{
+    while(value >= 0x80){
+        out.append(char(value | 0x80));
+        value >>= 7;
+    }
+    out.append(char(value));
+}
+
+// False when the value would run past limit, in a damaged trace
+static bool getVarint(const char*& p, const char* limit, quint32* value)
+{
+    quint32 result = 0;
+    for(int shift = 0; p < limit and shift < 35; shift += 7){
+        quint8 byte = *p++;
+        result |= quint32(byte & 0x7f) << shift;
+        if(not (byte & 0x80)){
+            *value = result;
+            return true;
+        }
+    }
+    return false;
+}
+
+// Control points of a curve seen from its other end
+static void reverseCtrl(double* ctrl)
+{
+    qSwap(ctrl[0], ctrl[2]);
+    qSwap(ctrl[1], ctrl[3]);
+}
+
+// Small differences of either sign take one byte
+static quint32 zigzag(qint32 value)
+{
+    return (quint32(value) << 1) ^ quint32(value >> 31);
+}
+
+static qint32 unzigzag(quint32 value)
+{
+    return qint32(value >> 1) ^ -qint32(value & 1);
+}
+
+static void putDouble(QByteArray& out, double value)
+{
+    quint64 bits;
+    memcpy(&bits, &value, sizeof(bits));
+    bits = qToLittleEndian(bits);
+    out.append((const char*) &bits, sizeof(bits));
+}
+
+static bool getDouble(const char*& p, const char* limit, double* value)
+{
+    quint64 bits;
+    if(limit-p < (qptrdiff) sizeof(bits))
+        return false;
+    memcpy(&bits, p, sizeof(bits));
+    bits = qFromLittleEndian(bits);
+    p += sizeof(bits);
+    memcpy(value, &bits, sizeof(*value));
+    return true;
+}
+
+static bool hasPair(VisChange::KIND kind)
+{
+    switch(kind){
+    case VisChange::PAINT_NODE:
+    case VisChange::UNPAINT_NODE:
+    case VisChange::LABEL_NODE:
+    case VisChange::COLOR_NODE:
+    case VisChange::UNCOLOR_NODE:
+    case VisChange::COLOR_NODE_LABEL:
+    case VisChange::UNCOLOR_NODE_LABEL:
+    case VisChange::CLEAR_GRAPH:
+        return false;
+    default:
+        return true;
+    }
+}
+
+static bool hasColor(VisChange::KIND kind)
+{
+    return kind == VisChange::COLOR_NODE or kind == VisChange::COLOR_EDGE or
+           kind == VisChange::COLOR_ARROW or kind == VisChange::COLOR_NODE_LABEL or
+           kind == VisChange::COLOR_EDGE_LABEL or kind == VisChange::COLOR_ARROW_LABEL;
+}
+
+static bool hasText(VisChange::KIND kind)
+{
+    return kind == VisChange::LABEL_NODE or kind == VisChange::LABEL_EDGE or
+           kind == VisChange::LABEL_ARROW;
+}
+
+static QByteArray imageOf(const VisDocumentContent& content)
+{
+    QByteArray image;
+    QBuffer buffer(&image);
+    buffer.open(QIODevice::WriteOnly);
+    VisDocument::write(&buffer, content);
+    return image;
+}
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Class procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+VisTrace::VisTrace()
+    : recording(false), is_directed(false), last_aid(0), next_id(0)
+{
+}
+
+void VisTrace::begin(VisGraphicsScene* scene)
+{
+    VisDocumentContent content = VisDocument::contentOf(scene);
+
+    QMutexLocker locker(&mutex);
+    blocks.clear();
+    nodes.clear();
+    curves.clear();
+    is_directed = content.directed;
+    next_id     = content.next_id;
+
+    // El modelo parte del mismo documento que sera el primer keyframe
+    quint32 n = content.ids.size();
+    for(quint32 i = 0; i < n; i++){
+        Node node;
+        node.x           = content.positions[2*i];
+        node.y           = content.positions[2*i+1];
+        node.flags       = content.node_flags[i];
+        node.color       = content.node_colors[i];
+        node.label_color = content.node_label_colors[i];
+        node.label       = QString::fromUtf8(content.label_data.constData()+content.label_offsets[i],
+                                             content.label_offsets[i+1]-content.label_offsets[i]);
+        nodes.insert(content.ids[i], node);
+    }
+    for(quint32 i = 0; i < n; i++){
+        for(quint32 e = content.rows[i]; e < content.rows[i+1]; e++){
+            Curve curve;
+            memcpy(curve.ctrl, content.ctrl_points.constData()+4*e, sizeof(curve.ctrl));
+            curve.flags       = content.edge_flags[e];
+            curve.color       = content.edge_colors[e];
+            curve.label_color = content.edge_label_colors[e];
+            curve.label       = QString::fromUtf8(content.label_data.constData()+content.label_offsets[n+e],
+                                                  content.label_offsets[n+e+1]-content.label_offsets[n+e]);
+            // Los puntos quedan en el orden de la clave, el de los keyframes
+            int aid = content.ids[i];
+            int bid = content.ids[content.targets[e]];
+            if(key(aid, bid).first != aid)
+                reverseCtrl(curve.ctrl);
+            curves.insert(key(aid, bid), curve);
+        }
+    }
+
+    current = Block();
+    current.first_step = 0;
+    current.keyframe   = qCompress(imageOf(content));
+    encoded.clear();
+    last_aid  = 0;
+    recording = true;
+}
+
+void VisTrace::record(const VisChange& change)
+{
+    QMutexLocker locker(&mutex);
+    if(not recording)
+        return;
+    encode(change);
+    apply(change);
+}
+
+void VisTrace::step(const QString& message)
+{
+    QMutexLocker locker(&mutex);
+    if(not recording)
+        return;
+
+    // Cada paso se decodifica desde su inicio, los ids vuelven a ser
+    // relativos a 0
+    current.step_ends.append(encoded.size());
+    current.messages.append(message);
+    last_aid = 0;
+    if(current.step_ends.size() >= keyframe_interval or encoded.size() >= max_block_size)
+        closeBlock();
+}
+
+void VisTrace::end()
+{
+    QMutexLocker locker(&mutex);
+    if(not recording)
+        return;
+
+    // Lo dibujado despues del ultimo paso forma uno mas; un bloque recien
+    // abierto y vacio se descarta, el anterior ya termina en ese estado
+    quint32 stepped = current.step_ends.isEmpty() ? 0 : current.step_ends.last();
+    if((quint32) encoded.size() > stepped or blocks.isEmpty()){
+        current.step_ends.append(encoded.size());
+        current.messages.append("Finished");
+    }
+    if(not current.step_ends.isEmpty()){
+        current.changes = qCompress(encoded);
+        blocks.append(current);
+    }
+    current = Block();
+    encoded.clear();
+    nodes.clear();
+    curves.clear();
+    recording = false;
+}
+
+bool VisTrace::isRecording()
+{
+    QMutexLocker locker(&mutex);
+    return recording;
+}
+
+int VisTrace::stepCount() const
+{
+    if(blocks.isEmpty())
+        return 0;
+    return lastStep(blocks.size()-1)+1;
+}
+
+int VisTrace::lastStep(int block) const
+{
+    return blocks[block].first_step+blocks[block].step_ends.size();
+}
+
+QString VisTrace::message(int step) const
+{
+    if(step <= 0 or blocks.isEmpty())
+        return QString("");
+    const Block& block = blocks[blockOf(step-1)];
+    return block.messages.value(step-block.first_step-1);
+}
+
+int VisTrace::blockOf(int step) const
+{
+    int low = 0;
+    int high = blocks.size()-1;
+    while(low < high){
+        int middle = (low+high+1)/2;
+        if(blocks[middle].first_step <= step)
+            low = middle;
+        else
+            high = middle-1;
+    }
+    return low;
+}
+
+QByteArray VisTrace::keyframe(int block) const
+{
+    return qUncompress(blocks[block].keyframe);
+}
+
+QByteArray VisTrace::blockChanges(int block) const
+{
+    return qUncompress(blocks[block].changes);
+}
+
+VisChangeSet VisTrace::changes(int block, const QByteArray& data, int from, int to) const
+{
+    const Block& b = blocks[block];
+    quint32 begin = from > b.first_step ? b.step_ends[from-b.first_step-1] : 0;
+    begin = qMin(begin, (quint32) data.size());
+    quint32 end   = to > b.first_step ? b.step_ends[to-b.first_step-1] : 0;
+
+    VisChangeSet result;
+    const char* p     = data.constData()+begin;
+    const char* limit = data.constData()+qMin(end, (quint32) data.size());
+    int aid = 0;
+    int step = from;
+    while(p < limit){
+        // Los ids de cada paso son relativos a 0
+        int index = step-b.first_step;
+        if(index < b.step_ends.size() and p-data.constData() >= (qptrdiff) b.step_ends[index]){
+            aid = 0;
+            step++;
+            continue;
+        }
+
+        // Un archivo dañado puede pasar qUncompress, se decodifica hasta
+        // el primer valor que no cabe en el bloque
+        quint8 head = *p++;
+        VisChange change((VisChange::KIND) (head & 0x3f));
+        change.with_curves = head & 0x40;
+        if(change.kind > VisChange::CLEAR_GRAPH)
+            break;
+        quint32 value;
+        if(change.kind != VisChange::CLEAR_GRAPH){
+            if(not getVarint(p, limit, &value))
+                break;
+            aid += unzigzag(value);
+            change.aid = aid;
+        }
+        if(hasPair(change.kind)){
+            if(not getVarint(p, limit, &value))
+                break;
+            change.bid = aid+unzigzag(value);
+        }
+        if(change.kind == VisChange::PAINT_NODE){
+            if(not getDouble(p, limit, &change.x) or not getDouble(p, limit, &change.y))
+                break;
+        }
+        if(hasColor(change.kind)){
+            if(not getVarint(p, limit, &value))
+                break;
+            change.color = QColor::fromRgba(value);
+        }
+        if(hasText(change.kind)){
+            quint32 length;
+            if(not getVarint(p, limit, &length) or length > quint32(limit-p))
+                break;
+            change.text = QString::fromUtf8(p, length);
+            p += length;
+        }
+        result.append(change);
+    }
+    return result;
+}
+
+bool VisTrace::save(const QString& path, QString* error) const
+{
+    QSaveFile out(path);
+    if(not out.open(QIODevice::WriteOnly)){
+        *error = out.errorString();
+        return false;
+    }
+
+    QDataStream stream(&out);
+    stream.setVersion(QDataStream::Qt_5_3);
+    stream << magic << version << is_directed << (qint32) blocks.size();
+    foreach(const Block& block, blocks)
+        stream << (qint32) block.first_step << block.step_ends << block.messages
+               << block.keyframe << block.changes;
+
+    if(stream.status() != QDataStream::Ok)
+        out.cancelWriting();
+    if(not out.commit()){
+        *error = out.errorString();
+        return false;
+    }
+    return true;
+}
+
+bool VisTrace::open(const QString& path, QString* error)
+{
+    QFile in(path);
+    if(not in.open(QIODevice::ReadOnly)){
+        *error = in.errorString();
+        return false;
+    }
+
+    QDataStream stream(&in);
+    stream.setVersion(QDataStream::Qt_5_3);
+    quint32 file_magic, file_version;
+    qint32 count;
+    bool file_directed;
+    stream >> file_magic >> file_version;
+    if(file_magic != magic){
+        *error = "Not an algorithm trace";
+        return false;
+    }
+    if(file_version != version){
+        *error = QString("Unsupported trace version %1").arg(file_version);
+        return false;
+    }
+    stream >> file_directed >> count;
+
+    QList<Block> read;
+    for(qint32 i = 0; i < count and stream.status() == QDataStream::Ok; i++){
+        Block block;
+        qint32 first_step;
+        stream >> first_step >> block.step_ends >> block.messages >> block.keyframe >> block.changes;
+        block.first_step = first_step;
+        if(block.step_ends.isEmpty() or block.messages.size() != block.step_ends.size() or
+           (not read.isEmpty() and first_step != read.last().first_step+read.last().step_ends.size()))
+            break;
+        read.append(block);
+    }
+    if(stream.status() != QDataStream::Ok or read.size() != count or count == 0){
+        *error = "Damaged algorithm trace";
+        return false;
+    }
+
+    QMutexLocker locker(&mutex);
+    recording   = false;
+    is_directed = file_directed;
+    blocks      = read;
+    return true;
+}
+
+VisTrace::Key VisTrace::key(int aid, int bid) const
+{
+    // Las aristas no dirigidas se guardan una sola vez
+    if(not is_directed and bid < aid)
+        return Key(bid, aid);
+    return Key(aid, bid);
+}
+
+void VisTrace::encode(const VisChange& change)
+{
+    encoded.append(char(change.kind | (change.with_curves ? 0x40 : 0)));
+    if(change.kind != VisChange::CLEAR_GRAPH){
+        putVarint(encoded, zigzag(change.aid-last_aid));
+        last_aid = change.aid;
+    }
+    if(hasPair(change.kind))
+        putVarint(encoded, zigzag(change.bid-change.aid));
+    if(change.kind == VisChange::PAINT_NODE){
+        putDouble(encoded, change.x);
+        putDouble(encoded, change.y);
+    }
+    if(hasColor(change.kind))
+        putVarint(encoded, change.color.rgba());
+    if(hasText(change.kind)){
+        QByteArray text = change.text.toUtf8();
+        putVarint(encoded, text.size());
+        encoded.append(text);
+    }
+}
+
+void VisTrace::apply(const VisChange& change)
+{
+    Node* node = NULL;
+    Curve* curve = NULL;
+    if(hasPair(change.kind)){
+        QMap<Key, Curve>::iterator it = curves.find(key(change.aid, change.bid));
+        if(it != curves.end())
+            curve = &it.value();
+    }else if(change.kind != VisChange::CLEAR_GRAPH){
+        QMap<int, Node>::iterator it = nodes.find(change.aid);
+        if(it != nodes.end())
+            node = &it.value();
+    }
+
+    switch(change.kind){
+    case VisChange::PAINT_NODE:{
+        Node painted;
+        painted.x     = change.x;
+        painted.y     = change.y;
+        painted.flags = 0;
+        painted.color = painted.label_color = 0;
+        nodes.insert(change.aid, painted);
+        next_id++;
+        break;
+    }
+    case VisChange::UNPAINT_NODE:{
+        nodes.remove(change.aid);
+        QMap<Key, Curve>::iterator it = curves.begin();
+        while(it != curves.end()){
+            if(it.key().first == change.aid or it.key().second == change.aid)
+                it = curves.erase(it);
+            else
+                ++it;
+        }
+        break;
+    }
+    case VisChange::PAINT_EDGE:
+    case VisChange::PAINT_ARROW:{
+        if(not nodes.contains(change.aid) or not nodes.contains(change.bid))
+            break;
+        // Los mismos puntos de control que VisBezierCurve::resetCtrlPoints
+        const Node& a = nodes[change.aid];
+        const Node& b = nodes[change.bid];
+        double ax = a.x+VisNode::w/2.0, ay = a.y+VisNode::h/2.0;
+        double bx = b.x+VisNode::w/2.0, by = b.y+VisNode::h/2.0;
+        Curve painted;
+        painted.ctrl[0] = ax+(bx-ax)/3.0;
+        painted.ctrl[1] = ay+(by-ay)/3.0;
+        painted.ctrl[2] = ax+2*(bx-ax)/3.0;
+        painted.ctrl[3] = ay+2*(by-ay)/3.0;
+        painted.flags = change.with_curves ? 0 : VisDocument::STRAIGHT;
+        painted.color = painted.label_color = 0;
+        if(key(change.aid, change.bid).first != change.aid)
+            reverseCtrl(painted.ctrl);
+        curves.insert(key(change.aid, change.bid), painted);
+        break;
+    }
+    case VisChange::UNPAINT_EDGE:
+    case VisChange::UNPAINT_ARROW:
+        curves.remove(key(change.aid, change.bid));
+        break;
+    case VisChange::LABEL_NODE:
+        if(node != NULL)
+            node->label = change.text;
+        break;
+    case VisChange::LABEL_EDGE:
+    case VisChange::LABEL_ARROW:
+        if(curve != NULL)
+            curve->label = change.text;
+        break;
+    case VisChange::COLOR_NODE:
+        if(node != NULL){
+            node->flags |= VisDocument::HIGHLIGHTED;
+            node->color  = change.color.rgba();
+        }
+        break;
+    case VisChange::UNCOLOR_NODE:
+        if(node != NULL)
+            node->flags &= ~VisDocument::HIGHLIGHTED;
+        break;
+    case VisChange::COLOR_NODE_LABEL:
+        if(node != NULL){
+            node->flags      |= VisDocument::LABEL_HIGHLIGHTED;
+            node->label_color = change.color.rgba();
+        }
+        break;
+    case VisChange::UNCOLOR_NODE_LABEL:
+        if(node != NULL)
+            node->flags &= ~VisDocument::LABEL_HIGHLIGHTED;
+        break;
+    case VisChange::COLOR_EDGE:
+    case VisChange::COLOR_ARROW:
+        if(curve != NULL){
+            curve->flags |= VisDocument::HIGHLIGHTED;
+            curve->color  = change.color.rgba();
+        }
+        break;
+    case VisChange::UNCOLOR_EDGE:
+    case VisChange::UNCOLOR_ARROW:
+        if(curve != NULL)
+            curve->flags &= ~VisDocument::HIGHLIGHTED;
+        break;
+    case VisChange::COLOR_EDGE_LABEL:
+    case VisChange::COLOR_ARROW_LABEL:
+        if(curve != NULL){
+            curve->flags      |= VisDocument::LABEL_HIGHLIGHTED;
+            curve->label_color = change.color.rgba();
+        }
+        break;
+    case VisChange::UNCOLOR_EDGE_LABEL:
+    case VisChange::UNCOLOR_ARROW_LABEL:
+        if(curve != NULL)
+            curve->flags &= ~VisDocument::LABEL_HIGHLIGHTED;
+        break;
+    case VisChange::CLEAR_GRAPH:
+        nodes.clear();
+        curves.clear();
+        break;
+    }
+}
+
+void VisTrace::closeBlock()
+{
+    current.changes = qCompress(encoded);
+    blocks.append(current);
+
+    int first_step = lastStep(blocks.size()-1);
+    current = Block();
+    current.first_step = first_step;
+    current.keyframe   = qCompress(imageOf(content()));
+    encoded.clear();
+}
+
+VisDocumentContent VisTrace::content() const
+{
+    VisDocumentContent content;
+    quint32 n = nodes.size();
+    quint32 m = curves.size();
+    content.directed = is_directed;
+    content.next_id  = next_id;
+    content.resize(n, m);
+
+    QHash<int, quint32> index;
+    index.reserve(n);
+    quint32 i = 0;
+    for(QMap<int, Node>::const_iterator it = nodes.constBegin(); it != nodes.constEnd(); ++it, i++){
+        const Node& node = it.value();
+        index.insert(it.key(), i);
+        content.ids[i]               = it.key();
+        content.positions[2*i]       = node.x;
+        content.positions[2*i+1]     = node.y;
+        content.node_flags[i]        = node.flags;
+        content.node_colors[i]       = node.color;
+        content.node_label_colors[i] = node.label_color;
+        content.label_offsets.append(content.label_data.size());
+        content.label_data.append(node.label.toUtf8());
+    }
+
+    // Las curvas estan ordenadas por su primer vertice, ya en orden CSR
+    quint32 e = 0;
+    for(QMap<Key, Curve>::const_iterator it = curves.constBegin(); it != curves.constEnd(); ++it, e++){
+        const Curve& curve = it.value();
+        content.rows[index.value(it.key().first)+1]++;
+        content.targets[e] = index.value(it.key().second);
+        memcpy(content.ctrl_points.data()+4*e, curve.ctrl, sizeof(curve.ctrl));
+        content.edge_flags[e]        = curve.flags;
+        content.edge_colors[e]       = curve.color;
+        content.edge_label_colors[e] = curve.label_color;
+        content.label_offsets.append(content.label_data.size());
+        content.label_data.append(curve.label.toUtf8());
+    }
+    content.label_offsets.append(content.label_data.size());
+    for(quint32 k = 0; k < n; k++)
+        content.rows[k+1] += content.rows[k];
+    return content;
+}
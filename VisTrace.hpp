@@ -0,0 +1,122 @@
+#ifndef VISTRACE_HPP
+#define VISTRACE_HPP
+
+#include <QList>
+#include <QMap>
+#include <QPair>
+#include <QVector>
+#include <QString>
+#include <QStringList>
+#include <QByteArray>
+#include <QMutex>
+#include <QColor>
+#include <VisChangeSet.hpp>
+#include <VisDocument.hpp>
+
+class VisGraphicsScene;
+
+// Drawing calls of an algorithm run and the step messages between them.
+//
+// The run is split in blocks of at most keyframe_interval steps. Each block
+// starts with a keyframe, the whole graph at its first step written as a
+// document image, followed by its changes delta-encoded: ids relative to
+// the previous change, the other end of an edge relative to the first.
+// Keyframes and changes are compressed once the block is complete, so
+// reaching a step only decodes the block that holds it.
+//
+// Step 0 is the graph when recording began, step s the graph when the s-th
+// cpp-wait! or cpp-show-message! was called; the last step is the graph
+// when recording ended.
+class VisTrace
+{
+public:
+    const static int  keyframe_interval = 32;
+    // Changes encoded before a block is closed early, bounds the work of a
+    // seek in runs with few and large steps
+    const static int  max_block_size    = 1 << 20;
+    const static quint32 magic          = 0x54564753; // "SGVT"
+    const static quint32 version        = 1;
+
+    VisTrace();
+
+    // Called in the GUI thread, the trace starts from the scene as it is
+    void begin(VisGraphicsScene* scene);
+    // Called by the thread that draws, ignored when not recording
+    void record(const VisChange& change);
+    void step(const QString& message);
+    void end();
+    bool isRecording();
+    bool isEmpty() const { return blocks.isEmpty(); }
+
+    bool    directed() const { return is_directed; }
+    int     stepCount() const;
+    QString message(int step) const;
+
+    // Last block starting at or before a step
+    int        blockOf(int step) const;
+    int        firstStep(int block) const { return blocks[block].first_step; }
+    int        lastStep(int block) const;
+    int        blockCount() const { return blocks.size(); }
+
+    // Decompressed keyframe and changes of a block
+    QByteArray keyframe(int block) const;
+    QByteArray blockChanges(int block) const;
+    // Changes that take the graph from step from to step to, both steps
+    // of the block; data is blockChanges(block)
+    VisChangeSet changes(int block, const QByteArray& data, int from, int to) const;
+
+    bool save(const QString& path, QString* error) const;
+    bool open(const QString& path, QString* error);
+
+private:
+    struct Block
+    {
+        int              first_step;
+        QByteArray       keyframe;
+        QByteArray       changes;
+        // End of each step in the decoded changes, and its message
+        QVector<quint32> step_ends;
+        QStringList      messages;
+    };
+
+    // Graph model kept while recording, only to write the keyframes
+    struct Node
+    {
+        double  x, y;
+        quint8  flags;
+        QRgb    color;
+        QRgb    label_color;
+        QString label;
+    };
+    struct Curve
+    {
+        double  ctrl[4];
+        quint8  flags;
+        QRgb    color;
+        QRgb    label_color;
+        QString label;
+    };
+    typedef QPair<int,int> Key;
+
+    QMutex       mutex;
+    bool         recording;
+    bool         is_directed;
+    QList<Block> blocks;
+
+    // Block being recorded
+    Block      current;
+    QByteArray encoded;
+    int        last_aid;
+
+    QMap<int, Node> nodes;
+    QMap<Key, Curve> curves;
+    qint32 next_id;
+
+    Key  key(int aid, int bid) const;
+    void apply(const VisChange& change);
+    void encode(const VisChange& change);
+    void closeBlock();
+    VisDocumentContent content() const;
+};
+
+#endif // VISTRACE_HPP
@@ -0,0 +1,144 @@
+#include "VisTracePlayer.hpp"
+
+#include "VisTrace.hpp"
+#include "VisGraphicsScene.hpp"
+#include "VisDocument.hpp"
+
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+//// Class procedures
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+///////////////////////////////////////////////////////////////////
+VisTracePlayer::VisTracePlayer(VisGraphicsScene* scene_, QObject* parent)
+    : QObject(parent), scene(scene_), trace(NULL), current(0), speed(2), pending(0), block(-1)
+{
+    timer.setInterval(tick_interval);
+    connect(&timer, SIGNAL(timeout()),
+            this,   SLOT(visTick()));
+}
+
+void VisTracePlayer::setTrace(const VisTrace* trace_)
+{
+    timer.stop();
+    trace   = trace_;
+    current = 0;
+    pending = 0;
+    block   = -1;
+    block_changes.clear();
+    if(trace != NULL and not trace->isEmpty())
+        loadBlock(0);
+}
+
+void VisTracePlayer::close()
+{
+    timer.stop();
+    if(trace != NULL and not trace->isEmpty() and current != 0)
+        loadKeyframe(0);
+    setTrace(NULL);
+}
+
+int VisTracePlayer::stepCount() const
+{
+    return trace == NULL ? 0 : trace->stepCount();
+}
+
+void VisTracePlayer::visPlay()
+{
+    if(trace == NULL or trace->isEmpty())
+        return;
+    if(current >= stepCount()-1)
+        visSeek(0);
+    pending = 0;
+    timer.start();
+}
+
+void VisTracePlayer::visPause()
+{
+    timer.stop();
+}
+
+void VisTracePlayer::visSetSpeed(int steps_per_second)
+{
+    speed = qMax(1, steps_per_second);
+}
+
+void VisTracePlayer::visSeek(int step)
+{
+    if(trace == NULL or trace->isEmpty())
+        return;
+    show(qBound(0, step, stepCount()-1));
+}
+
+void VisTracePlayer::visStepForward()
+{
+    visSeek(current+1);
+}
+
+void VisTracePlayer::visStepBackward()
+{
+    visSeek(current-1);
+}
+
+void VisTracePlayer::visTick()
+{
+    // A velocidades altas un tick muestra varios pasos de una vez
+    pending += speed*tick_interval/1000.0;
+    int steps = (int) pending;
+    if(steps == 0)
+        return;
+    pending -= steps;
+
+    show(qMin(current+steps, stepCount()-1));
+    if(current >= stepCount()-1){
+        timer.stop();
+        emit visPlaybackFinished();
+    }
+}
+
+void VisTracePlayer::loadBlock(int index)
+{
+    if(index == block)
+        return;
+    block = index;
+    block_changes = trace->blockChanges(index);
+}
+
+void VisTracePlayer::loadKeyframe(int index)
+{
+    VisDocument document;
+    if(not document.open(trace->keyframe(index)))
+        return;
+    scene->visClearGraph();
+    scene->visLoadDocument(document);
+    loadBlock(index);
+    current = trace->firstStep(index);
+}
+
+void VisTracePlayer::show(int step)
+{
+    if(step == current)
+        return;
+
+    // Hacia atras, o mas alla del bloque siguiente, se parte del keyframe
+    // mas cercano; si no se siguen aplicando los cambios desde el actual
+    int target_block = trace->blockOf(step);
+    if(step < current or target_block > trace->blockOf(current)+1)
+        loadKeyframe(target_block);
+
+    VisChangeSet changes;
+    while(current < step){
+        // El paso actual puede ser el ultimo de su bloque y el primero del
+        // siguiente, los cambios vienen del bloque que lo continua
+        if(current >= trace->lastStep(block))
+            loadBlock(block+1);
+        int to = qMin(step, trace->lastStep(block));
+        changes += trace->changes(block, block_changes, current, to);
+        current = to;
+    }
+    if(not changes.isEmpty())
+        scene->visApplyChanges(changes);
+
+    emit visStepChanged(current, trace->message(current));
+}
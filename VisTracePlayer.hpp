@@ -0,0 +1,73 @@
+#ifndef VISTRACEPLAYER_HPP
+#define VISTRACEPLAYER_HPP
+
+// Parent class
+#include <QObject>
+
+// Member classes
+#include <QTimer>
+#include <QByteArray>
+
+class VisTrace;
+class VisGraphicsScene;
+
+// Shows the steps of a recorded trace on the scene without running the
+// algorithm. Playing forward applies the changes of each step; seeking
+// backwards, or further than a block ahead, loads the nearest keyframe
+// first. Only the scene changes, G keeps the graph it had.
+class VisTracePlayer : public QObject
+{
+    Q_OBJECT
+
+public:
+    VisTracePlayer(VisGraphicsScene* scene, QObject* parent = 0);
+
+    // The trace must outlive playback, the scene must already show its
+    // first step with its graph type
+    void setTrace(const VisTrace* trace);
+    // Shows the first step again, the graph G has, and drops the trace
+    void close();
+
+    int  step() const { return current; }
+    int  stepCount() const;
+    bool isPlaying() const { return timer.isActive(); }
+    // While a trace is set the scene may show a step other than G
+    bool isActive() const { return trace != NULL; }
+
+    const static int tick_interval = 16;
+
+signals:
+    void visStepChanged(int step, QString message);
+    void visPlaybackFinished();
+
+public slots:
+    void visPlay();
+    void visPause();
+    // Steps per second, several steps are shown in a tick when needed
+    void visSetSpeed(int steps_per_second);
+    void visSeek(int step);
+    void visStepForward();
+    void visStepBackward();
+
+private slots:
+    void visTick();
+
+private:
+    VisGraphicsScene* scene;
+    const VisTrace*   trace;
+    QTimer            timer;
+
+    int    current;
+    int    speed;
+    double pending;
+
+    // Decoded changes of the block holding the current step
+    int        block;
+    QByteArray block_changes;
+
+    void loadBlock(int index);
+    void loadKeyframe(int index);
+    void show(int step);
+};
+
+#endif // VISTRACEPLAYER_HPP
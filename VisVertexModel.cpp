@@ -0,0 +1,47 @@
+#include "VisVertexModel.hpp"
+
+VisVertexModel::VisVertexModel(const QVector<int>& ids, QObject* parent)
+    : QAbstractListModel(parent), all_ids(ids), shown_ids(ids)
+{
+}
+
+int VisVertexModel::rowCount(const QModelIndex& parent) const
+{
+    if(parent.isValid())
+        return 0;
+    return shown_ids.size();
+}
+
+QVariant VisVertexModel::data(const QModelIndex& index, int role) const
+{
+    if(!index.isValid() or index.row() >= shown_ids.size())
+        return QVariant();
+
+    if(role == Qt::DisplayRole)
+        return QString::number(shown_ids[index.row()]);
+    if(role == Qt::UserRole)
+        return shown_ids[index.row()];
+    return QVariant();
+}
+
+int VisVertexModel::idAt(int row) const
+{
+    if(row < 0 or row >= shown_ids.size())
+        return -1;
+    return shown_ids[row];
+}
+
+void VisVertexModel::setFilter(const QString& prefix)
+{
+    beginResetModel();
+    if(prefix.isEmpty()){
+        shown_ids = all_ids;
+    }else{
+        shown_ids.clear();
+        foreach(int id, all_ids){
+            if(QString::number(id).startsWith(prefix))
+                shown_ids.append(id);
+        }
+    }
+    endResetModel();
+}
@@ -0,0 +1,35 @@
+#ifndef VISVERTEXMODEL_HPP
+#define VISVERTEXMODEL_HPP
+
+// Parent class
+#include <QAbstractListModel>
+
+// Member classes
+#include <QVector>
+#include <QString>
+
+// List of vertex ids for the algorithm dialogs. Rows are formatted only when
+// a view asks for them, so opening a dialog does not depend on graph size.
+// The id vector is implicitly shared between the models of one dialog.
+class VisVertexModel : public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+    VisVertexModel(const QVector<int>& ids, QObject* parent = 0);
+
+    int rowCount(const QModelIndex& parent = QModelIndex()) const;
+    QVariant data(const QModelIndex& index, int role = Qt::DisplayRole) const;
+
+    int idAt(int row) const;
+
+public slots:
+    // Keep only the ids whose decimal representation starts with prefix
+    void setFilter(const QString& prefix);
+
+private:
+    QVector<int> all_ids;
+    QVector<int> shown_ids;
+};
+
+#endif // VISVERTEXMODEL_HPP
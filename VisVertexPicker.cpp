@@ -0,0 +1,74 @@
+#include "VisVertexPicker.hpp"
+
+VisVertexPicker::VisVertexPicker(const QVector<int>& ids, bool multiple, QWidget* parent)
+    : QWidget(parent)
+{
+    model = new VisVertexModel(ids, this);
+
+    ui_filter = new QLineEdit;
+    ui_filter->setPlaceholderText("Filter vertices");
+
+    ui_list = new QListView;
+    ui_list->setModel(model);
+    // Todas las filas miden lo mismo, la vista no las recorre para medirlas
+    ui_list->setUniformItemSizes(true);
+    ui_list->setLayoutMode(QListView::Batched);
+    if(multiple){
+        ui_list->setSelectionMode(QAbstractItemView::ExtendedSelection);
+    }else{
+        ui_list->setSelectionMode(QAbstractItemView::SingleSelection);
+        if(model->rowCount() > 0)
+            ui_list->setCurrentIndex(model->index(0));
+    }
+
+    ui_layout = new QVBoxLayout;
+    ui_layout->setContentsMargins(0, 0, 0, 0);
+    ui_layout->addWidget(ui_filter);
+    ui_layout->addWidget(ui_list);
+    setLayout(ui_layout);
+
+    connect(ui_filter, SIGNAL(textChanged(QString)),
+            this,      SLOT(visFilterChanged(QString)));
+    connect(ui_list->selectionModel(), SIGNAL(selectionChanged(QItemSelection,QItemSelection)),
+            this,                      SIGNAL(visSelectionChanged()));
+}
+
+VisVertexPicker::~VisVertexPicker()
+{
+    delete ui_filter;
+    delete ui_list;
+    delete ui_layout;
+}
+
+int VisVertexPicker::selectedId() const
+{
+    QModelIndexList rows = ui_list->selectionModel()->selectedRows();
+    if(rows.isEmpty())
+        return -1;
+    return model->idAt(rows.first().row());
+}
+
+bool VisVertexPicker::hasSelection() const
+{
+    return ui_list->selectionModel()->hasSelection();
+}
+
+QList<int> VisVertexPicker::selectedIds() const
+{
+    QList<int> ids;
+    foreach(const QModelIndex& index, ui_list->selectionModel()->selectedRows()){
+        ids.append(model->idAt(index.row()));
+    }
+    return ids;
+}
+
+void VisVertexPicker::visFilterChanged(const QString& prefix)
+{
+    model->setFilter(prefix.trimmed());
+    if(!ui_list->selectionModel()->hasSelection() and
+       ui_list->selectionMode() == QAbstractItemView::SingleSelection and
+       model->rowCount() > 0)
+        ui_list->setCurrentIndex(model->index(0));
+    // Al reiniciar el modelo la seleccion se pierde sin avisar
+    emit visSelectionChanged();
+}
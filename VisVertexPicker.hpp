@@ -0,0 +1,43 @@
+#ifndef VISVERTEXPICKER_HPP
+#define VISVERTEXPICKER_HPP
+
+// Parent class
+#include <QWidget>
+
+// Member classes
+#include <QLineEdit>
+#include <QListView>
+#include <QVBoxLayout>
+#include <VisVertexModel.hpp>
+
+// Filter box over a list of vertex ids, used by the algorithm dialogs in
+// place of combo boxes and list widgets with one item per vertex
+class VisVertexPicker : public QWidget
+{
+    Q_OBJECT
+
+public:
+    VisVertexPicker(const QVector<int>& ids, bool multiple, QWidget* parent = 0);
+    ~VisVertexPicker();
+
+    // First selected id, or -1 when nothing is selected
+    int selectedId() const;
+    QList<int> selectedIds() const;
+    bool hasSelection() const;
+
+signals:
+    // Also after filtering, which may leave nothing selected
+    void visSelectionChanged();
+
+private:
+    VisVertexModel* model;
+
+    QLineEdit*   ui_filter;
+    QListView*   ui_list;
+    QVBoxLayout* ui_layout;
+
+private slots:
+    void visFilterChanged(const QString& prefix);
+};
+
+#endif // VISVERTEXPICKER_HPP
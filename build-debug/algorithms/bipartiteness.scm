@@ -0,0 +1,58 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; BIPARTITENESS
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+(define-method (run-bipartiteness (g <undirected-graph>))
+  (if (zero? (length (vertices g)))
+      (show-message! "NULL GRAPH can't be an input")
+      (bipartite? g)))
+
+(define-method (bipartite? (g <undirected-graph>))
+  (define (classify! v k)
+    (add-atribute! g v #:class k)
+    (label-vertex! v (obj->string k))
+    (color-vertex! v (if (< k 0) #:green #:blue))
+    (color-vertex-label! v (if (< k 0) #:green #:blue))
+    (wait! "Classify vertex " (obj->string v) " as " (obj->string k)))
+  (define (classified? v) (atribute? g v #:class))
+  (define (class v) (value (atribute g v #:class)))
+  (define is-bipartite? #true)
+  (define q (make-q))
+  (define x (choose (vertices g)))
+
+  (classify! x 1)
+  (enq! q x)
+  (while (not (q-empty? q))
+    (let ((v (deq! q)))
+      (for-each (lambda (u)
+		   (cond ((and (classified? u) (equal? (class v) (class u)))
+			  (color-edge! (list v u) #:red)
+			  (set! is-bipartite? #false)
+			  (wait! "Conflicted edge (" (obj->string v) " " (obj->string u) ")"))
+			 ((not (classified? u))
+			  (color-edge! (list v u) #:yellow)
+			  (classify! u (* -1 (class v)))
+			  (enq! q u))))
+		(adjacent g v)))
+    (when (q-empty? q)
+      (let ((lst (remove classified? (vertices g))))
+	(unless (null? lst)
+	  (classify! (first lst) 1)
+	  (enq! q (first lst))))))
+  (if is-bipartite?
+      (show-message! "The graph is bipartite.")
+      (show-message! "The graph is not bipartite."))
+  (wait!)
+  (for-each (lambda (v)
+	       (uncolor-vertex! v)
+	       (uncolor-vertex-label! v)
+	       (label-vertex! v ""))
+	    (vertices g))
+  (for-each (lambda (e)
+	       (uncolor-edge! e))
+	    (edges g))
+  (remove-vertices-atribute! g #:class)
+  is-bipartite?)
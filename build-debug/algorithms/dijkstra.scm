@@ -0,0 +1,167 @@
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; SHORTEST PATH GENERAL DIJKSTRA
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+(require-algorithm! "heap")
+
+(define-method (run-dijkstra (g <directed-graph>) origin destination)
+  (dijkstra g origin destination #:distance))
+
+(define-method (dijkstra (g <directed-graph>)
+			 origin
+			 destination
+			 (symb <keyword>))
+  (define (mark? x)          (atribute? g x #:mark))
+  (define (distance x)       (value (atribute g x #:distance)))
+  (define (predecessor x)    (value (atribute g x #:predecessor)))
+  (define (mark x)           (value (atribute g x #:mark)))
+  (define (weight x)         (value (atribute g x symb)))
+  (define (distance! x v)    (add-atribute! g x #:distance v))
+  (define (predecessor! x v) (add-atribute! g x #:predecessor v))
+  (define (mark! x v)        (add-atribute! g x #:mark v))
+  (define (-mark! x)         (remove-atribute! g x #:mark))
+
+  (define (better-path? u->v)
+    (define u (from u->v))
+    (define v (to u->v))
+    (< (+ (distance u)
+	  (weight u->v))
+       (distance v)))
+  
+  (define (update-paths! u)
+    (define vs (filter (lambda (x) (equal? (predecessor x) u)) (out-adjacent g u)))
+    (unless (null? vs)
+      (let ((v (first vs)))
+	(predecessor! v u)
+	(distance! v (+ (distance u) (weight (list u v))))
+	(dijkstra-label! v)
+	(update-paths! v))))
+
+  (define (cons-path)
+    (define (acumulate arrow path)
+      (let ((u (from arrow)) (v (to arrow)))
+	(cond ((equal? u origin) (cons (list origin v) path))
+	      (else              (acumulate (list (predecessor u) u) (cons arrow path))))))
+    (acumulate (list (predecessor destination) destination) '()))
+
+  (define (form-negative-cycle new-arrow)
+    (define (acumulate arrow cycle weights)
+      (let ((u (from arrow)) (v (to arrow)))
+	(cond ((equal? u (to new-arrow))
+	       (if (< (+ (weight arrow) (apply + weights)) 0)
+		   (cons arrow cycle)
+		   #false))
+	      ((equal? u origin)
+	       #false)
+	      (else
+	       (acumulate (list (predecessor u) u) (cons arrow cycle) (cons (weight arrow) weights))))))
+    (acumulate new-arrow null null))
+
+  (define (dijkstra-label! v)
+    (label-vertex! v (string-append "[" (obj->string (predecessor v)) "," (obj->string (distance v)) "]")))
+
+  (define vertex-queue (make-heap distance <=))
+  (define arrow-queue  (make-heap weight <=))
+  (define neg-cycl     #false)
+
+  (wait! "Inicia el dijkstra sencillo")
+  (for-each (lambda (v)
+	       (predecessor! v v)
+	       (distance! v (inf))
+	       (dijkstra-label! v))
+	    (vertices g))
+  (predecessor! origin origin)
+  (distance! origin 0)
+  (dijkstra-label! origin)
+  (color-vertex! origin #:yellow)
+  (wait! "Se marca " (obj->string origin) " de manera temporal")
+  (mark! origin 'temporal)
+  (enqueue! vertex-queue origin)
+  (while (not (empty? vertex-queue))
+    (let ((v (dequeue! vertex-queue)))
+      (color-vertex! v #:red)
+      (wait! "Se marca " (obj->string v) " de manera definitiva")
+      (mark! v 'final)
+      (unless (equal? v (predecessor v))
+	(color-arrow! (list (predecessor v) v) #:yellow)
+	(wait! "Se visita " (obj->string (list (predecessor v) v)))
+	(mark! (list (predecessor v) v) 'touched))
+      (for-each (lambda (k)
+		   (cond ((not (mark? k))
+			  (color-vertex! k #:yellow)
+			  (mark! k 'temporal)
+			  (predecessor! k v)
+			  (distance! k (+ (distance v) (weight (list v k))))
+			  (dijkstra-label! k)
+			  (enqueue! vertex-queue k)
+			  (wait! "Se marca " (obj->string k) " de manera temporal"))
+			 ((and (equal? (mark k) 'temporal)
+			       (< (+ (distance v) (weight (list v k)))
+				  (distance k)))
+			  (predecessor! k v)
+			  (distance! k (+ (distance v) (weight (list v k))))
+			  (dijkstra-label! k)
+			  (wait! "Mejora ruta " (obj->string k)))))
+		(out-adjacent g v))))
+  (cond ((mark? destination)
+	 (wait! "Inicia el dijkstra general")
+	 (for-each (lambda (a)
+		      (enqueue! arrow-queue a))
+		   (filter (lambda (a) (not (mark? a))) (arrows g)))
+	 (while (not (empty? arrow-queue))
+	   (let* ((u->v  (dequeue! arrow-queue))
+		  (u     (from u->v))
+		  (v     (to u->v))
+		  (cycle (form-negative-cycle u->v)))
+	     (color-arrow! u->v #:green)
+	     (wait! "Se revisa si " (obj->string u->v) " mejora la ruta sin formar ciclos negativos")
+	     (cond ((and (better-path? u->v)
+			 (not cycle))
+		    (color-arrow! u->v #:yellow)
+		    (wait! "El arco " (obj->string u->v) " si mejora la ruta y no forma ciclos negativos")
+		    (uncolor-arrow! (list (predecessor v) v))
+		    (enqueue! arrow-queue (list (predecessor v) v))
+		    (color-arrow! u->v #:yellow)
+		    (mark! u->v 'touched)
+		    (predecessor! v u)
+		    (distance! v (+ (distance u) (weight u->v)))
+		    (dijkstra-label! v)
+		    (update-paths! v)
+		    (wait! "Se actualiza la mejor ruta"))
+		   ((list? cycle)
+		    (color-arrow! u->v #:red)
+		    (wait! "El arco " (obj->string u->v) " forma un ciclo negativo!")
+		    (set! neg-cycl (list #:negative-cycle cycle (apply + (map weight cycle))))
+		    (purge! arrow-queue))
+		   (else
+		    (wait! "El arco " (obj->string u->v) " no mejora la ruta")
+		    (uncolor-arrow! u->v)))))
+	 (let ((return (if (not neg-cycl) (cons-path) neg-cycl)))
+	   (when (and (result-file) (not neg-cycl))
+	     (write-tree! (vertices g) predecessor distance))
+	   (remove-vertices-atribute! g #:predecessor)
+	   (remove-vertices-atribute! g #:mark)
+	   (remove-arrows-atribute! g #:mark)
+	   (for-each (lambda (v) (label-vertex! v "")) (vertices g))
+	   (if neg-cycl
+	       (begin (show-message! (string-append "Se forma el ciclo negativo = " (obj->string (cadr neg-cycl))
+						    "\n\n el cual reduce la ruta en " (obj->string (caddr neg-cycl))
+						    " cada vez que se recorre."))
+		      (remove-vertices-atribute! g #:distance))
+	       (begin (show-message! (string-append "Se ha encontrado la ruta mas corta = " (obj->string return)
+						    "\n\n la cual tiene una distancia de " (obj->string (distance destination))))
+		      (remove-vertices-atribute! g #:distance)))
+	   return))
+	(else
+	 (when (result-file)
+	   (write-tree! (vertices g) predecessor distance))
+	 (remove-vertices-atribute! g #:predecessor)
+	 (remove-vertices-atribute! g #:distance)
+	 (remove-vertices-atribute! g #:mark)
+	 (remove-arrows-atribute! g #:mark)
+	 (for-each (lambda (v) (label-vertex! v "")) (vertices g))
+	 (show-message! "No existe una trayectoria de " (obj->string origin) " a " (obj->string destination))
+	 (list #:no-path))))
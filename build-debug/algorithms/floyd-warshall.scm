@@ -0,0 +1,111 @@
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ALL SHORTESTS PATHS FLOYD WARSHALL
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+(define (floyd-warshall-results g paths)
+  (for-each (lambda (path)
+	      (let ((origin (first (first path)))
+		    (destination (last (last path))))
+		(show-message! "Mostrando la ruta mas corta de "
+			       (obj->string origin) " a "
+			       (obj->string destination)
+			       " con distancia de "
+			       (obj->string (apply + (map (lambda (e) (value (atribute g e #:distance))) path))))
+		(for-each (lambda (arrow)
+			    (color-arrow! arrow #:blue))
+			  path)
+		(wait!)
+		(for-each (lambda (arrow)
+			    (uncolor-arrow! arrow))
+			  path)))
+	    paths))
+
+(define-method (run-floyd-warshall (g <directed-graph>))
+  (let ((result (floyd-warshall g #:distance)))
+    (cond ((and (pair? result) (equal? (first result) #:negative-cycle))
+	   (show-message! "Se forma el ciclo negativo = " (obj->string (second result))
+			  "\n\n el cual reduce la ruta en " (obj->string (third result))))
+	  ((result-file)
+	   (show-message! "Se escribieron las distancias y predecesores en " (result-file)))
+	  (else
+	   (floyd-warshall-results g result)))))
+
+(define-method (floyd-warshall (G <directed-graph>)
+			       (symb  <keyword>))
+  (define (distance-matrix G)
+    (define n (length (vertices G)))
+    (define M (vector-map (lambda (i x) (make-vector n (inf))) (make-vector n)))
+    (for-each (lambda (x) (vector-set! (vector-ref M x) x 0)) (iota n))
+    (for-each (lambda (a) (let ((u (from a)) (v (to   a))) (vector-set! (vector-ref M (assoc-ref v:i u))
+								   (assoc-ref v:i v)
+								   (value (atribute G a symb)))))
+	      (arrows G))
+    M)
+  (define (predecessor-matrix G)
+    (define n (length (vertices G)))
+    (define M (vector-map (lambda (i x) (make-vector n null)) (make-vector n)))
+    (for-each (lambda (x) (vector-set! (vector-ref M x) x (assoc-ref i:v x))) (iota n))
+    (for-each (lambda (a) (let ((u (from a)) (v (to   a)))
+		       (vector-set! (vector-ref M (assoc-ref v:i u)) (assoc-ref v:i v) u)))
+	      (arrows G))
+    M)
+  (define (matrix-procedure M)
+    (lambda (i j . v)
+      (cond ((null? v)
+	     (vector-ref (vector-ref M i) j))
+	    (else
+	     (vector-set! (vector-ref M i) j (first v))))))
+  (define (path? obj)
+    (list? obj))
+  (define (acumulate-path D PI u v path)
+    (define (acumulate D PI u v path)
+      (cond ((= u v) (cons (assoc-ref i:v v) path))
+	  ((null? (PI u v)) null)
+	  (else (acumulate D PI u (assoc-ref v:i (PI u v)) (cons (assoc-ref i:v v) path)))))
+    (let ((p (acumulate D PI u v path)))
+      (if (null? p) null (map (lambda (u v) (list u v)) p (cdr p)))))
+  (define (cons-neg-cyc D PI i j)
+    (let ((path (acumulate-path D PI i (assoc-ref v:i (PI i j)) (cons (assoc-ref i:v i) null))))
+      (list #:negative-cycle path
+	    (apply + (map (lambda (a) (value (atribute G a symb))) path)))))
+  (define (path-weight D PI path)
+    (D (assoc-ref v:i (first path))
+       (assoc-ref v:i (last path))))
+  (define (cons-all-paths D PI)
+    (remove null? (apply append (map (lambda (u) (map (lambda (v) (acumulate-path D PI u v '())) (iota n))) (iota n)))))
+  (define n  (length (vertices G)))
+  (define i:v (map (lambda (i v) (cons i v)) (iota n) (vertices G)))
+  (define v:i (map (lambda (i v) (cons v i)) (iota n) (vertices G)))
+  (define DM (distance-matrix G))
+  (define PM (predecessor-matrix G))
+  (define D  (matrix-procedure DM))
+  (define PI (matrix-procedure PM))
+  (define neg-cyc #false)
+  (for-each
+   (lambda (k)
+      (for-each
+       (lambda (i)
+	  (for-each
+	   (lambda (j)
+	      (let ((new-dist (+ (D i k) (D k j)))
+		    (new-pred (PI k j)))
+		(when (> (D i j) new-dist)
+		  (D  i j new-dist)
+		  (PI i j new-pred)
+		  (when (and (not (path? neg-cyc)) (= i j) (negative? (D i j)))
+		    (set! neg-cyc (cons-neg-cyc D PI i j))))))
+	   (iota n)))
+       (iota n)))
+   (iota n))
+  ;; Con archivo de resultados las matrices se escriben tal cual, sin
+  ;; armar la lista de todas las rutas
+  (cond ((path? neg-cyc)
+	 neg-cyc)
+	((result-file)
+	 (write-matrices! (list->vector (map cdr i:v)) DM PM)
+	 '())
+	(else
+	 (cons-all-paths D PI))))
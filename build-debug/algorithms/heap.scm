@@ -0,0 +1,123 @@
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; HEAP DATA STRUCTURE
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+(define-class <heap> ()
+  (order-pred #:getter heap-pred      #:setter set-heap-pred!     #:init-keyword #:order)
+  (get-key    #:getter heap-key-proc  #:setter heap-set-key-proc! #:init-keyword #:key)
+  (length     #:getter heap-length    #:setter heap-set-length!   #:init-keyword #:length)
+  (array      #:getter heap-array     #:setter heap-set-array!    #:init-keyword #:array)
+  (index      #:getter heap-index     #:setter heap-set-index!    #:init-keyword #:index))
+
+(define (parent idx)
+  (floor (/ (- idx 1) 2)))
+
+(define (left-child idx)
+  (+ (* 2 idx) 1))
+
+(define (right-child idx)
+  (* 2 (+ idx 1)))
+
+(define-method (heap-ref heap idx)
+  (vector-ref (heap-array heap) idx))
+
+(define (heap-set! heap idx elm)
+  (vector-set! (heap-array heap) idx elm))
+
+(define (swap! v i j)
+  (define e (vector-ref v i))
+  (vector-set! v i (vector-ref v j))
+  (vector-set! v j e))
+
+(define (heapify-down! heap idx)
+  (define (get-key i)
+    ((heap-key-proc heap) (heap-ref heap i)))
+  (define pred (heap-pred heap))
+  (define l (left-child idx))
+  (define r (right-child idx))
+  (define p
+    (cond ((and (<= l (heap-index heap))
+		(pred (get-key l) (get-key idx))
+		(if (<= r (heap-index heap))
+		    (pred (get-key l) (get-key r))
+		    #true)) l)
+	  ((and (<= r (heap-index heap))
+		(pred (get-key r) (get-key idx))
+		(pred (get-key r) (get-key l))) r)
+	  (else idx)))
+  (unless (equal? p idx)
+    (swap! (heap-array heap) idx p)
+    (heapify-down! heap p)))
+
+(define (heapify-up! heap idx)
+  (define (get-key i)
+    ((heap-key-proc heap) (heap-ref heap i)))
+  (define pred (heap-pred heap))
+  (define i idx)
+  (while (and (> i 0)
+	      (pred (get-key i) (get-key (parent i))))
+    (swap! (heap-array heap) i (parent i))
+    (set! i (parent i))))
+
+(define (resize heap)
+  (define (vector-new-from source new-size)
+    (define (copy-elms from to i)
+      (cond ((< i (vector-length from))
+	     (vector-set! to i (vector-ref from i))
+	     (copy-elms from to (+ i 1)))
+	    (else to)))
+    (copy-elms source (make-vector new-size '()) 0))
+  (let ((size (inexact->exact (expt 2 (+ (/ (log (heap-length heap))
+					    (log 2)) 1))))
+	(array (heap-array heap)))
+    (heap-set-array! heap (vector-new-from array size))
+    (heap-set-length! heap size)))
+
+(define-method (make-heap get-key comparator)
+  (make <heap>
+    #:order  comparator
+    #:key    get-key
+    #:length 64
+    #:array (make-vector 64 null)
+    #:index -1))
+
+(define-method (heap? (heap <heap>)) #true)
+(define-method (heap? obj)           #false)
+
+(define-method (empty? (heap <heap>))
+  (= (heap-index heap) -1))
+
+(define-method (purge! (heap <heap>))
+  (heap-set-index! heap -1)
+  (heap-set-array! heap (make-vector (heap-length heap) null)))
+
+(define-method (heap-size heap)
+  (+ (heap-index heap) 1))
+
+(define-method (priority (heap <heap>))
+  (cond ((empty? heap)
+	 (error "the heap is empty"))
+	(else
+	 (heap-ref heap 0))))
+
+(define-method (dequeue! (heap <heap>))
+  (cond ((empty? heap)
+	 (error "the heap is empty"))
+	(else
+	 (let ((p (heap-ref heap 0)))
+	   (heap-set! heap 0 (heap-ref heap (heap-index heap)))
+	   (heap-set! heap (heap-index heap) null)
+	   (heap-set-index! heap (- (heap-index heap) 1))
+	   (heapify-down! heap 0)
+	   p))))
+
+(define-method (enqueue! (heap <heap>) elm)
+  (when (= (+ (heap-size heap) 1)
+	   (heap-length heap))
+    (resize heap))
+  (heap-set-index! heap (+ (heap-index heap) 1))
+  (heap-set! heap (heap-index heap) elm)
+  (heapify-up! heap (heap-index heap)))
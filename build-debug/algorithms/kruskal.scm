@@ -0,0 +1,112 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; MINIMUM SPANNING FOREST KRUSKAL
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+(require-algorithm! "heap")
+
+(define-method (run-kruskal (g <undirected-graph>))
+  (kruskal g #:weight))
+
+(define-method (kruskal (g <undirected-graph>) (symb <keyword>))
+  (define (kruskal-message)
+    (define weights (make-hash-table))
+    (define message "")
+    (for-each (lambda (e)
+		(when (marked? e)
+		  (hash-set! weights (mark e) (+ (weight e)
+						 (if (hash-ref weights (mark e)) (hash-ref weights (mark e)) 0)))))
+	      (edges g))
+    (hash-for-each (lambda (k v)
+		     (set! message (string-append message
+						  "  peso marca " (obj->string k) " = " (obj->string v) "\n")))
+		   weights)
+    message)
+  (define (color-kruskal! v colors)
+    (let ((col (hash-ref colors (mark v))))
+      (label-vertex! v (obj->string (mark v)))
+      (cpp-color-node-label! v (first col) (second col) (third col) 150)
+      (cpp-color-node! v (first col) (second col) (third col) 150)))
+  (define (color-edge-kruskal! e colors)
+    (let ((from-col (hash-ref colors (mark (from e))))
+	  (to-col (hash-ref colors (mark (to e)))))
+      (cpp-color-edge! (from e) (to e) (first to-col) (second to-col) (third to-col) 150)))
+  (define (weight? x)   (atribute? g x symb))
+  (define (marked? x)   (atribute? g x #:mark))
+  (define (weight x)    (value (atribute g x symb)))
+  (define (mark x)      (value (atribute g x #:mark)))
+  (define (mark! x k)   (add-atribute! g x #:mark k))
+  (define (propagate-mark old new colors)
+    (for-each (lambda (v)
+		 (mark! v new)
+		 (color-kruskal! v colors))
+	      (filter (lambda (v) (and (marked? v) (equal? (mark v) old))) (vertices g)))
+    (for-each (lambda (e)
+		(mark! e new)
+		(color-edge-kruskal! e colors))
+	      (filter (lambda (e) (and (marked? e) (equal? (mark e) old))) (edges g))))
+  (define colors (make-hash-table))
+  (define tree (make <undirected-graph>))
+  (define queue (make-heap weight <=))
+  (define visited-edges 0)
+  (define component-id 0)
+  (define num-edges-tree (- (length (vertices g)) 1))
+  (hash-set! colors component-id (list (random 256) (random 256) (random 256)))
+  (for-each (lambda (e)
+	       (enqueue! queue e))
+	    (edges g))
+  (while (and (not (empty? queue))
+	      (not (equal? visited-edges num-edges-tree)))
+    (let* ((edge (dequeue! queue))
+	   (u    (from edge))
+	   (v    (to edge)))
+      (color-edge! edge #:yellow)
+      (wait! "Revisando arista " (obj->string edge))
+      (cond ((and (not (marked? u))
+		  (not (marked? v)))
+	     (mark! u component-id)
+	     (color-kruskal! u colors)
+	     (add-vertex! tree u)
+	     (mark! v component-id)
+	     (color-kruskal! v colors)
+	     (add-vertex! tree v)
+	     (mark! edge component-id)
+	     (color-edge-kruskal! edge colors)
+	     (add-edge! tree edge)
+	     (set! visited-edges (+ visited-edges 1))
+	     (set! component-id (+ component-id 1))
+	     (hash-set! colors component-id (list (random 256) (random 256) (random 256))))
+	    ((and (marked? u)
+		  (not (marked? v)))
+	     (mark! v (mark u))
+	     (color-kruskal! v colors)
+	     (add-vertex! tree v)
+	     (mark! edge (mark u))
+	     (color-edge-kruskal! edge colors)
+	     (add-edge! tree edge)
+	     (set! visited-edges (+ visited-edges 1)))
+	    ((and (not (marked? u))
+		  (marked? v))
+	     (mark! u (mark v))
+	     (color-kruskal! u colors)
+	     (add-vertex! tree u)
+	     (mark! edge (mark v))
+	     (color-edge-kruskal! edge colors)
+	     (add-edge! tree edge)
+	     (set! visited-edges (+ visited-edges 1)))
+	    ((and (marked? u)
+		  (marked? v)
+		  (not (equal? (mark u) (mark v))))
+	     (mark! edge (mark v))
+	     (color-edge-kruskal! edge colors)
+	     (add-edge! tree edge)
+	     (propagate-mark (mark u) (mark v) colors)
+	     (set! visited-edges (+ visited-edges 1))))))
+  (let ((message (string-append "Los árboles de mínima expansión han sido encontrados\n\n" (kruskal-message))))
+    (show-message! message))
+  (wait!)
+  (remove-vertices-atribute! g #:mark)
+  (remove-edges-atribute! g #:mark)
+  tree)
@@ -0,0 +1,298 @@
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; MINIMUM COST CONSTANT FLOW (NEGATIVE CYCLES)
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+(define-method (run-minimum-cost-constant-flow-nc (g <directed-graph>)
+						 (sources <list>)
+						 (sinks <list>)
+						 constant)
+  (define g* (graph-snapshot g))
+  (define F (minimum-cost-negative-cycles g* sources sinks constant))
+  (define fmax (apply max (map cdr F)))
+  (define total-flow (- (apply + (map cdr (filter (lambda (a:f) (if (member (car (car a:f)) sources) #true #false)) F)))
+			(apply + (map cdr (filter (lambda (a:f) (if (member (cadr (car a:f)) sources) #true #false)) F)))))
+  (define total-cost (apply + (map (lambda (a:f) (* (cdr a:f) (value (atribute g* (car a:f) #:cost)))) F)))
+  (when (result-file)
+    (write-flows! F cdr (lambda (a:f) (value (atribute g* (car a:f) #:cost)))))
+  (for-each (lambda (v) (color-vertex! v #:red)) sources)
+  (for-each (lambda (v) (color-vertex! v #:green)) sinks)
+  (for-each (lambda (a:f)
+	      (let ((a (car a:f))
+		    (f (cdr a:f)))
+		(label-arrow! a (string-append (obj->string (value (atribute g* a #:q-max))) ",$"
+					       (obj->string (value (atribute g* a #:cost))) ","
+					       "f:" (obj->string f)))
+		(when (not (zero? f))
+		  (cpp-color-arrow! (from a) (to a) 0 135 189
+				    (truncate (inexact->exact (* 150 (/ f fmax)))))))) F)
+  (show-message! "Se encontró el flujo a costo mínimo!\n\n"
+		 "fuentes = " (obj->string sources) "\n"
+		 "sumideros = " (obj->string sinks) "\n\n"
+		 "flujo en la red = " (obj->string total-flow) "\n"
+		 "costo total = " (obj->string total-cost)))
+
+(define-method (minimum-cost-negative-cycles (g <directed-graph>)
+					     (sources <list>)
+					     (sinks   <list>)
+					     constant)
+  ;; atribute predicates
+  (define (direction? x)   (atribute? g x #:direction))
+  (define (previous? x)    (atribute? g x #:previous))
+  (define (flow? x)        (atribute? g x #:flow))
+  (define (examined? x)    (atribute? g x #:examined))
+  (define (q-min? x)       (atribute? g x #:q-min))
+  (define (q-max? x)       (atribute? g x #:q-max))
+  (define (old-q-min? x)   (atribute? g x #:old-q-min))
+    
+  ;; atribute selectors
+  (define (direction x)    (value (atribute g x #:direction)))
+  (define (previous x)     (value (atribute g x #:previous)))
+  (define (flow x)         (value (atribute g x #:flow)))
+  (define (clon x)         (value (atribute g x #:clon)))
+  (define (q-min x)        (value (atribute g x #:q-min)))
+  (define (q-max x)        (value (atribute g x #:q-max)))
+  (define (old-q-min x)    (value (atribute g x #:old-q-min)))
+  (define (cost x)         (value (atribute g x #:cost)))
+
+  ;; atribute mutators
+  (define (direction! x d) (add-atribute! g x #:direction d))
+  (define (previous! x d)  (add-atribute! g x #:previous d))
+  (define (flow! x d)      (add-atribute! g x #:flow d))
+  (define (examined! x d)  (add-atribute! g x #:examined d))
+  (define (clon! x d)      (add-atribute! g x #:clon d))
+  (define (q-min! x d)     (add-atribute! g x #:q-min d))
+  (define (q-max! x d)     (add-atribute! g x #:q-max d))
+  (define (old-q-min! x d) (add-atribute! g x #:old-q-min d))
+  (define (cost! x d)      (add-atribute! g x #:cost d))
+
+  (define (-direction! x)  (remove-atribute! g x #:direction))
+  (define (-previous! x)   (remove-atribute! g x #:previous))
+  (define (-flow! x)       (remove-atribute! g x #:flow))
+  (define (-examined! x)   (remove-atribute! g x #:examined))
+  (define (-clon! x)       (remove-atribute! g x #:clon))
+  (define (-q-min! x)      (remove-atribute! g x #:q-min))
+  (define (-old-q-min! x)  (remove-atribute! g x #:old-q-min))
+
+  ;; algorithm procedures
+  (define (initialize-atributes!)
+    (for-each (lambda (a) (unless (q-min? a) (q-min! a 0)) (flow! a 0))
+	      (arrows g)))
+  
+  (define (destroy-atributes!)
+    (for-each (lambda (v) (-direction! v) (-previous! v) (-flow! v) (-examined! v))
+	      (vertices g)))
+  
+  (define (morph-multiple-sources! x)
+    (add-vertex! g x)
+    (for-each (lambda (v)
+		 (let ((a (list x v)))
+		   (add-arrow! g a)
+		   (q-max! a (inf)) (flow! a 0) (q-min! a 0) (cost! a 0)))
+	      sources))
+  
+  (define (recover-multiple-sources! x)
+    (remove-vertex! g x))
+  
+  (define (morph-multiple-sinks! x)
+    (define pre-x (string-append "pre-" (obj->string x)))
+    (add-vertex! g pre-x)
+    (for-each (lambda (v)
+		 (let ((a (list v pre-x)))
+		   (add-arrow! g a)
+		   (q-max! a (inf)) (flow! a 0) (q-min! a 0) (cost! a 0)))
+	      sinks)
+    (add-vertex! g x)
+    (let ((a (list pre-x x)))
+      (add-arrow! g a)
+      (q-max! a (if (null? constant) (inf) constant))
+      (flow! a 0) (q-min! a 0) (cost! a 0)))
+  
+  (define (recover-multiple-sinks! x)
+    (remove-vertex! g x)
+    (remove-vertex! g (string-append "pre-" (obj->string x))))
+  
+  (define (morph-restricted-vertices!)
+    (define (restricted? v) (or (q-min? v) (q-max? v)))
+    (define clon-v    null)
+    (define v->clon-v null)
+    (define clon-v->j null)
+    (for-each (lambda (v)
+		 (set! clon-v    (string-append "clon-" (obj->string v)))
+		 (set! v->clon-v (list v clon-v))
+		 (add-vertex! g clon-v)
+		 (clon! v clon-v)
+		 (add-arrow! g v->clon-v)
+		 (q-min! v->clon-v (if (q-min? v) (q-min v) 0))
+		 (q-max! v->clon-v (if (q-max? v) (q-max v) (inf)))
+		 (flow! v->clon-v 0)
+		 (cost! v->clon-v 0)
+		 (for-each (lambda (j)
+			      (set! clon-v->j (list clon-v j))
+			      (add-arrow! g clon-v->j)
+			      (let ((a (list v j)))
+				(q-min! clon-v->j (q-min a))
+				(q-max! clon-v->j (q-max a))
+				(flow!  clon-v->j (flow  a))
+				(cost!  clon-v->j (cost  a))
+				(remove-arrow! g a)))
+			   (remove (lambda (u) (equal? u clon-v)) (out-adjacent g v))))
+	      (filter restricted? (vertices g))))
+  
+  (define (recover-restricted-vertices!)
+    (define (restricted? v) (or (q-min? v) (q-max? v)))
+    (define clon-v null)
+    (for-each (lambda (v)
+		 (set! clon-v (clon v))
+		 (for-each (lambda (j)
+			      (let ((a1 (list v j))
+				    (a2 (list clon-v j)))
+				(add-arrow! g a1)
+				(q-min! a1 (q-min a2))
+				(q-max! a1 (q-max a2))
+				(flow!  a1 (flow  a2))
+				(cost!  a1 (cost  a2))))
+			   (out-adjacent g (clon v)))
+		 (remove-vertex! g clon-v)
+		 (-clon! v))
+	      (filter restricted? (vertices g))))
+  
+  (define (morph-restricted-arrows! x y x* y*)
+    (define (add-arrow+atrb! a qmax flw qmin)
+      (add-arrow! g a)
+      (q-max! a qmax) (flow! a flw) (q-min! a qmin))
+    (add-vertices! g (list x* y*))
+    (for-each (lambda (a)
+		 (let ((a1 (list x* (to a)))
+		       (a2 (list (from a) y*)))
+		   (if (arrow? g a1)
+		       (q-max! a1 (+ (q-min a) (q-max a1)))
+		       (add-arrow+atrb! a1 (q-min a) 0 0))
+		   (if (arrow? g a2)
+		       (q-max! a2 (+ (q-min a) (q-max a2)))
+		       (add-arrow+atrb! a2 (q-min a) 0 0))
+		   (old-q-min! a (q-min a))
+		   (q-max! a (- (q-max a) (q-min a)))
+		   (q-min! a 0)))
+	      (remove (lambda (a) (zero? (q-min a))) (arrows g)))
+    (add-arrow+atrb! (list x y) (inf) 0 0)
+    (add-arrow+atrb! (list y x) (inf) 0 0))
+  
+  (define (recover-restricted-arrows! x y x* y*)
+    (remove-arrows! g (list (list x y) (list y x)))
+    (for-each (lambda (a)
+		(flow!  a (+ (flow a) (old-q-min a)))
+		(q-max! a (+ (q-max a) (old-q-min a)))
+		(q-min! a (old-q-min a))
+		(-old-q-min! a))
+	      (filter (lambda (a) (old-q-min? a)) (arrows g)))
+    (remove-vertices! g (list x* y*)))
+
+  (define (label! v dir pre flw)
+    (direction! v dir)
+    (previous!  v pre)
+    (flow!      v flw))
+
+  (define (labeled? v)
+    (and (direction? v) (previous? v) (flow? v)))
+
+  (define (all-examined?)
+    (fold (lambda (x y) (and x y)) #true (map examined? (filter labeled? (vertices g)))))
+
+  (define (examine! v)
+    (for-each (lambda (u)
+		 (let ((a (list v u)))
+		   (when (< (flow a) (q-max a))
+		     (label! u '+ v (min (flow v) (- (q-max a) (flow a)))))))
+	      (remove (lambda (u) (labeled? u)) (out-adjacent g v)))
+    (for-each (lambda (u)
+		 (let ((a (list u v)))
+		   (when (> (flow a) (q-min a))
+		     (label! u '- v (min (flow v) (- (flow a) (q-min a)))))))
+	      (remove (lambda (u) (labeled? u)) (in-adjacent g v)))
+    (examined! v #true))
+
+  (define (augment-flow! x y)
+    (define z y)
+    (while (not (equal? z x))
+      (let ((p (previous z)))
+	(if (equal? (direction z) '+)
+	    (flow! (list p z) (+ (flow (list p z)) (flow y)))
+	    (flow! (list z p) (- (flow (list z p)) (flow y))))
+	(set! z p)))
+    (destroy-atributes!)
+    (find-augmenting-path! x y))
+  
+  (define (find-augmenting-path! x y)
+    (label! x '+ x (inf))
+    (while (and (not (all-examined?)) (not (labeled? y)))
+      (examine! (first (filter (lambda (v) (and (not (examined? v)) (labeled? v))) (vertices g)))))
+    (when (labeled? y)
+      (augment-flow! x y)))
+
+  (define (residual-g G)
+    (define (f N a)    (value (atribute N a #:flow)))
+    (define (q N a)    (value (atribute N a #:q-max)))
+    (define (r N a)    (value (atribute N a #:q-min)))
+    (define (c N a)    (value (atribute N a #:cost)))
+    (define (q! N a v) (add-atribute! N a #:q-max v))
+    (define (c! N a v) (add-atribute! N a #:cost v))
+    (define (A! N a v) (add-atribute! N a #:A v))
+    (define Gf (make <directed-graph>))
+    (for-each (lambda (i->j)
+		 (let ((j->i (reverse i->j)))
+		   (when (< (f G i->j) (q G i->j))
+		     (add-arrow! Gf i->j)
+		     (q! Gf i->j (- (q G i->j) (f G i->j)))
+		     (c! Gf i->j (c G i->j))
+		     (A! Gf i->j 1))
+		   (when (> (f G i->j) (r G i->j))
+		     (add-arrow! Gf j->i)
+		     (q! Gf j->i (- (f G i->j) (r G i->j)))
+		     (c! Gf j->i (- (c G i->j)))
+		     (A! Gf j->i 2))))
+	      (arrows G))
+    Gf)
+
+  (define (negative-cycle? lst)
+    (and (not (null? lst)) (equal? #:negative-cycle (first lst))))
+
+  (define (negative-cycle->arrows neg-cyc)
+    (define path (second neg-cyc))
+    (map (lambda (u v) (list u v)) path (cdr path)))
+
+  (define residual #false)
+  (define neg-cycl #false)
+  
+  ;; Algorithm
+  (initialize-atributes!)
+  (morph-multiple-sources! 'alpha)
+  (morph-multiple-sinks! 'omega)
+  (morph-restricted-vertices!)
+  (morph-restricted-arrows! 'alpha 'omega 'alpha* 'omega*)
+  (find-augmenting-path! 'alpha* 'omega*)
+  (destroy-atributes!)
+  (recover-restricted-arrows! 'alpha 'omega 'alpha* 'omega*)
+  (find-augmenting-path! 'alpha 'omega)
+  (set! residual (residual-g g))
+  (set! neg-cycl (floyd-warshall residual #:cost))
+  (while (negative-cycle? neg-cycl)
+    (let* ((cycle-arrows neg-cycl)
+	   (d (apply min (map (lambda (a) (value (atribute residual a #:q-max))) cycle-arrows))))
+      (for-each (lambda (u->v)
+		   (let ((v->u (list (to u->v) (from u->v))))
+		     (if (= (value (atribute residual u->v #:A)) 1)
+			 (flow! u->v (+ (flow u->v) d))
+			 (flow! v->u (- (flow v->u) d)))))
+		cycle-arrows))
+    (set! residual (residual-g g))
+    (set! neg-cycl (floyd-warshall residual #:cost)))
+  (recover-restricted-vertices!)
+  (recover-multiple-sources! 'alpha)
+  (recover-multiple-sinks! 'omega)
+  (destroy-atributes!)
+  (let ((return (map (lambda (a) (cons a (flow a))) (arrows g))))
+    (remove-arrows-atribute! g #:flow)
+    return))
@@ -0,0 +1,421 @@
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; MINIMUM COST CONSTANT FLOW (SHORTESTS PATHS)
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; ;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+(require-algorithm! "heap")
+
+(define-method (run-minimum-cost-constant-flow-sp (g <directed-graph>)
+						   (sources <list>)
+						   (sinks <list>)
+						   constant)
+  (define g* (graph-snapshot g))
+  (define F (minimum-cost-shortests-paths g* sources sinks constant))
+  (define fmax (apply max (map cdr F)))
+  (define total-flow (- (apply + (map cdr (filter (lambda (a:f) (if (member (car (car a:f)) sources) #true #false)) F)))
+			(apply + (map cdr (filter (lambda (a:f) (if (member (cadr (car a:f)) sources) #true #false)) F)))))
+  (define total-cost (apply + (map (lambda (a:f) (* (cdr a:f) (value (atribute g* (car a:f) #:cost)))) F)))
+  (when (result-file)
+    (write-flows! F cdr (lambda (a:f) (value (atribute g* (car a:f) #:cost)))))
+  (for-each (lambda (v) (color-vertex! v #:red)) sources)
+  (for-each (lambda (v) (color-vertex! v #:green)) sinks)
+  (for-each (lambda (a:f)
+	      (let ((a (car a:f))
+		    (f (cdr a:f)))
+		(label-arrow! a (string-append (obj->string (value (atribute g* a #:q-max))) ",$"
+					       (obj->string (value (atribute g* a #:cost))) ","
+					       "f:" (obj->string f)))
+		(when (not (zero? f))
+		  (cpp-color-arrow! (from a) (to a) 0 135 189
+				    (truncate (inexact->exact (* 150 (/ f fmax)))))))) F)
+  (show-message! "Se encontró el flujo a costo mínimo!\n\n"
+		 "fuentes = " (obj->string sources) "\n"
+		 "sumideros = " (obj->string sinks) "\n\n"
+		 "flujo en la red = " (obj->string total-flow) "\n"
+		 "costo total = " (obj->string total-cost)))
+
+(define-method (redijkstra (g <directed-graph>)
+			   origin
+			   destination
+			   (symb <keyword>))
+  (define (mark? x)          (atribute? g x #:mark))
+  (define (distance x)       (value (atribute g x #:distance)))
+  (define (predecessor x)    (value (atribute g x #:predecessor)))
+  (define (mark x)           (value (atribute g x #:mark)))
+  (define (weight x)         (value (atribute g x symb)))
+  (define (distance! x v)    (add-atribute! g x #:distance v))
+  (define (predecessor! x v) (add-atribute! g x #:predecessor v))
+  (define (mark! x v)        (add-atribute! g x #:mark v))
+  (define (-mark! x)         (remove-atribute! g x #:mark))
+
+  (define (better-path? u->v)
+    (define u (from u->v))
+    (define v (to u->v))
+    (< (+ (distance u)
+	  (weight u->v))
+       (distance v)))
+  
+  (define (update-paths! u)
+    (define vs (filter (lambda (x) (equal? (predecessor x) u)) (out-adjacent g u)))
+    (unless (null? vs)
+      (let ((v (first vs)))
+	(predecessor! v u)
+	(distance! v (+ (distance u) (weight (list u v))))
+	(update-paths! v))))
+
+  (define (cons-path)
+    (define (acumulate arrow path)
+      (let ((u (from arrow)) (v (to arrow)))
+	(cond ((equal? u origin) (cons (list origin v) path))
+	      (else              (acumulate (list (predecessor u) u) (cons arrow path))))))
+    (acumulate (list (predecessor destination) destination) '()))
+
+  (define (form-negative-cycle new-arrow)
+    (define (acumulate arrow cycle weights)
+      (let ((u (from arrow)) (v (to arrow)))
+	(cond ((equal? u (to new-arrow))
+	       (if (< (+ (weight arrow) (apply + weights)) 0)
+		   (cons arrow cycle)
+		   #false))
+	      ((equal? u origin)
+	       #false)
+	      (else
+	       (acumulate (list (predecessor u) u) (cons arrow cycle) (cons (weight arrow) weights))))))
+    (acumulate new-arrow null null))
+
+  (define vertex-queue (make-heap distance <=))
+  (define arrow-queue  (make-heap weight <=))
+  (define neg-cycl     #false)
+
+  (for-each (lambda (v)
+	       (predecessor! v v)
+	       (distance! v (inf)))
+	    (vertices g))
+  (predecessor! origin origin)
+  (distance! origin 0)
+  (mark! origin 'temporal)
+  (enqueue! vertex-queue origin)
+  (while (not (empty? vertex-queue))
+    (let ((v (dequeue! vertex-queue)))
+      (mark! v 'final)
+      (unless (equal? v (predecessor v))
+	(mark! (list (predecessor v) v) 'touched))
+      (for-each (lambda (k)
+		   (cond ((not (mark? k))
+			  (mark! k 'temporal)
+			  (enqueue! vertex-queue k)
+			  (predecessor! k v)
+			  (distance! k (+ (distance v) (weight (list v k)))))
+			 ((and (equal? (mark k) 'temporal)
+			       (< (+ (distance v) (weight (list v k)))
+				  (distance k)))
+			  (predecessor! k v)
+			  (distance! k (+ (distance v) (weight (list v k)))))))
+		(out-adjacent g v))))
+  (cond ((mark? destination)
+	 (for-each (lambda (a)
+		      (enqueue! arrow-queue a))
+		   (filter (lambda (a) (not (mark? a))) (arrows g)))
+	 (while (not (empty? arrow-queue))
+	   (let* ((u->v  (dequeue! arrow-queue))
+		  (u     (from u->v))
+		  (v     (to u->v))
+		  (cycle (form-negative-cycle u->v)))
+	     (cond ((and (better-path? u->v)
+			 (not cycle))
+		    (enqueue! arrow-queue (list (predecessor v) v))
+		    (mark! u->v 'touched)
+		    (predecessor! v u)
+		    (distance! v (+ (distance u) (weight u->v)))
+		    (update-paths! v))
+		   ((list? cycle)
+		    (set! neg-cycl (list #:negative-cycle cycle (apply + (map weight cycle))))
+		    (purge! arrow-queue)))))
+	 (let ((return (if (not neg-cycl) (cons-path) neg-cycl)))
+	   (remove-vertices-atribute! g #:predecessor)
+	   (remove-vertices-atribute! g #:mark)
+	   (remove-arrows-atribute! g #:mark)
+	   (remove-vertices-atribute! g #:distance)
+	   return))
+	(else
+	 (remove-vertices-atribute! g #:predecessor)
+	 (remove-vertices-atribute! g #:distance)
+	 (remove-vertices-atribute! g #:mark)
+	 (remove-arrows-atribute! g #:mark)
+	 (list #:no-path))))
+
+(define-method (minimum-cost-shortests-paths (g <directed-graph>)
+					     (sources <list>)
+					     (sinks   <list>)
+					     constant)
+  ;; atribute predicates
+  (define (direction? x)   (atribute? g x #:direction))
+  (define (previous? x)    (atribute? g x #:previous))
+  (define (flow? x)        (atribute? g x #:flow))
+  (define (examined? x)    (atribute? g x #:examined))
+  (define (q-min? x)       (atribute? g x #:q-min))
+  (define (q-max? x)       (atribute? g x #:q-max))
+  (define (old-q-min? x)   (atribute? g x #:old-q-min))
+  
+  ;; atribute selectors
+  (define (direction x)    (value (atribute g x #:direction)))
+  (define (previous x)     (value (atribute g x #:previous)))
+  (define (flow x)         (value (atribute g x #:flow)))
+  (define (clon x)         (value (atribute g x #:clon)))
+  (define (q-min x)        (value (atribute g x #:q-min)))
+  (define (q-max x)        (value (atribute g x #:q-max)))
+  (define (old-q-min x)    (value (atribute g x #:old-q-min)))
+  (define (cost x)         (value (atribute g x #:cost)))
+
+  ;; atribute mutators
+  (define (direction! x d) (add-atribute! g x #:direction d))
+  (define (previous! x d)  (add-atribute! g x #:previous d))
+  (define (flow! x d)      (add-atribute! g x #:flow d))
+  (define (examined! x d)  (add-atribute! g x #:examined d))
+  (define (clon! x d)      (add-atribute! g x #:clon d))
+  (define (q-min! x d)     (add-atribute! g x #:q-min d))
+  (define (q-max! x d)     (add-atribute! g x #:q-max d))
+  (define (old-q-min! x d) (add-atribute! g x #:old-q-min d))
+  (define (cost! x d)      (add-atribute! g x #:cost d))
+
+  (define (-direction! x)  (remove-atribute! g x #:direction))
+  (define (-previous! x)   (remove-atribute! g x #:previous))
+  (define (-flow! x)       (remove-atribute! g x #:flow))
+  (define (-examined! x)   (remove-atribute! g x #:examined))
+  (define (-clon! x)       (remove-atribute! g x #:clon))
+  (define (-q-min! x)      (remove-atribute! g x #:q-min))
+  (define (-old-q-min! x)  (remove-atribute! g x #:old-q-min))
+  
+  ;; algorithm procedures
+  (define (initialize-atributes!)
+    (for-each (lambda (a) (unless (q-min? a) (q-min! a 0)) (flow! a 0))
+	      (arrows g)))
+  
+  (define (destroy-atributes!)
+    (for-each (lambda (v) (-direction! v) (-previous! v) (-flow! v) (-examined! v))
+	      (vertices g)))
+  
+  (define (morph-multiple-sources! x)
+    (add-vertex! g x)
+    (for-each (lambda (v)
+		 (let ((a (list x v)))
+		   (add-arrow! g a)
+		   (q-max! a (inf)) (flow! a 0) (q-min! a 0) (cost! a 0)))
+	      sources))
+  
+  (define (recover-multiple-sources! x)
+    (remove-vertex! g x))
+  
+  (define (morph-multiple-sinks! x)
+    (define pre-x (string-append "pre-" (obj->string x)))
+    (add-vertex! g pre-x)
+    (for-each (lambda (v)
+		 (let ((a (list v pre-x)))
+		   (add-arrow! g a)
+		   (q-max! a (inf)) (flow! a 0) (q-min! a 0) (cost! a 0)))
+	      sinks)
+    (add-vertex! g x)
+    (let ((a (list pre-x x)))
+      (add-arrow! g a)
+      (q-max! a constant)
+      (flow! a 0) (q-min! a 0) (cost! a 0)))
+  
+  (define (recover-multiple-sinks! x)
+    (remove-vertex! g x)
+    (remove-vertex! g (string-append "pre-" (obj->string x))))
+  
+  (define (morph-restricted-vertices!)
+    (define (restricted? v) (or (q-min? v) (q-max? v)))
+    (define clon-v    null)
+    (define v->clon-v null)
+    (define clon-v->j null)
+    (for-each (lambda (v)
+		 (set! clon-v    (string-append "clon-" (obj->string v)))
+		 (set! v->clon-v (list v clon-v))
+		 (add-vertex! g clon-v)
+		 (clon! v clon-v)
+		 (add-arrow! g v->clon-v)
+		 (q-min! v->clon-v (if (q-min? v) (q-min v) 0))
+		 (q-max! v->clon-v (if (q-max? v) (q-max v) (inf)))
+		 (flow! v->clon-v 0)
+		 (cost! v->clon-v 0)
+		 (for-each (lambda (j)
+			      (set! clon-v->j (list clon-v j))
+			      (add-arrow! g clon-v->j)
+			      (let ((a (list v j)))
+				(q-min! clon-v->j (q-min a))
+				(q-max! clon-v->j (q-max a))
+				(flow!  clon-v->j (flow  a))
+				(cost!  clon-v->j (cost  a))
+				(remove-arrow! g a)))
+			   (remove (lambda (u) (equal? u clon-v)) (out-adjacent g v))))
+	      (filter restricted? (vertices g))))
+  
+  (define (recover-restricted-vertices!)
+    (define (restricted? v) (or (q-min? v) (q-max? v)))
+    (define clon-v null)
+    (for-each (lambda (v)
+		 (set! clon-v (clon v))
+		 (for-each (lambda (j)
+			      (let ((a1 (list v j))
+				    (a2 (list clon-v j)))
+				(add-arrow! g a1)
+				(q-min! a1 (q-min a2))
+				(q-max! a1 (q-max a2))
+				(flow!  a1 (flow  a2))
+				(cost!  a1 (cost  a2))))
+			   (out-adjacent g (clon v)))
+		 (remove-vertex! g clon-v)
+		 (-clon! v))
+	      (filter restricted? (vertices g))))
+  
+  (define (morph-restricted-arrows! x y x* y*)
+    (define (add-arrow+atrb! a qmax flw qmin)
+      (add-arrow! g a)
+      (q-max! a qmax) (flow! a flw) (q-min! a qmin))
+    (add-vertices! g (list x* y*))
+    (for-each (lambda (a)
+		 (let ((a1 (list x* (to a)))
+		       (a2 (list (from a) y*)))
+		   (if (arrow? g a1)
+		       (q-max! a1 (+ (q-min a) (q-max a1)))
+		       (add-arrow+atrb! a1 (q-min a) 0 0))
+		   (if (arrow? g a2)
+		       (q-max! a2 (+ (q-min a) (q-max a2)))
+		       (add-arrow+atrb! a2 (q-min a) 0 0))
+		   (old-q-min! a (q-min a))
+		   (q-max! a (- (q-max a) (q-min a)))
+		   (q-min! a 0)))
+	      (remove (lambda (a) (zero? (q-min a))) (arrows g)))
+    (add-arrow+atrb! (list x y) (inf) 0 0)
+    (add-arrow+atrb! (list y x) (inf) 0 0))
+  
+  (define (recover-restricted-arrows! x y x* y*)
+    (remove-arrows! g (list (list x y) (list y x)))
+    (for-each (lambda (a)
+		(flow!  a (+ (flow a) (old-q-min a)))
+		(q-max! a (+ (q-max a) (old-q-min a)))
+		(q-min! a (old-q-min a))
+		(-old-q-min! a))
+	      (filter (lambda (a) (old-q-min? a)) (arrows g)))
+    (remove-vertices! g (list x* y*)))
+
+  (define (label! v dir pre flw)
+    (direction! v dir)
+    (previous!  v pre)
+    (flow!      v flw))
+
+  (define (labeled? v)
+    (and (direction? v) (previous? v) (flow? v)))
+
+  (define (all-examined?)
+    (fold (lambda (x y) (and x y)) #true (map examined? (filter labeled? (vertices g)))))
+
+  (define (examine! v)
+    (for-each (lambda (u)
+		 (let ((a (list v u)))
+		   (when (< (flow a) (q-max a))
+		     (label! u '+ v (min (flow v) (- (q-max a) (flow a)))))))
+	      (remove (lambda (u) (labeled? u)) (out-adjacent g v)))
+    (for-each (lambda (u)
+		 (let ((a (list u v)))
+		   (when (> (flow a) (q-min a))
+		     (label! u '- v (min (flow v) (- (flow a) (q-min a)))))))
+	      (remove (lambda (u) (labeled? u)) (in-adjacent g v)))
+    (examined! v #true))
+
+  (define (augment-flow! x y)
+    (define z y)
+    (while (not (equal? z x))
+      (let ((p (previous z)))
+	(if (equal? (direction z) '+)
+	    (flow! (list p z) (+ (flow (list p z)) (flow y)))
+	    (flow! (list z p) (- (flow (list z p)) (flow y))))
+	(set! z p)))
+    (destroy-atributes!)
+    (find-augmenting-path! x y))
+  
+  (define (find-augmenting-path! x y)
+    (label! x '+ x (inf))
+    (while (and (not (all-examined?)) (not (labeled? y)))
+      (examine! (first (filter (lambda (v) (and (not (examined? v)) (labeled? v))) (vertices g)))))
+    (when (labeled? y)
+      (augment-flow! x y)))
+
+  (define (residual-g H)
+    (define (f N a)    (value (atribute N a #:flow)))
+    (define (q N a)    (value (atribute N a #:q-max)))
+    (define (r N a)    (value (atribute N a #:q-min)))
+    (define (c N a)    (value (atribute N a #:cost)))
+    (define (q! N a v) (add-atribute! N a #:q-max v))
+    (define (c! N a v) (add-atribute! N a #:cost v))
+    (define (A! N a v) (add-atribute! N a #:A v))
+    (define Hf (make <directed-graph>))
+    (for-each (lambda (i->j)
+		 (let ((j->i (reverse i->j)))
+		   (when (< (f H i->j) (q H i->j))
+		     (add-arrow! Hf i->j)
+		     (q! Hf i->j (- (q H i->j) (f H i->j)))
+		     (c! Hf i->j (c H i->j))
+		     (A! Hf i->j 1))
+		   (when (> (f H i->j) (r H i->j))
+		     (add-arrow! Hf j->i)
+		     (q! Hf j->i (- (f H i->j) (r H i->j)))
+		     (c! Hf j->i (- (c H i->j)))
+		     (A! Hf j->i 2))))
+	      (arrows H))
+    Hf)
+
+  (define (negative-cycle? lst)
+    (and (not (null? lst)) (equal? #:negative-cycle (first lst))))
+
+  (define (negative-cycle->arrows neg-cyc)
+    (define path (second neg-cyc))
+    (map (lambda (u v) (list u v)) path (cdr path)))
+
+  (define (g-flow)
+    (- (apply + (map (lambda (x) (value (atribute g x #:flow))) (outcident g 'alpha)))
+       (apply + (map (lambda (x) (value (atribute g x #:flow))) (incident g 'alpha)))))
+
+  (define residual #false)
+  (define shrt-path #false)
+  (define d #false)
+  (define solvable #true)
+  
+  ;; Algorithm
+  (initialize-atributes!)
+  (morph-multiple-sources! 'alpha)
+  (morph-multiple-sinks! 'omega)
+  (set! residual  (residual-g g))
+  (set! shrt-path (redijkstra residual 'alpha 'omega #:cost))
+  (when (equal? (first shrt-path) #:no-path) (set! solvable #false))
+  (when solvable
+    (set! d (apply min (map (lambda (a) (value (atribute residual a #:q-max))) shrt-path)))
+    (while (and (<= (+ (g-flow) d) constant)
+		(not (equal? (first shrt-path) #:no-path)))
+      (for-each (lambda (a)
+		   (when (arrow? g a)
+		     (add-atribute! g a
+				    #:flow (+ (value (atribute g a #:flow)) d))))
+		shrt-path)
+      (set! residual  (residual-g g))
+      (set! shrt-path (redijkstra residual 'alpha 'omega #:cost))
+      (when (equal? (first shrt-path) #:no-path) (set! solvable #false))
+      (when solvable
+	(set! d (apply min (map (lambda (a) (value (atribute residual a #:q-max))) shrt-path))))))
+  (when (and solvable (> (+ (g-flow) d) constant))
+    (let ((v* (g-flow)))
+      (for-each (lambda (a)
+		   (when (arrow? g a)
+		     (add-atribute! g a
+				    #:flow (+ (value (atribute g a #:flow))
+					      (- constant v*)))))
+		shrt-path)))
+  (recover-multiple-sources! 'alpha)
+  (recover-multiple-sinks! 'omega)
+  (destroy-atributes!)
+  (let ((return (map (lambda (a) (cons a (value (atribute g a #:flow)))) (arrows g))))
+    (remove-arrows-atribute! g #:flow)
+    return))
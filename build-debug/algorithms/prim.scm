@@ -0,0 +1,59 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; MINIMUM SPANNING TREE PRIM
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+(require-algorithm! "heap")
+
+(define-method (run-prim (g <undirected-graph>) root)
+  (prim g root #:weight))
+
+(define-method (prim (g <undirected-graph>) root (symb <keyword>))
+  (define (tree-weight tree)
+    (apply + (map weight (edges tree))))
+  (define (weight? x)   (atribute? g x symb))
+  (define (marked? x)   (atribute? g x #:mark))
+  (define (weight x)    (value (atribute g x symb)))
+  (define (mark! x)     (add-atribute! g x #:mark #t))
+  (define tree   (make <undirected-graph>))
+  (define queue  (make-heap weight <=))
+  (color-vertex! root #:green)
+  (wait! "Vertex " (obj->string root) " added to minimum spanning tree.")
+  (mark! root)
+  (add-vertex! tree root)
+  (for-each (lambda (v)
+	       (enqueue! queue (list root v)))
+	    (adjacent g root))
+  (while (not (empty? queue))
+    (let* ((edge (dequeue! queue))
+	   (u    (from edge))
+	   (v    (to edge)))
+      (unless (marked? v)
+	(color-vertex! v #:green)
+	(wait! "Vertex " (obj->string v) " added to minimum spanning tree.")
+	(mark! v)
+	(add-vertex! tree v)
+	(color-edge! edge #:red)
+	(wait! "Edge " (obj->string edge) " added to minimum spanning tree.")
+	(add-edge! tree edge)
+	(add-atribute! tree edge symb (weight edge))
+	(for-each (lambda (w)
+		     (enqueue! queue (list v w)))
+		  (remove marked? (adjacent g v))))))
+  (remove-vertices-atribute! g #:mark)
+  (if (= (length (vertices g))
+	 (length (vertices tree)))
+      (begin
+	(show-message! "Minimum Spanning Tree obtained\n\nTree weight = " (obj->string (tree-weight tree)))
+	(wait! "Clean graph")
+	(for-each (lambda (v) (uncolor-vertex! v)) (vertices g))
+	(for-each (lambda (e) (uncolor-edge! e)) (edges g))
+	tree)
+      (begin
+	(show-message! "The graph doesn't have a minimum spanning tree")
+	(wait! "Clean graph")
+	(for-each (lambda (v) (uncolor-vertex! v)) (vertices g))
+	(for-each (lambda (e) (uncolor-edge! e)) (edges g))
+	#false)))
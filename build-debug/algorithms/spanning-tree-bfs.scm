@@ -0,0 +1,57 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; SPANNING TREE BFS
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+(define-method (run-spanning-tree-bfs (g <undirected-graph>) root)
+  (spanning-tree-bfs g root))
+
+(define-method (spanning-tree-bfs (g <undirected-graph>) root)
+  (define tree (make <undirected-graph>))
+  (breath-first-search g root
+		       (lambda (v)
+			  (color-vertex! v #:green)
+			  (wait! "Vertex " (obj->string v) " added to spanning tree.")
+			  (add-vertex! tree v))
+		       (lambda (u v)
+			  (color-edge! (list u v) #:green)
+			  (wait! "Edge " (obj->string (list u v)) " added to spanning tree.")
+			  (add-edge! tree (list u v)))
+		       (lambda (lst)
+			  (sort lst <)))
+  (if (= (length (vertices g)) (length (vertices tree)))
+      (begin
+	(show-message! "Spanning Tree obtained")
+	(wait! "Clean graph")
+	(for-each (lambda (v) (uncolor-vertex! v)) (vertices g))
+	(for-each (lambda (e) (uncolor-edge! e)) (edges g))
+	tree)
+      (begin
+	(show-message! "The graph doesn't have a spanning tree")
+	(wait! "Clean graph")
+	(for-each (lambda (v) (uncolor-vertex! v)) (vertices g))
+	(for-each (lambda (e) (uncolor-edge! e)) (edges g))
+	#false)))
+
+(define-method (breath-first-search (g <graph>)
+				    source
+				    (visit-vertex!  <procedure>)
+				    (visit-edge!    <procedure>)
+				    (order-vertices <procedure>))
+  (define (is-marked? v) (atribute? g v #:marked))
+  (define (mark! v) (add-atribute! g v #:marked #true))
+  (define q (make-q))
+  (mark! source)
+  (visit-vertex! source)
+  (enq! q source)
+  (while (not (q-empty? q))
+    (let ((v (deq! q)))
+      (for-each (lambda (u)
+		   (mark! u)
+		   (visit-vertex! u)
+		   (enq! q u)
+		   (visit-edge! v u))
+		(order-vertices (remove is-marked? (adjacent g v))))))
+  (remove-vertices-atribute! g #:marked))
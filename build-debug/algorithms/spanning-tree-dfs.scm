@@ -0,0 +1,54 @@
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;; SPANNING TREE DFS
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;;
+(define-method (run-spanning-tree-dfs (g <undirected-graph>) root)
+  (spanning-tree-dfs g root))
+
+(define-method (spanning-tree-dfs (g <undirected-graph>) root)
+  (define tree   (make <undirected-graph>))
+  (depth-first-search g root
+		      (lambda (v)
+			 (color-vertex! v #:green)
+			 (wait! "Vertex " (obj->string v) " added to spanning tree.")
+			 (add-vertex! tree v))
+		      (lambda (u v)
+			 (color-edge! (list u v) #:green)
+			 (wait! "Edge " (obj->string (list u v)) " added to spanning tree.")
+			 (add-edge! tree (list u v)))
+		      (lambda (lst)
+			 (sort lst <)))
+  (if (= (length (vertices g)) (length (vertices tree)))
+      (begin
+	(show-message! "Spanning Tree obtained")
+	(wait! "Clean graph")
+	(for-each (lambda (v) (uncolor-vertex! v)) (vertices g))
+	(for-each (lambda (e) (uncolor-edge! e)) (edges g))
+	tree)
+      (begin
+	(show-message! "The graph doesn't have a spanning tree")
+	(wait! "Clean graph")
+	(for-each (lambda (v) (uncolor-vertex! v)) (vertices g))
+	(for-each (lambda (e) (uncolor-edge! e)) (edges g))
+	#false)))
+
+(define-method (depth-first-search (g <graph>)
+				   source
+				   (visit-vertex!  <procedure>)
+				   (visit-edge!    <procedure>)
+				   (order-vertices <procedure>))
+  (define (is-marked? v) (atribute? g v #:marked))
+  (define (mark! v) (add-atribute! g v #:marked #true))
+  (define (search-from v)
+    (mark! v)
+    (visit-vertex! v)
+    (for-each (lambda (u)
+		 (unless (is-marked? u)
+		   (visit-edge! v u)
+		   (search-from u)))
+	      (order-vertices (adjacent g v))))
+  (search-from source)
+  (remove-vertices-atribute! g #:marked))
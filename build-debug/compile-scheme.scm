@@ -0,0 +1,33 @@
+;;; compile-scheme.scm
+;;; Compiles the Scheme files loaded by the environment to .go objects,
+;;; called from the qmake build.
+;;;
+;;; guile compile-scheme.scm SOURCE OUTPUT
+;;;
+;;; vis-graph.scm, algorithms.scm and the files in algorithms/ are not
+;;; modules, they are loaded into the user module after init.scm. They are
+;;; compiled in a module with the same imports so that GOOPS and the graph
+;;; macros expand as they do at run time. The cpp-* procedures are only
+;;; defined by the executable, the warnings about them being unbound are
+;;; expected.
+
+(use-modules (system base compile))
+
+(define source (cadr (command-line)))
+(define output (caddr (command-line)))
+
+;; The (grafo ...) modules live next to this script, not next to the
+;; files in algorithms/
+(add-to-load-path (dirname (canonicalize-path (current-filename))))
+
+(define env (make-fresh-user-module))
+
+(eval '(use-modules (oop goops)
+		    (grafo graph)
+		    (grafo utils)
+		    (srfi srfi-1)
+		    (ice-9 q)
+		    (srfi srfi-43))
+      env)
+
+(compile-file source #:output-file output #:env env)
@@ -5,6 +5,7 @@
 (define-module (grafo graph)
   #:use-module (oop   goops)
   #:use-module (srfi  srfi-1)
+  #:use-module (srfi  srfi-4)
   #:use-module (grafo hashtable)
   #:export (<graph>
 	    <undirected-graph>
@@ -31,6 +32,9 @@
 	    add-vertices!
 	    remove-vertex!
 	    remove-vertices!
+	    clear-graph!
+	    load-graph!
+	    graph-snapshot
 	    add-edge!
 	    add-edges!
 	    remove-edge!
@@ -146,6 +150,18 @@
 	(else #f)))
 
 
+;;; atribute tables that may be modified, the ones shared with a snapshot
+;;; are copied first
+(define-method (own-v:as (g <graph>) vertex)
+  (if (layered-table? (v:as g))
+      (layer-own! (v:as g) vertex copy-table)
+      (get-v:as g vertex)))
+
+(define-method (own-e:as (g <graph>) (edge <list>))
+  (if (layered-table? (e:as g))
+      (layer-own! (e:as g) edge copy-table)
+      (get-e:as g edge)))
+
 ;;; insert into the graph hashtable
 (define-method (set-v:es! (g <graph>) vertex (lst <list>))
   (hash-vertex-insert! (v:es g) vertex lst))
@@ -162,7 +178,7 @@
   (hash-vertex-insert! (v:as g) vertex table))
 
 (define-method (set-v:atribute! (g <graph>) vertex (key <keyword>) val)
-  (define as (get-v:as g vertex))
+  (define as (own-v:as g vertex))
   (when as (hash-atribute-insert! as key val)))
 
 (define-method (set-e:as! (g <undirected-graph>) (edge <list>) table)
@@ -172,11 +188,11 @@
   (hash-arrow-insert! (e:as g) arrow table))
 
 (define-method (set-e:atribute! (g <undirected-graph>) (edge <list>) (key <keyword>) val)
-  (define as (get-e:as g edge))
+  (define as (own-e:as g edge))
   (when as (hash-atribute-insert! as key val)))
 
 (define-method (set-e:atribute! (g <directed-graph>) (arrow <list>) (key <keyword>) val)
-  (define as (get-e:as g arrow))
+  (define as (own-e:as g arrow))
   (when as (hash-atribute-insert! as key val)))
 
 ;;; remove from the graph hashtable
@@ -195,7 +211,7 @@
   (hash-vertex-delete! (v:as g) vertex))
 
 (define-method (del-v:atribute! (g <graph>) vertex (key <keyword>))
-  (define as (get-v:as g vertex))
+  (define as (own-v:as g vertex))
   (when as (hash-atribute-delete! as key)))
 
 (define-method (del-e:as! (g <undirected-graph>) (edge <list>))
@@ -205,11 +221,11 @@
   (hash-arrow-delete! (e:as g) arrow))
 
 (define-method (del-e:atribute! (g <undirected-graph>) (edge <list>) (key <keyword>))
-  (define as (get-e:as g edge))
+  (define as (own-e:as g edge))
   (when as (hash-atribute-delete! as key)))
 
 (define-method (del-e:atribute! (g <directed-graph>) (arrow <list>) (key <keyword>))
-  (define as (get-e:as g arrow))
+  (define as (own-e:as g arrow))
   (when as (hash-atribute-delete! as key)))
 
 ;;; 
@@ -361,6 +377,68 @@
 (define-method (remove-vertices! (g <directed-graph>) (lst <list>))
   (for-each (λ (v) (remove-vertex! g v)) lst))
 
+;;; Removes every vertex and edge at once by replacing the tables
+(define-method (clear-graph! (g <graph>))
+  (slot-set! g 'vertex:edges     (make-hash-table))
+  (slot-set! g 'vertex:atributes (make-hash-table))
+  (slot-set! g 'edge:atributes   (make-hash-table))
+  #true)
+
+;;; Fills an empty graph from s32vectors of vertices and of edge ends, as
+;;; read from a document. The tables are written directly: the edges are
+;;; known to be distinct and their vertices to be in ids.
+(define-method (load-edge! (g <undirected-graph>) u v)
+  (define edge (list u v))
+  (set-e:as! g edge (make-hash-table))
+  (set-v:es! g u (cons edge (get-v:es g u)))
+  (set-v:es! g v (cons edge (get-v:es g v))))
+
+(define-method (load-edge! (g <directed-graph>) u v)
+  (define arrow (list u v))
+  (set-e:as! g arrow (make-hash-table))
+  (set-v:es! g u (cons arrow (get-v:es g u))))
+
+(define-method (load-graph! (g <graph>) ids sources targets)
+  (do ((i 0 (+ i 1))) ((= i (s32vector-length ids)))
+    (set-v:es! g (s32vector-ref ids i) '())
+    (set-v:as! g (s32vector-ref ids i) (make-hash-table)))
+  (do ((i 0 (+ i 1))) ((= i (s32vector-length sources)))
+    (load-edge! g (s32vector-ref sources i) (s32vector-ref targets i)))
+  #true)
+
+;;; Snapshots
+;;;
+;;; (graph-snapshot g) returns a graph with the vertices, edges and atributes
+;;; that g has now without copying them. The tables of g are frozen as the
+;;; base of two new layers, one for g and one for the snapshot, and later
+;;; changes on either graph go to its own layer. Atribute tables are copied
+;;; the first time one of the graphs writes them. Once g has max-layers
+;;; layers they are merged before the next snapshot.
+(define max-layers 8)
+
+(define-method (snapshot-class (g <undirected-graph>)) <undirected-graph>)
+(define-method (snapshot-class (g <directed-graph>))   <directed-graph>)
+
+(define-method (edge-table-procedures (g <undirected-graph>))
+  (list hash-edge-lookup hash-edge-insert!))
+
+(define-method (edge-table-procedures (g <directed-graph>))
+  (list hash-arrow-lookup hash-arrow-insert!))
+
+(define-method (graph-snapshot (g <graph>))
+  (define s (make (snapshot-class g)))
+  (define (split! slot lookup insert!)
+    (define table (slot-ref g slot))
+    (define frozen (if (>= (table-depth table) max-layers)
+		       (flatten-layers table)
+		       table))
+    (slot-set! g slot (make-layer frozen lookup insert!))
+    (slot-set! s slot (make-layer frozen lookup insert!)))
+  (split! 'vertex:edges     hash-vertex-lookup hash-vertex-insert!)
+  (split! 'vertex:atributes hash-vertex-lookup hash-vertex-insert!)
+  (apply split! 'edge:atributes (edge-table-procedures g))
+  s)
+
 (define-method (add-edge! (g <undirected-graph>) (edge <list>))
   (define u (from edge))
   (define v (to edge))
@@ -33,7 +33,14 @@
 	    hash-atribute-lookup
 	    hash-atribute-insert!
 	    hash-atribute-delete!
-	    set-equal?))
+	    set-equal?
+	    <layered-table>
+	    layered-table?
+	    make-layer
+	    table-depth
+	    layer-own!
+	    flatten-layers
+	    copy-table))
 
 ;;; Module for the hashtable related procedures
 ;;;
@@ -138,3 +145,129 @@
 
 (define-method (hash-atribute-delete! (h <hashtable>) k)
   (hash-delete! h k))
+
+;;; Layered tables
+;;;
+;;; A layered table is a hashtable on top of a base table that is never
+;;; written again. Lookups fall through to the base and deletions leave a
+;;; mark in the top layer, so two layers over the same base see the same
+;;; entries until they change them. A layer keeps the lookup and insert
+;;; procedures of the kind of keys it holds.
+(define deleted (list 'deleted))
+
+(define-class <layered-table> ()
+  (local  #:init-thunk make-hash-table #:getter layer-local)
+  (base   #:init-keyword #:base        #:getter layer-base)
+  (depth  #:init-keyword #:depth       #:getter layer-depth)
+  (lookup #:init-keyword #:lookup      #:getter layer-lookup)
+  (insert #:init-keyword #:insert      #:getter layer-insert))
+
+(define (layered-table? obj)
+  (is-a? obj <layered-table>))
+
+(define (table-depth table)
+  (if (layered-table? table) (layer-depth table) 0))
+
+(define (make-layer base lookup insert!)
+  (make <layered-table>
+    #:base   base
+    #:depth  (+ 1 (table-depth base))
+    #:lookup lookup
+    #:insert insert!))
+
+(define (layered-handle h k)
+  (define handle ((layer-lookup h) (layer-local h) k))
+  (cond (handle
+	 (if (eq? (value handle) deleted) #false handle))
+	((layered-table? (layer-base h))
+	 (layered-handle (layer-base h) k))
+	(else
+	 ((layer-lookup h) (layer-base h) k))))
+
+(define (layered-tuples h)
+  (define lookup  (layer-lookup h))
+  (define insert! (layer-insert h))
+  (define seen (make-hash-table))
+  (define (visible tuples acc)
+    (fold (λ (tuple acc)
+	    (cond ((lookup seen (key tuple))
+		   acc)
+		  (else
+		   (insert! seen (key tuple) #true)
+		   (if (eq? (value tuple) deleted) acc (cons tuple acc)))))
+	  acc
+	  tuples))
+  (let loop ((table h) (acc '()))
+    (if (layered-table? table)
+	(loop (layer-base table) (visible (hash-tuples (layer-local table)) acc))
+	(visible (hash-tuples table) acc))))
+
+(define-method (hash-keys (h <layered-table>))
+  (map key (layered-tuples h)))
+
+(define-method (hash-values (h <layered-table>))
+  (map value (layered-tuples h)))
+
+(define-method (hash-tuples (h <layered-table>))
+  (layered-tuples h))
+
+(define-method (hash-lookup (h <layered-table>) k)
+  (layered-handle h k))
+
+(define-method (hash-insert! (h <layered-table>) k v)
+  ((layer-insert h) (layer-local h) k v))
+
+(define-method (hash-delete! (h <layered-table>) k)
+  ((layer-insert h) (layer-local h) k deleted))
+
+(define-method (hash-vertex-lookup (h <layered-table>) k)
+  (hash-lookup h k))
+
+(define-method (hash-vertex-insert! (h <layered-table>) k v)
+  (hash-insert! h k v))
+
+(define-method (hash-vertex-delete! (h <layered-table>) k)
+  (hash-delete! h k))
+
+(define-method (hash-edge-lookup (h <layered-table>) k)
+  (hash-lookup h k))
+
+(define-method (hash-edge-insert! (h <layered-table>) k v)
+  (hash-insert! h k v))
+
+(define-method (hash-edge-delete! (h <layered-table>) k)
+  (hash-delete! h k))
+
+(define-method (hash-arrow-lookup (h <layered-table>) k)
+  (hash-lookup h k))
+
+(define-method (hash-arrow-insert! (h <layered-table>) k v)
+  (hash-insert! h k v))
+
+(define-method (hash-arrow-delete! (h <layered-table>) k)
+  (hash-delete! h k))
+
+;;; Value of k that the owner of h may modify. A value found below the top
+;;; layer is shared with other layers, a copy goes to the top layer first.
+(define (layer-own! h k copy)
+  (define handle ((layer-lookup h) (layer-local h) k))
+  (cond (handle
+	 (if (eq? (value handle) deleted) #false (value handle)))
+	((layered-handle h k)
+	 => (λ (below)
+	      (let ((v (copy (value below))))
+		((layer-insert h) (layer-local h) k v)
+		v)))
+	(else #false)))
+
+;;; Plain table with the visible entries of a layered table
+(define (flatten-layers h)
+  (define table (make-hash-table))
+  (for-each (λ (tuple) ((layer-insert h) table (key tuple) (value tuple)))
+	    (layered-tuples h))
+  table)
+
+(define (copy-table h)
+  (define h* (make-hash-table))
+  (hash-for-each (λ (k v) (hash-set! h* k v)) h)
+  h*)
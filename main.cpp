@@ -1,8 +1,17 @@
 #include "VisMainWindow.hpp"
+#include "VisBatch.hpp"
 #include <QApplication>
+#include <QCoreApplication>
 
 int main(int argc, char *argv[])
 {
+    // Sin ventana ni escena cuando solo se resuelven archivos
+    if(VisBatch::requested(argc, argv)){
+        QCoreApplication a(argc, argv);
+        VisBatch batch;
+        return batch.run(a.arguments());
+    }
+
     QApplication a(argc, argv);
     VisMainWindow w;
     w.show();